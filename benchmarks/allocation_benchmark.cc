@@ -0,0 +1,201 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/string_split.h"
+#include "util/string_util.h"
+
+// Every allocation of the process goes through here, so a run can tell how
+// many allocations a call makes.
+static size_t g_allocations = 0;
+
+void* operator new(size_t size)
+{
+  ++g_allocations;
+  void* p = malloc(size);
+  if (p == NULL)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+// Runs |func| once to count its allocations, then times it.
+template <typename Func>
+static void RunCounted(const std::string& name, size_t bytes_per_call,
+                       Func func)
+{
+  const size_t before = g_allocations;
+  benchmark::DoNotOptimize(func());
+  const size_t allocations = g_allocations - before;
+  char label[64];
+  snprintf(label, sizeof(label), "%s [%zu alloc]", name.c_str(), allocations);
+  benchmark::Run(label, bytes_per_call, func);
+}
+
+int main()
+{
+  // Each call gets a fresh string, as if just read from a file or socket,
+  // that the caller has no further use for.  The copying form keeps it and
+  // fills a new output; the rvalue and in-place forms reuse it.
+  std::string line;
+  while (line.size() < 256)
+    line += "  Name = Value;\tOther,Thing  ";
+
+  RunCounted("TrimWhitespaceASCII/copy", line.size(), [&]() {
+      std::string input = line;
+      std::string output;
+      util::TrimWhitespaceASCII(input, util::TRIM_ALL, &output);
+      return output.size();
+    });
+  RunCounted("TrimWhitespaceASCII/rvalue", line.size(), [&]() {
+      std::string input = line;
+      std::string output;
+      util::TrimWhitespaceASCII(std::move(input), util::TRIM_ALL, &output);
+      return output.size();
+    });
+  RunCounted("ReplaceChars/copy", line.size(), [&]() {
+      std::string input = line;
+      std::string output;
+      util::ReplaceChars(input, ";,", " ", &output);
+      return output.size();
+    });
+  RunCounted("ReplaceChars/in-place", line.size(), [&]() {
+      std::string input = line;
+      util::ReplaceChars(&input, ";,", " ");
+      return input.size();
+    });
+  RunCounted("RemoveChars/copy", line.size(), [&]() {
+      std::string input = line;
+      std::string output;
+      util::RemoveChars(input, " \t", &output);
+      return output.size();
+    });
+  RunCounted("RemoveChars/rvalue", line.size(), [&]() {
+      std::string input = line;
+      std::string output;
+      util::RemoveChars(std::move(input), " \t", &output);
+      return output.size();
+    });
+  RunCounted("StringToLowerASCII/copy", line.size(), [&]() {
+      std::string input = line;
+      return util::StringToLowerASCII(input).size();
+    });
+  RunCounted("StringToLowerASCII/rvalue", line.size(), [&]() {
+      std::string input = line;
+      return util::StringToLowerASCII(std::move(input)).size();
+    });
+  RunCounted("CollapseWhitespaceASCII/copy", line.size(), [&]() {
+      std::string input = line;
+      return util::CollapseWhitespaceASCII(input, false).size();
+    });
+  RunCounted("CollapseWhitespaceASCII/rvalue", line.size(), [&]() {
+      std::string input = line;
+      return util::CollapseWhitespaceASCII(std::move(input), false).size();
+    });
+  RunCounted("Reverse/copy", line.size(), [&]() {
+      std::string input = line;
+      std::string output;
+      util::Reverse(input, &output, 1);
+      return output.size();
+    });
+  RunCounted("Reverse/rvalue", line.size(), [&]() {
+      std::string input = line;
+      std::string output;
+      util::Reverse(std::move(input), &output, 1);
+      return output.size();
+    });
+
+  // The text form of an IPv6 address is too long for the short string
+  // optimization; HexStringToIp() now formats it on the stack and reuses
+  // the caller's string.
+  const std::string hex = "20 01 0D B8 00 00 00 00 00 00 00 00 00 00 00 01";
+  std::string ip;
+  RunCounted("HexStringToIp/ipv6", hex.size(), [&]() {
+      util::HexStringToIp(hex, &ip);
+      return ip.size();
+    });
+
+  // A header of "key=value" pairs and a query string, parsed per request
+  // into containers that earlier requests have already grown.  The copying
+  // form still allocates the keys and values that do not fit in a short
+  // string; the zero-copy forms allocate nothing.
+  const std::string header =
+      "session=4f2a9c1e7b3d5a8f; theme=dark; lang=en-US; tz=Europe/Paris; "
+      "tracking_consent=granted; last_visit=2014-05-17T10:22:31Z";
+  std::vector<std::pair<std::string, std::string> > pairs;
+  util::SplitStringIntoKeyValuePairs(header, '=', ';', &pairs);
+  RunCounted("SplitStringIntoKeyValuePairs", header.size(), [&]() {
+      util::SplitStringIntoKeyValuePairs(header, '=', ';', &pairs);
+      return pairs.size();
+    });
+  std::vector<std::pair<util::StringPiece, util::StringPiece> > pieces;
+  util::SplitStringPieceIntoKeyValuePairs(header, '=', ';', &pieces);
+  RunCounted("SplitStringPieceIntoKeyValuePairs/vector", header.size(),
+             [&]() {
+      util::SplitStringPieceIntoKeyValuePairs(header, '=', ';', &pieces);
+      return pieces.size();
+    });
+  util::KeyValueMap map;
+  util::SplitStringPieceIntoKeyValuePairs(header, '=', ';', &map);
+  RunCounted("SplitStringPieceIntoKeyValuePairs/map", header.size(), [&]() {
+      util::SplitStringPieceIntoKeyValuePairs(header, '=', ';', &map);
+      return map.size();
+    });
+
+  const std::string query =
+      "q=percent+encoding%21&lang=en&page=2&sort=date%3Adesc&"
+      "filter=type%3Dpdf%26size%3E1mb&session=4f2a9c1e7b3d5a8f";
+  RunCounted("Query string/split and UnescapePercent", query.size(), [&]() {
+      std::vector<std::string> params;
+      util::SplitStringDontTrim(query, '&', &params);
+      std::string key;
+      std::string value;
+      size_t length = 0;
+      for (size_t i = 0; i < params.size(); ++i)
+      {
+        const size_t equals = params[i].find('=');
+        key.clear();
+        value.clear();
+        util::UnescapePercent(params[i].substr(0, equals), &key, true);
+        if (equals != std::string::npos)
+          util::UnescapePercent(params[i].substr(equals + 1), &value, true);
+        length += key.size() + value.size();
+      }
+      return length;
+    });
+  std::string buffer = query;
+  RunCounted("Query string/ParseQueryString", query.size(), [&]() {
+      // The request buffer, which the parameters are decoded into.
+      buffer.assign(query);
+      util::ParseQueryString(&buffer, &map);
+      return map.size();
+    });
+  return 0;
+}
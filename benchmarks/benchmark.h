@@ -0,0 +1,85 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#ifndef UTIL_BENCHMARKS_BENCHMARK_H_
+#define UTIL_BENCHMARKS_BENCHMARK_H_
+
+#include <stdio.h>
+
+#include <chrono>
+#include <string>
+
+#include "util/cpu.h"
+
+namespace benchmark
+{
+  // Keeps the compiler from optimizing away the computation of |value|.
+  template <typename T>
+      inline void DoNotOptimize(const T& value)
+  {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  // Calls |func| in a loop, doubling the iteration count until a run takes
+  // long enough to be measured, and prints the time per call.  When
+  // |bytes_per_call| is not 0 the throughput is printed as well.
+  template <typename Func>
+      void Run(const std::string& name, size_t bytes_per_call, Func func)
+  {
+    typedef std::chrono::steady_clock Clock;
+    const double kMinSeconds = 0.2;
+
+    double seconds = 0;
+    size_t iterations = 1;
+    for (;;)
+    {
+      const Clock::time_point start = Clock::now();
+      for (size_t i = 0; i < iterations; ++i)
+        DoNotOptimize(func());
+      seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      if (seconds >= kMinSeconds)
+        break;
+      iterations *= 2;
+    }
+
+    const double ns_per_call = seconds * 1e9 / iterations;
+    if (bytes_per_call == 0)
+    {
+      printf("%-48s %12.1f ns\n", name.c_str(), ns_per_call);
+    }
+    else
+    {
+      printf("%-48s %12.1f ns %10.2f GB/s\n", name.c_str(), ns_per_call,
+             bytes_per_call * iterations / seconds / 1e9);
+    }
+  }
+
+  // Names of the code paths selected by util::SetCPUFeatureMaskForTesting().
+  struct CPUPath
+  {
+    const char* name;
+    int mask;
+  };
+
+  static const CPUPath kCPUPaths[] = {
+    { "sse2", 0 },
+    { "sse4.2", util::CPU_SSE42 },
+    { "avx2", util::CPU_FEATURES_ALL },
+  };
+
+}; // namespace benchmark
+
+#endif // UTIL_BENCHMARKS_BENCHMARK_H_
@@ -0,0 +1,76 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include <string>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/cpu.h"
+#include "util/string_util.h"
+
+// The character at a time loop StringToLowerASCII used to be.
+static void StringToLowerASCIIPerChar(std::string* s)
+{
+  for (std::string::iterator i = s->begin(); i != s->end(); ++i)
+    *i = util::ToLowerASCII(*i);
+}
+
+int main()
+{
+  static const size_t kSizes[] = { 16, 64, 1024, 64 * 1024 };
+
+  for (size_t s = 0; s < sizeof(kSizes) / sizeof(kSizes[0]); ++s)
+  {
+    const size_t size = kSizes[s];
+    std::string input;
+    while (input.size() < size)
+      input += "Content-Type: Text/HTML; Charset=UTF-8\r\n";
+    input.resize(size);
+    std::string lower = input;
+    StringToLowerASCIIPerChar(&lower);
+    std::string work = input;
+
+    const std::string n = std::to_string(size) + " bytes";
+
+    benchmark::Run("StringToLowerASCII per char/" + n, size, [&]() {
+        work = input;
+        StringToLowerASCIIPerChar(&work);
+        return work.data()[0];
+      });
+
+    for (size_t p = 0; p < arraysize(benchmark::kCPUPaths); ++p)
+    {
+      const benchmark::CPUPath& path = benchmark::kCPUPaths[p];
+      util::SetCPUFeatureMaskForTesting(path.mask);
+      const std::string tag = std::string(path.name) + "/" + n;
+
+      benchmark::Run("StringToLowerASCII " + tag, size, [&]() {
+          work = input;
+          util::StringToLowerASCII(&work);
+          return work.data()[0];
+        });
+      benchmark::Run("LowerCaseEqualsASCII " + tag, size, [&]() {
+          return util::LowerCaseEqualsASCII(input, lower.c_str());
+        });
+      benchmark::Run("EndsWith case-insensitive " + tag, size, [&]() {
+          return util::EndsWith(input, lower, false);
+        });
+    }
+    util::SetCPUFeatureMaskForTesting(util::CPU_FEATURES_ALL);
+  }
+
+  return 0;
+}
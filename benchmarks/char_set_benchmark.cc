@@ -0,0 +1,82 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/char_set.h"
+#include "util/cpu.h"
+#include "util/string_util.h"
+
+// The loop ContainsOnlyChars used to be: a scan of |characters| per byte.
+static bool ContainsOnlyCharsPerChar(const std::string& input,
+                                     const std::string& characters)
+{
+  for (std::string::const_iterator i = input.begin(); i != input.end(); ++i)
+  {
+    if (characters.find(*i) == std::string::npos)
+      return false;
+  }
+  return true;
+}
+
+int main()
+{
+  static const size_t kSize = 16 * 1024;
+  static const std::string kHexChars = "0123456789abcdefABCDEF";
+  static const std::string kDelimiters = " \t,;|";
+
+  std::string hex;
+  while (hex.size() < kSize)
+    hex += "0123456789abcdef";
+  std::string fields;
+  while (fields.size() < kSize)
+    fields += "alpha,beta;gamma delta|epsilon\t";
+  const std::string long_field(kSize, 'x');
+
+  const util::CharSet hex_set(kHexChars);
+  const util::CharSet delimiters(kDelimiters);
+  std::vector<std::string> tokens;
+
+  benchmark::Run("ContainsOnlyChars per char", kSize, [&]() {
+      return ContainsOnlyCharsPerChar(hex, kHexChars);
+    });
+  benchmark::Run("std::string::find_first_of", kSize, [&]() {
+      return long_field.find_first_of(kDelimiters);
+    });
+
+  for (size_t p = 0; p < arraysize(benchmark::kCPUPaths); ++p)
+  {
+    const benchmark::CPUPath& path = benchmark::kCPUPaths[p];
+    util::SetCPUFeatureMaskForTesting(path.mask);
+    const std::string tag = std::string(" ") + path.name;
+
+    benchmark::Run("ContainsOnlyChars CharSet" + tag, kSize, [&]() {
+        return util::ContainsOnlyChars(hex, hex_set);
+      });
+    benchmark::Run("CharSet::FindFirstOf" + tag, kSize, [&]() {
+        return delimiters.FindFirstOf(long_field);
+      });
+    benchmark::Run("Tokenize CharSet" + tag, kSize, [&]() {
+        return util::Tokenize(fields, delimiters, &tokens);
+      });
+  }
+  util::SetCPUFeatureMaskForTesting(util::CPU_FEATURES_ALL);
+
+  return 0;
+}
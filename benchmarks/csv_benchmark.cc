@@ -0,0 +1,118 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/cpu.h"
+#include "util/csv_reader.h"
+#include "util/string_piece.h"
+#include "util/string_split.h"
+#include "util/string_tokenizer.h"
+
+int main()
+{
+  static const size_t kRows = 16384;
+  static const size_t kChunkSize = 64 * 1024;
+
+  // Rows of numbers, names and quoted comments, some of them with commas,
+  // escaped quotes or line breaks.
+  srand(48);
+  std::string text;
+  for (size_t r = 0; r < kRows; ++r)
+  {
+    text += std::to_string(r) + ',' + std::to_string(rand() % 100000) + ',';
+    text.append(8 + rand() % 16, static_cast<char>('a' + rand() % 26));
+    text += ",\"";
+    text.append(16 + rand() % 48, static_cast<char>('a' + rand() % 26));
+    switch (rand() % 8)
+    {
+      case 0: text += ", more"; break;
+      case 1: text += " \"\"quoted\"\""; break;
+      case 2: text += "\r\nnext line"; break;
+    }
+    text += "\"\r\n";
+  }
+
+  util::CSVRow row;
+  for (size_t p = 0; p < arraysize(benchmark::kCPUPaths); ++p)
+  {
+    const benchmark::CPUPath& path = benchmark::kCPUPaths[p];
+    util::SetCPUFeatureMaskForTesting(path.mask);
+    const std::string tag = std::string(" ") + path.name;
+
+    benchmark::Run("CSVReader buffer" + tag, text.size(), [&]() {
+        util::CSVReader reader;
+        reader.Append(text);
+        reader.Finish();
+        size_t fields = 0;
+        while (reader.NextRow(&row))
+          fields += row.size();
+        return fields;
+      });
+    benchmark::Run("CSVReader 64k chunks" + tag, text.size(), [&]() {
+        util::CSVReader reader;
+        size_t fields = 0;
+        for (size_t pos = 0; pos < text.size(); pos += kChunkSize)
+        {
+          reader.Append(util::StringPiece(text).substr(pos, kChunkSize));
+          while (reader.NextRow(&row))
+            fields += row.size();
+        }
+        reader.Finish();
+        while (reader.NextRow(&row))
+          fields += row.size();
+        return fields;
+      });
+  }
+  util::SetCPUFeatureMaskForTesting(util::CPU_FEATURES_ALL);
+
+  // The quote-aware tokenizer libutil had, which walks char by char: rows
+  // then fields, with the line breaks in quotes left to it.
+  benchmark::Run("StringTokenizer quotes", text.size(), [&]() {
+      size_t fields = 0;
+      util::StringTokenizer lines(text, "\n");
+      lines.set_quote_chars("\"");
+      while (lines.GetNext())
+      {
+        util::StringTokenizer t(lines.token_begin(), lines.token_end(), ",");
+        t.set_quote_chars("\"");
+        t.set_options(util::StringTokenizer::RETURN_DELIMS);
+        while (t.GetNext())
+          fields += !t.token_is_delim();
+      }
+      return fields;
+    });
+  // No quote handling at all, for reference.
+  std::vector<util::StringPiece> lines;
+  std::vector<util::StringPiece> fields;
+  benchmark::Run("SplitStringPiece no quotes", text.size(), [&]() {
+      size_t count = 0;
+      util::SplitStringPieceDontTrim(text, '\n', &lines);
+      for (size_t l = 0; l < lines.size(); ++l)
+      {
+        util::SplitStringPieceDontTrim(lines[l], ',', &fields);
+        count += fields.size();
+      }
+      return count;
+    });
+  return 0;
+}
@@ -0,0 +1,104 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/string_number_conversions.h"
+#include "util/string_util.h"
+
+// Textbook dynamic programming distance, one cell at a time.
+static size_t DynamicProgrammingEditDistance(const std::string& a,
+                                             const std::string& b)
+{
+  std::vector<size_t> row(b.length() + 1);
+  for (size_t j = 0; j <= b.length(); ++j)
+    row[j] = j;
+  for (size_t i = 1; i <= a.length(); ++i)
+  {
+    size_t diagonal = row[0];
+    row[0] = i;
+    for (size_t j = 1; j <= b.length(); ++j)
+    {
+      const size_t substitute = diagonal + (a[i - 1] != b[j - 1]);
+      diagonal = row[j];
+      row[j] = std::min(substitute, std::min(row[j], row[j - 1]) + 1);
+    }
+  }
+  return row[b.length()];
+}
+
+static std::string RandomMessage(size_t length)
+{
+  static const char kChars[] = "abcdefghijklmnopqrstuvwxyz0123456789 :";
+  std::string message;
+  for (size_t i = 0; i < length; ++i)
+    message += kChars[rand() % (sizeof(kChars) - 1)];
+  return message;
+}
+
+int main()
+{
+  static const size_t kLengths[] = { 16, 64, 256, 1024 };
+
+  srand(2014);
+  for (size_t l = 0; l < arraysize(kLengths); ++l)
+  {
+    const std::string a = RandomMessage(kLengths[l]);
+    std::string b = a;
+    for (size_t i = 0; i < b.length(); i += 8)
+      b[i] = 'X';
+    const std::string n = "/" + util::ToString(kLengths[l]);
+
+    benchmark::Run("dynamic programming" + n, 0, [&]() {
+        return DynamicProgrammingEditDistance(a, b);
+      });
+    benchmark::Run("EditDistance" + n, 0, [&]() {
+        return util::EditDistance(a, b);
+      });
+    benchmark::Run("BoundedEditDistance max 4" + n, 0, [&]() {
+        return util::BoundedEditDistance(a, b, 4);
+      });
+  }
+
+  // Deduplicating log messages: one query against many similar lines.
+  std::vector<std::string> messages;
+  const std::string query = RandomMessage(60);
+  for (int i = 0; i < 200000; ++i)
+  {
+    std::string message = query;
+    for (int e = 0; e < 3; ++e)
+      message[rand() % message.length()] = 'a' + rand() % 26;
+    messages.push_back(message);
+  }
+  std::vector<size_t> matches;
+  static const size_t kThreads[] = { 1, 0 };
+  for (size_t t = 0; t < arraysize(kThreads); ++t)
+  {
+    benchmark::Run("FindWithinEditDistance 200000 lines/threads " +
+                   util::ToString(kThreads[t]), 0, [&]() {
+        return util::FindWithinEditDistance(query, messages, 2, &matches,
+                                            kThreads[t]);
+      });
+  }
+
+  return 0;
+}
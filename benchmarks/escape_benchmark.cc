@@ -0,0 +1,129 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include <string>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/cpu.h"
+#include "util/string_util.h"
+
+// The usual byte at a time escaper, for comparison.
+static void EscapeJSONStringBytewise(const std::string& input,
+                                     std::string* output)
+{
+  static const char kHex[] = "0123456789ABCDEF";
+  for (size_t i = 0; i < input.size(); ++i)
+  {
+    const unsigned char c = input[i];
+    switch (c)
+    {
+      case '"': *output += "\\\""; break;
+      case '\\': *output += "\\\\"; break;
+      case '\b': *output += "\\b"; break;
+      case '\f': *output += "\\f"; break;
+      case '\n': *output += "\\n"; break;
+      case '\r': *output += "\\r"; break;
+      case '\t': *output += "\\t"; break;
+      default:
+        if (c < 0x20)
+        {
+          *output += "\\u00";
+          *output += kHex[c >> 4];
+          *output += kHex[c & 0x0F];
+        }
+        else
+        {
+          *output += static_cast<char>(c);
+        }
+    }
+  }
+}
+
+int main()
+{
+  static const size_t kTextSize = 16 * 1024;
+
+  // Prose with an escape every few dozen bytes, and dense key/value text.
+  static const char* const kLines[] = {
+    "The quick brown fox jumps over the lazy dog, \"twice\" a day.\n",
+    "k=v&a b=\"c\"\t\\x\n",
+  };
+  static const char* const kNames[] = { "sparse", "dense" };
+
+  for (size_t l = 0; l < arraysize(kLines); ++l)
+  {
+    std::string text;
+    while (text.size() < kTextSize)
+      text += kLines[l];
+    std::string escaped_c;
+    std::string escaped_json;
+    std::string escaped_percent;
+    util::EscapeC(text, &escaped_c);
+    util::EscapeJSONString(text, &escaped_json);
+    util::EscapePercent(text, &escaped_percent);
+    std::string work;
+
+    benchmark::Run(std::string("EscapeJSONStringBytewise/") + kNames[l],
+                   text.size(), [&]() {
+        work.clear();
+        EscapeJSONStringBytewise(text, &work);
+        return work.size();
+      });
+
+    for (size_t p = 0; p < arraysize(benchmark::kCPUPaths); ++p)
+    {
+      const benchmark::CPUPath& path = benchmark::kCPUPaths[p];
+      util::SetCPUFeatureMaskForTesting(path.mask);
+      const std::string tag =
+          std::string(" ") + path.name + "/" + kNames[l];
+
+      benchmark::Run("EscapeC" + tag, text.size(), [&]() {
+          work.clear();
+          util::EscapeC(text, &work);
+          return work.size();
+        });
+      benchmark::Run("EscapeJSONString" + tag, text.size(), [&]() {
+          work.clear();
+          util::EscapeJSONString(text, &work);
+          return work.size();
+        });
+      benchmark::Run("EscapePercent" + tag, text.size(), [&]() {
+          work.clear();
+          util::EscapePercent(text, &work);
+          return work.size();
+        });
+      benchmark::Run("UnescapeC" + tag, escaped_c.size(), [&]() {
+          work.clear();
+          util::UnescapeC(escaped_c, &work);
+          return work.size();
+        });
+      benchmark::Run("UnescapeJSONString" + tag, escaped_json.size(), [&]() {
+          work.clear();
+          util::UnescapeJSONString(escaped_json, &work);
+          return work.size();
+        });
+      benchmark::Run("UnescapePercent" + tag, escaped_percent.size(), [&]() {
+          work.clear();
+          util::UnescapePercent(escaped_percent, &work);
+          return work.size();
+        });
+    }
+    util::SetCPUFeatureMaskForTesting(util::CPU_FEATURES_ALL);
+  }
+
+  return 0;
+}
@@ -0,0 +1,102 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/cpu.h"
+#include "util/string_util.h"
+
+int main()
+{
+  static const size_t kTextSize = 64 * 1024;
+  static const size_t kSearchLengths[] = { 2, 4, 8, 16, 32, 64 };
+
+  // Log-like text.  Needles start with a byte that is common in the text,
+  // and only occur at the very end.
+  std::string text;
+  while (text.size() < kTextSize)
+    text += "2014-04-27 12:00:01 INFO request GET /index.html took 12ms\n";
+
+  for (size_t l = 0; l < arraysize(kSearchLengths); ++l)
+  {
+    const size_t length = kSearchLengths[l];
+    const std::string search = std::string("eZ0123456789abcdefghijklmnopqrst"
+                                           "uvwxyz0123456789ABCDEFGHIJKLMNO")
+        .substr(0, length);
+    const std::string haystack = text + search;
+    const std::string upper_search = util::StringToUpperASCII(search);
+    const std::string n = "/" + std::to_string(length);
+
+    benchmark::Run("std::string::find" + n, haystack.size(), [&]() {
+        return haystack.find(search);
+      });
+    benchmark::Run("memmem" + n, haystack.size(), [&]() {
+        return memmem(haystack.data(), haystack.size(),
+                      search.data(), search.size());
+      });
+
+    for (size_t p = 0; p < arraysize(benchmark::kCPUPaths); ++p)
+    {
+      const benchmark::CPUPath& path = benchmark::kCPUPaths[p];
+      util::SetCPUFeatureMaskForTesting(path.mask);
+      const std::string tag = std::string(" ") + path.name + n;
+
+      benchmark::Run("Find" + tag, haystack.size(), [&]() {
+          return util::Find(haystack, search, 0, true);
+        });
+      benchmark::Run("Find case-insensitive" + tag, haystack.size(), [&]() {
+          return util::Find(haystack, upper_search, 0, false);
+        });
+
+      const util::StringSearcher searcher(search, true);
+      benchmark::Run("StringSearcher" + tag, haystack.size(), [&]() {
+          return searcher.Find(haystack, 0);
+        });
+      const util::StringSearcher folded(upper_search, false);
+      benchmark::Run("StringSearcher case-insensitive" + tag, haystack.size(),
+                     [&]() {
+          return folded.Find(haystack, 0);
+        });
+    }
+    util::SetCPUFeatureMaskForTesting(util::CPU_FEATURES_ALL);
+  }
+
+  // A needle found on every line, where the cost of each call counts.
+  std::vector<size_t> positions;
+  for (size_t p = 0; p < arraysize(benchmark::kCPUPaths); ++p)
+  {
+    const benchmark::CPUPath& path = benchmark::kCPUPaths[p];
+    util::SetCPUFeatureMaskForTesting(path.mask);
+    const std::string tag = std::string(" ") + path.name;
+
+    benchmark::Run("FindAll case-insensitive" + tag, text.size(), [&]() {
+        return util::FindAll(text, "TOOK", false, &positions);
+      });
+    const util::StringSearcher took("TOOK", false);
+    benchmark::Run("StringSearcher::FindAll case-insensitive" + tag,
+                   text.size(), [&]() {
+        return took.FindAll(text, &positions);
+      });
+  }
+  util::SetCPUFeatureMaskForTesting(util::CPU_FEATURES_ALL);
+
+  return 0;
+}
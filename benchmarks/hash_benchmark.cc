@@ -0,0 +1,68 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/hash.h"
+#include "util/string_number_conversions.h"
+
+int main()
+{
+  static const size_t kLengths[] = { 4, 8, 16, 32, 64, 256, 4096 };
+
+  for (size_t l = 0; l < arraysize(kLengths); ++l)
+  {
+    const std::string str(kLengths[l], 'x');
+    const std::string n = "/" + util::ToString(kLengths[l]);
+
+    benchmark::Run("std::hash" + n, str.size(), [&]() {
+        return std::hash<std::string>()(str);
+      });
+    benchmark::Run("Hash64" + n, str.size(), [&]() {
+        return util::Hash64(str);
+      });
+    benchmark::Run("Hash64IgnoringCaseASCII" + n, str.size(), [&]() {
+        return util::Hash64IgnoringCaseASCII(str);
+      });
+  }
+
+  // Counting split tokens, the motivating use.
+  std::vector<std::string> tokens;
+  for (int i = 0; i < 10000; ++i)
+    tokens.push_back("token-" + util::ToString(i % 2000));
+
+  std::unordered_map<std::string, int> std_counts;
+  benchmark::Run("unordered_map std::hash/10000 tokens", 0, [&]() {
+      std_counts.clear();
+      for (size_t i = 0; i < tokens.size(); ++i)
+        ++std_counts[tokens[i]];
+      return std_counts.size();
+    });
+  std::unordered_map<std::string, int, util::StringHash> counts;
+  benchmark::Run("unordered_map StringHash/10000 tokens", 0, [&]() {
+      counts.clear();
+      for (size_t i = 0; i < tokens.size(); ++i)
+        ++counts[tokens[i]];
+      return counts.size();
+    });
+
+  return 0;
+}
@@ -0,0 +1,113 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/ip_address.h"
+
+int main()
+{
+  static const size_t kCount = 1024;
+
+  srand(38);
+  std::vector<util::IPAddress> addresses[2];
+  for (size_t i = 0; i < kCount; ++i)
+  {
+    addresses[0].push_back(util::IPAddress::IPv4(rand()));
+    uint8 bytes[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+    for (size_t j = 8; j < sizeof(bytes); ++j)
+      bytes[j] = static_cast<uint8>(rand() % 256);
+    addresses[1].push_back(util::IPAddress(bytes, sizeof(bytes)));
+  }
+  static const char* const kNames[] = { "ipv4", "ipv6" };
+  static const int kFamilies[] = { AF_INET, AF_INET6 };
+
+  for (size_t f = 0; f < arraysize(kNames); ++f)
+  {
+    const std::vector<util::IPAddress>& column = addresses[f];
+    std::vector<std::string> strings;
+    std::vector<util::StringPiece> texts;
+    size_t text_size = 0;
+    for (size_t i = 0; i < kCount; ++i)
+      strings.push_back(column[i].ToString());
+    for (size_t i = 0; i < kCount; ++i)
+    {
+      texts.push_back(strings[i]);
+      text_size += strings[i].size();
+    }
+    const std::string tag = std::string("/") + kNames[f];
+    const int family = kFamilies[f];
+
+    benchmark::Run("inet_pton" + tag, text_size, [&]() {
+        uint8 bytes[16];
+        size_t parsed = 0;
+        for (size_t i = 0; i < kCount; ++i)
+          parsed += inet_pton(family, strings[i].c_str(), bytes);
+        return parsed;
+      });
+    benchmark::Run("AssignFromIPLiteral" + tag, text_size, [&]() {
+        util::IPAddress address;
+        size_t parsed = 0;
+        for (size_t i = 0; i < kCount; ++i)
+          parsed += address.AssignFromIPLiteral(texts[i]);
+        return parsed;
+      });
+    benchmark::Run("ParseIPAddressBatch" + tag, text_size, [&]() {
+        std::vector<util::IPAddress> parsed(kCount);
+        return util::ParseIPAddressBatch(&texts[0], kCount, &parsed[0]);
+      });
+    if (family == AF_INET)
+    {
+      std::vector<uint32> ipv4(kCount);
+      bool valid[kCount];
+      benchmark::Run("ParseIPv4Batch" + tag, text_size, [&]() {
+          return util::ParseIPv4Batch(&texts[0], kCount, &ipv4[0], valid);
+        });
+    }
+
+    benchmark::Run("inet_ntop" + tag, text_size, [&]() {
+        char buffer[INET6_ADDRSTRLEN];
+        size_t length = 0;
+        for (size_t i = 0; i < kCount; ++i)
+        {
+          inet_ntop(family, column[i].bytes(), buffer, sizeof(buffer));
+          length += strlen(buffer);
+        }
+        return length;
+      });
+    benchmark::Run("ToChars" + tag, text_size, [&]() {
+        char buffer[util::IPAddress::kMaxIPv6StringLength];
+        size_t length = 0;
+        for (size_t i = 0; i < kCount; ++i)
+          length += column[i].ToChars(buffer);
+        return length;
+      });
+    std::string output;
+    benchmark::Run("FormatIPAddressBatch" + tag, text_size, [&]() {
+        output.clear();
+        util::FormatIPAddressBatch(&column[0], kCount, '\n', &output);
+        return output.size();
+      });
+  }
+
+  return 0;
+}
@@ -0,0 +1,101 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/ip_address.h"
+#include "util/ip_prefix_table.h"
+
+int main()
+{
+  static const size_t kPrefixes = 100000;
+  static const size_t kLookups = 1 << 20;
+
+  // Mostly /16 to /24 IPv4 and /32 to /48 IPv6 prefixes, like a geo table.
+  srand(39);
+  util::IPPrefixTable::Builder builder;
+  std::vector<std::pair<uint32, uint32> > ranges;  // (network, mask)
+  for (size_t i = 0; i < kPrefixes; ++i)
+  {
+    const size_t length = 16 + rand() % 9;
+    const uint32 mask = ~0u << (32 - length);
+    const uint32 network = (static_cast<uint32>(rand()) << 1) & mask;
+    builder.Add(util::IPAddress::IPv4(network), length, i);
+    ranges.push_back(std::make_pair(network, mask));
+
+    uint8 bytes[16] = { 0x20, 0x01 };
+    for (size_t j = 2; j < 6; ++j)
+      bytes[j] = static_cast<uint8>(rand() % 256);
+    builder.Add(util::IPAddress(bytes, sizeof(bytes)), 32 + rand() % 17, i);
+  }
+  util::IPPrefixTable table;
+  builder.Build(&table);
+  printf("table: %zu prefixes, %zu KiB\n", 2 * kPrefixes,
+         table.MemoryUsage() / 1024);
+
+  std::vector<uint32> ipv4;
+  std::vector<util::IPAddress> ipv6;
+  for (size_t i = 0; i < kLookups; ++i)
+  {
+    ipv4.push_back(static_cast<uint32>(rand()) << 1 | (rand() & 1));
+    uint8 bytes[16] = { 0x20, 0x01 };
+    for (size_t j = 2; j < sizeof(bytes); ++j)
+      bytes[j] = static_cast<uint8>(rand() % 256);
+    ipv6.push_back(util::IPAddress(bytes, sizeof(bytes)));
+  }
+  std::vector<uint32> values(kLookups);
+
+  benchmark::Run("linear scan/ipv4 (1 lookup)", 0, [&]() {
+      uint32 value = util::IPPrefixTable::kNoMatch;
+      uint32 longest = 0;
+      for (size_t i = 0; i < ranges.size(); ++i)
+      {
+        if ((ipv4[0] & ranges[i].second) == ranges[i].first &&
+            ranges[i].second >= longest)
+        {
+          value = i;
+          longest = ranges[i].second;
+        }
+      }
+      return value;
+    });
+  benchmark::Run("LookupIPv4/ipv4 (1M lookups)", 0, [&]() {
+      uint32 sum = 0;
+      for (size_t i = 0; i < kLookups; ++i)
+        sum += table.LookupIPv4(ipv4[i]);
+      return sum;
+    });
+  benchmark::Run("LookupIPv4Batch/ipv4 (1M lookups)", 0, [&]() {
+      table.LookupIPv4Batch(&ipv4[0], kLookups, &values[0]);
+      return values[kLookups - 1];
+    });
+  benchmark::Run("Lookup/ipv6 (1M lookups)", 0, [&]() {
+      uint32 sum = 0;
+      for (size_t i = 0; i < kLookups; ++i)
+        sum += table.Lookup(ipv6[i]);
+      return sum;
+    });
+  benchmark::Run("LookupBatch/ipv6 (1M lookups)", 0, [&]() {
+      table.LookupBatch(&ipv6[0], kLookups, &values[0]);
+      return values[kLookups - 1];
+    });
+
+  return 0;
+}
@@ -0,0 +1,105 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/cpu.h"
+#include "util/string_util.h"
+
+int main()
+{
+  static const size_t kCount = 1024;
+
+  srand(41);
+  std::vector<uint64> macs;
+  std::vector<std::string> strings;
+  std::vector<util::StringPiece> texts;
+  size_t text_size = 0;
+  for (size_t i = 0; i < kCount; ++i)
+  {
+    macs.push_back(((static_cast<uint64>(rand()) << 24) ^ rand()) &
+                   0xFFFFFFFFFFFFULL);
+    strings.push_back(util::FormatMacAddress(macs[i], ":-"[i % 2],
+                                             i % 3 != 0));
+    text_size += strings[i].size();
+  }
+  for (size_t i = 0; i < kCount; ++i)
+    texts.push_back(strings[i]);
+
+  benchmark::Run("sscanf", text_size, [&]() {
+      size_t parsed = 0;
+      for (size_t i = 0; i < kCount; ++i)
+      {
+        unsigned int b[6];
+        char s[5];
+        parsed += sscanf(strings[i].c_str(), "%2x%c%2x%c%2x%c%2x%c%2x%c%2x",
+                         &b[0], &s[0], &b[1], &s[1], &b[2], &s[2], &b[3],
+                         &s[3], &b[4], &s[4], &b[5]) == 11;
+      }
+      return parsed;
+    });
+  for (size_t p = 0; p < arraysize(benchmark::kCPUPaths); ++p)
+  {
+    const benchmark::CPUPath& path = benchmark::kCPUPaths[p];
+    util::SetCPUFeatureMaskForTesting(path.mask);
+    const std::string tag = std::string("/") + path.name;
+    benchmark::Run("ParseMacAddress" + tag, text_size, [&]() {
+        size_t parsed = 0;
+        uint64 mac;
+        for (size_t i = 0; i < kCount; ++i)
+          parsed += util::ParseMacAddress(texts[i], &mac);
+        return parsed;
+      });
+    benchmark::Run("ParseMacAddressBatch" + tag, text_size, [&]() {
+        std::vector<uint64> parsed(kCount);
+        bool valid[kCount];
+        return util::ParseMacAddressBatch(&texts[0], kCount, &parsed[0],
+                                          valid);
+      });
+  }
+  util::SetCPUFeatureMaskForTesting(util::CPU_FEATURES_ALL);
+
+  benchmark::Run("snprintf", text_size, [&]() {
+      std::string output;
+      char buffer[32];
+      for (size_t i = 0; i < kCount; ++i)
+      {
+        const uint64 mac = macs[i];
+        snprintf(buffer, sizeof(buffer), "%02X:%02X:%02X:%02X:%02X:%02X\n",
+                 static_cast<unsigned int>(mac >> 40) & 0xFF,
+                 static_cast<unsigned int>(mac >> 32) & 0xFF,
+                 static_cast<unsigned int>(mac >> 24) & 0xFF,
+                 static_cast<unsigned int>(mac >> 16) & 0xFF,
+                 static_cast<unsigned int>(mac >> 8) & 0xFF,
+                 static_cast<unsigned int>(mac) & 0xFF);
+        output += buffer;
+      }
+      return output.size();
+    });
+  benchmark::Run("FormatMacAddressBatch", text_size, [&]() {
+      std::string output;
+      util::FormatMacAddressBatch(&macs[0], kCount, ':', true, '\n', &output);
+      return output.size();
+    });
+  return 0;
+}
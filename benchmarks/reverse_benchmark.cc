@@ -0,0 +1,100 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/cpu.h"
+#include "util/string_util.h"
+#include "util/sys_byteorder.h"
+
+// The former implementation of Reverse(), for comparison.
+static void ReverseBySubstr(std::string _input, std::string *_output,
+                            const size_t _step)
+{
+  if (_step < _input.length())
+  {
+    const size_t last_pos = _input.length() - _input.length() % _step;
+    const std::string last = _input.substr(last_pos);
+    _input = _input.substr(0, last_pos);
+    for (size_t i = 0; i < _input.length() / 2; i += _step)
+    {
+      const std::string temp = _input.substr(i, _step);
+      _input.replace(i, _step,
+                     _input.substr(_input.length() - (i + _step), _step));
+      _input.replace(_input.length() - (i + _step), _step, temp);
+    }
+    _input = last + _input;
+  }
+  *_output = _input;
+}
+
+int main()
+{
+  static const size_t kSize = 4096;
+
+  std::string text;
+  for (size_t i = 0; i < kSize; ++i)
+    text += "0123456789ABCDEF"[i % 16];
+  std::string work;
+
+  benchmark::Run("ReverseBySubstr step 2", kSize, [&]() {
+      ReverseBySubstr(text, &work, 2);
+      return work.size();
+    });
+
+  static const size_t kSteps[] = { 1, 2, 3, 4, 8 };
+  for (size_t p = 0; p < arraysize(benchmark::kCPUPaths); ++p)
+  {
+    const benchmark::CPUPath& path = benchmark::kCPUPaths[p];
+    util::SetCPUFeatureMaskForTesting(path.mask);
+    for (size_t s = 0; s < arraysize(kSteps); ++s)
+    {
+      benchmark::Run(std::string("Reverse ") + path.name + " step " +
+                     std::to_string(kSteps[s]), kSize, [&]() {
+          work = text;
+          util::Reverse(&work, kSteps[s]);
+          return work.size();
+        });
+    }
+  }
+
+  std::vector<uint32> words(kSize / sizeof(uint32));
+  for (size_t i = 0; i < words.size(); ++i)
+    words[i] = i;
+  benchmark::Run("ByteSwap loop 4", kSize, [&]() {
+      for (size_t i = 0; i < words.size(); ++i)
+        words[i] = util::ByteSwap(words[i]);
+      return words[0];
+    });
+  for (size_t p = 0; p < arraysize(benchmark::kCPUPaths); ++p)
+  {
+    const benchmark::CPUPath& path = benchmark::kCPUPaths[p];
+    util::SetCPUFeatureMaskForTesting(path.mask);
+    benchmark::Run(std::string("ByteSwapBuffer ") + path.name + " 4", kSize,
+                   [&]() {
+        util::ByteSwapBuffer(&words[0], kSize, 4);
+        return words[0];
+      });
+  }
+  util::SetCPUFeatureMaskForTesting(util::CPU_FEATURES_ALL);
+
+  return 0;
+}
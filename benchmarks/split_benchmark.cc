@@ -0,0 +1,264 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/char_set.h"
+#include "util/cpu.h"
+#include "util/string_piece.h"
+#include "util/string_split.h"
+#include "util/string_tokenizer.h"
+#include "util/string_util.h"
+
+int main()
+{
+  static const size_t kLines = 256;
+  static const size_t kColumns = 40;
+
+  // CSV lines of 40 columns: short numbers, and names long enough to miss
+  // the short string optimization.
+  srand(44);
+  std::string text;
+  for (size_t l = 0; l < kLines; ++l)
+  {
+    for (size_t c = 0; c < kColumns; ++c)
+    {
+      if (c != 0)
+        text += ", ";
+      if (c % 4 == 0)
+        text.append(16 + rand() % 16, static_cast<char>('a' + rand() % 26));
+      else
+        text += std::to_string(rand() % 100000);
+    }
+    text += '\n';
+  }
+  std::vector<util::StringPiece> lines;
+  util::SplitStringPieceDontTrim(text, '\n', &lines);
+  lines.pop_back();
+
+  benchmark::Run("SplitString", text.size(), [&]() {
+      size_t fields = 0;
+      for (size_t l = 0; l < lines.size(); ++l)
+      {
+        std::vector<std::string> copies;
+        util::SplitString(lines[l], ',', &copies);
+        fields += copies.size();
+      }
+      return fields;
+    });
+  // Reused from line to line, as a parsing loop would.
+  std::vector<util::StringPiece> r;
+  benchmark::Run("SplitStringPiece", text.size(), [&]() {
+      size_t fields = 0;
+      for (size_t l = 0; l < lines.size(); ++l)
+      {
+        util::SplitStringPiece(lines[l], ',', &r);
+        fields += r.size();
+      }
+      return fields;
+    });
+  benchmark::Run("StringSplitter", text.size(), [&]() {
+      size_t fields = 0;
+      for (size_t l = 0; l < lines.size(); ++l)
+      {
+        for (const util::StringPiece& field :
+                 util::StringSplitter(lines[l], ','))
+          fields += !field.empty();
+      }
+      return fields;
+    });
+
+  // Only the first column is wanted.
+  benchmark::Run("SplitStringPiece/first", text.size(), [&]() {
+      size_t length = 0;
+      for (size_t l = 0; l < lines.size(); ++l)
+      {
+        util::SplitStringPiece(lines[l], ',', &r);
+        length += r[0].size();
+      }
+      return length;
+    });
+  benchmark::Run("StringSplitter/first", text.size(), [&]() {
+      size_t length = 0;
+      for (size_t l = 0; l < lines.size(); ++l)
+        length += util::StringSplitter(lines[l], ',').begin()->size();
+      return length;
+    });
+
+  benchmark::Run("SplitStringDontTrim", text.size(), [&]() {
+      size_t fields = 0;
+      for (size_t l = 0; l < lines.size(); ++l)
+      {
+        std::vector<std::string> copies;
+        util::SplitStringDontTrim(lines[l], ',', &copies);
+        fields += copies.size();
+      }
+      return fields;
+    });
+  benchmark::Run("SplitStringPieceDontTrim", text.size(), [&]() {
+      size_t fields = 0;
+      for (size_t l = 0; l < lines.size(); ++l)
+      {
+        util::SplitStringPieceDontTrim(lines[l], ',', &r);
+        fields += r.size();
+      }
+      return fields;
+    });
+  benchmark::Run("SplitStringAlongWhitespace", text.size(), [&]() {
+      size_t fields = 0;
+      for (size_t l = 0; l < lines.size(); ++l)
+      {
+        std::vector<std::string> copies;
+        util::SplitStringAlongWhitespace(lines[l], &copies);
+        fields += copies.size();
+      }
+      return fields;
+    });
+  benchmark::Run("SplitStringPieceAlongWhitespace", text.size(), [&]() {
+      size_t fields = 0;
+      for (size_t l = 0; l < lines.size(); ++l)
+      {
+        util::SplitStringPieceAlongWhitespace(lines[l], &r);
+        fields += r.size();
+      }
+      return fields;
+    });
+
+  // The same lines with a two-byte delimiter.
+  std::string piped;
+  util::ReplaceChars(text, ",", "||", &piped);
+  std::vector<util::StringPiece> piped_lines;
+  util::SplitStringPieceDontTrim(piped, '\n', &piped_lines);
+  piped_lines.pop_back();
+  const util::StringSearcher separator("||", true);
+  benchmark::Run("SplitStringUsingSubstr", piped.size(), [&]() {
+      size_t fields = 0;
+      for (size_t l = 0; l < piped_lines.size(); ++l)
+      {
+        std::vector<std::string> copies;
+        util::SplitStringUsingSubstr(piped_lines[l], "||", &copies);
+        fields += copies.size();
+      }
+      return fields;
+    });
+  benchmark::Run("SplitStringUsingSubstr StringSearcher", piped.size(),
+                 [&]() {
+      size_t fields = 0;
+      for (size_t l = 0; l < piped_lines.size(); ++l)
+      {
+        std::vector<std::string> copies;
+        util::SplitStringUsingSubstr(piped_lines[l], separator, &copies);
+        fields += copies.size();
+      }
+      return fields;
+    });
+  benchmark::Run("SplitStringPieceUsingSubstr StringSearcher", piped.size(),
+                 [&]() {
+      size_t fields = 0;
+      for (size_t l = 0; l < piped_lines.size(); ++l)
+      {
+        util::SplitStringPieceUsingSubstr(piped_lines[l], separator, &r);
+        fields += r.size();
+      }
+      return fields;
+    });
+
+  // One long line, where the delimiter search rather than the fields
+  // dominates.
+  std::string line = text;
+  while (line.size() < (1 << 20))
+    line += text;
+  for (size_t i = 0; i < line.size(); ++i)
+  {
+    if (line[i] == '\n')
+      line[i] = ',';
+  }
+  std::string crlf_lines;
+  util::ReplaceChars(text, "\n", "\r\n", &crlf_lines);
+  while (crlf_lines.size() < (1 << 20))
+    crlf_lines += crlf_lines;
+  const util::StringSearcher crlf("\r\n", true);
+  const util::CharSet delimiters(", ");
+  std::vector<std::string> tokens;
+  for (size_t p = 0; p < arraysize(benchmark::kCPUPaths); ++p)
+  {
+    const benchmark::CPUPath& path = benchmark::kCPUPaths[p];
+    util::SetCPUFeatureMaskForTesting(path.mask);
+    const std::string tag = std::string(" long line ") + path.name;
+
+    benchmark::Run("SplitStringDontTrim" + tag, line.size(), [&]() {
+        util::SplitStringDontTrim(line, ',', &tokens);
+        return tokens.size();
+      });
+    benchmark::Run("SplitStringPiece" + tag, line.size(), [&]() {
+        util::SplitStringPiece(line, ',', &r);
+        return r.size();
+      });
+    benchmark::Run("SplitStringPieceUsingSubstr CRLF" + tag,
+                   crlf_lines.size(), [&]() {
+        util::SplitStringPieceUsingSubstr(crlf_lines, crlf, &r);
+        return r.size();
+      });
+    benchmark::Run("Tokenize" + tag, line.size(), [&]() {
+        return util::Tokenize(line, delimiters, &tokens);
+      });
+    benchmark::Run("StringTokenizer" + tag, line.size(), [&]() {
+        size_t length = 0;
+        util::StringTokenizer t(line, ", ");
+        while (t.GetNext())
+          length += t.token_end() - t.token_begin();
+        return length;
+      });
+  }
+  util::SetCPUFeatureMaskForTesting(util::CPU_FEATURES_ALL);
+
+  // A large newline-delimited buffer, split on 1 to 8 threads.
+  std::string records;
+  while (records.size() < (64 << 20))
+    records += text;
+  std::vector<std::vector<size_t> > record_ends;
+  benchmark::Run("SplitStringPieceDontTrim records", records.size(), [&]() {
+      util::SplitStringPieceDontTrim(records, '\n', &r);
+      return r.size();
+    });
+  for (size_t threads = 1; threads <= 8; threads *= 2)
+  {
+    const std::string tag = " " + std::to_string(threads) + " threads";
+    benchmark::Run("SplitStringParallel records" + tag, records.size(), [&]() {
+        util::SplitStringParallel(records, '\n', &record_ends, threads);
+        return record_ends.size();
+      });
+    benchmark::Run("SplitStringParallel callback" + tag, records.size(),
+                   [&]() {
+        // A cache line per slice, so that the threads do not share one.
+        std::vector<size_t> lengths(threads * 8);
+        util::SplitStringParallel(
+            records, '\n',
+            [&lengths](const util::StringPiece& record, size_t slice) {
+              lengths[slice * 8] += record.size();
+            },
+            threads);
+        return lengths[0];
+      });
+  }
+  return 0;
+}
@@ -0,0 +1,88 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/str_cat.h"
+#include "util/string_number_conversions.h"
+#include "util/string_util.h"
+
+// The loop JoinString used to be: the result grows with every part.
+static std::string JoinStringAppend(const std::vector<std::string>& parts,
+                                    char sep)
+{
+  if (parts.empty())
+    return std::string();
+  std::string result(parts[0]);
+  for (size_t i = 1; i < parts.size(); ++i)
+  {
+    result += sep;
+    result += parts[i];
+  }
+  return result;
+}
+
+int main()
+{
+  const std::string host = "cache-17.example.com";
+  const int64 user_id = 1234567890123LL;
+  const int port = 8080;
+
+  benchmark::Run("operator+ and ToString", 0, [&]() {
+      return ("user:" + util::ToString(user_id) + "@" + host + ":" +
+              util::ToString(port)).size();
+    });
+  benchmark::Run("std::ostringstream", 0, [&]() {
+      std::ostringstream oss;
+      oss << "user:" << user_id << "@" << host << ":" << port;
+      return oss.str().size();
+    });
+  benchmark::Run("StrCat", 0, [&]() {
+      return util::StrCat("user:", user_id, "@", host, ":", port).size();
+    });
+
+  static const struct
+  {
+    size_t count;
+    size_t length;
+  } kParts[] = { { 1000, 8 }, { 100, 200 } };
+
+  for (size_t p = 0; p < arraysize(kParts); ++p)
+  {
+    std::vector<std::string> parts;
+    for (size_t i = 0; i < kParts[p].count; ++i)
+      parts.push_back(std::string(kParts[p].length, 'a' + i % 26));
+    const size_t joined_size = util::JoinString(parts, ',').size();
+    const std::string n = "/" + util::ToString(kParts[p].count) + "x" +
+        util::ToString(kParts[p].length) + " bytes";
+
+    benchmark::Run("JoinString appending" + n, joined_size, [&]() {
+        return JoinStringAppend(parts, ',').size();
+      });
+    benchmark::Run("JoinString" + n, joined_size, [&]() {
+        return util::JoinString(parts, ',').size();
+      });
+    benchmark::Run("JoinString string separator" + n, joined_size, [&]() {
+        return util::JoinString(parts, ", ").size();
+      });
+  }
+
+  return 0;
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include <string>
+
+#include "benchmark.h"
+#include "util/basictypes.h"
+#include "util/cpu.h"
+#include "util/string_util.h"
+
+int main()
+{
+  static const size_t kTextSize = 16 * 1024;
+
+  // Plain ASCII text, and UTF-8 text with NBSP, ideographic spaces and CJK.
+  static const char* const kLines[] = {
+    "  name = value;\t\tother  =  thing \r\n",
+    "  name\xc2\xa0=\xc2\xa0\xe5\x80\xbc;\xe3\x80\x80other = \xe4\xb8\x9c\r\n",
+  };
+  static const char* const kNames[] = { "ascii", "utf-8" };
+
+  for (size_t l = 0; l < arraysize(kLines); ++l)
+  {
+    std::string text;
+    while (text.size() < kTextSize)
+      text += kLines[l];
+    const std::string padded = std::string(64, ' ') + text + "\xe3\x80\x80  ";
+    std::string work;
+
+    for (size_t p = 0; p < arraysize(benchmark::kCPUPaths); ++p)
+    {
+      const benchmark::CPUPath& path = benchmark::kCPUPaths[p];
+      util::SetCPUFeatureMaskForTesting(path.mask);
+      const std::string tag =
+          std::string(" ") + path.name + "/" + kNames[l];
+
+      benchmark::Run("CollapseWhitespaceASCII" + tag, text.size(), [&]() {
+          work = text;
+          util::CollapseWhitespaceASCII(&work, false);
+          return work.size();
+        });
+      benchmark::Run("CollapseWhitespace" + tag, text.size(), [&]() {
+          work = text;
+          util::CollapseWhitespace(&work, false);
+          return work.size();
+        });
+      benchmark::Run("TrimWhitespaceASCII" + tag, 0, [&]() {
+          return util::TrimWhitespaceASCII(util::StringPiece(padded),
+                                           util::TRIM_ALL).size();
+        });
+      benchmark::Run("TrimWhitespace" + tag, 0, [&]() {
+          return util::TrimWhitespace(util::StringPiece(padded),
+                                      util::TRIM_ALL).size();
+        });
+    }
+    util::SetCPUFeatureMaskForTesting(util::CPU_FEATURES_ALL);
+  }
+
+  return 0;
+}
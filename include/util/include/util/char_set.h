@@ -0,0 +1,125 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#ifndef UTIL_CHAR_SET_H_
+#define UTIL_CHAR_SET_H_
+
+#include <stddef.h>
+
+#include "util/basictypes.h"
+#include "util/string_piece.h"
+
+namespace util
+{
+  // A set of bytes, for the functions that look for "any of these chars":
+  // ContainsOnlyChars(), TrimString(), Tokenize(), RemoveChars()...  Testing a
+  // byte is a single lookup whatever the size of the set, and the Find*()
+  // scans test 16 or 32 bytes at a time when SSE4.2 or AVX2 is available.
+  //
+  // A set of literal chars can be built at compile time:
+  //   static constexpr CharSet kSeparators(",; ");
+  // and reused by every call instead of rescanning a list of chars per byte.
+  class CharSet
+  {
+ public:
+    // The empty set.
+    constexpr CharSet() : words_{0, 0, 0, 0} {}
+
+    // The chars of the null-terminated |chars|.
+    explicit constexpr CharSet(const char chars[])
+        : words_{Word(chars, 0), Word(chars, 1),
+                 Word(chars, 2), Word(chars, 3)} {}
+
+    // Every char of |chars|, including any '\0'.
+    explicit CharSet(const StringPiece& chars);
+
+    constexpr bool Contains(char c) const
+    {
+      return (words_[WordIndex(c)] >> BitIndex(c)) & 1;
+    }
+
+    void Add(char c)
+    {
+      words_[WordIndex(c)] |= GG_UINT64_C(1) << BitIndex(c);
+    }
+
+    bool empty() const
+    {
+      return (words_[0] | words_[1] | words_[2] | words_[3]) == 0;
+    }
+
+    // Same as the std::string functions of the same name, with the chars of
+    // this set as the list of chars to look for.
+    size_t FindFirstOf(const StringPiece& str, size_t pos = 0) const;
+    size_t FindFirstNotOf(const StringPiece& str, size_t pos = 0) const;
+    size_t FindLastOf(const StringPiece& str,
+                      size_t pos = StringPiece::npos) const;
+    size_t FindLastNotOf(const StringPiece& str,
+                         size_t pos = StringPiece::npos) const;
+
+    // Returns the first byte of [begin, end) that is in the set if |in_set|
+    // is true, or that is not in the set otherwise; |end| if there is none.
+    const char* Scan(const char* begin, const char* end, bool in_set) const;
+
+    // Same as above scanning backwards: returns one past the last matching
+    // byte of [begin, end), or |begin|.
+    const char* ReverseScan(const char* begin, const char* end,
+                            bool in_set) const;
+
+    // Replaces every byte of [begin, end) that is in the set by |c|.  Whole
+    // 16 or 32 byte blocks are blended with their member mask, so dense
+    // matches cost no more than sparse ones.
+    void Replace(char* begin, char* end, char c) const;
+
+    // Stores in |offsets| the positions in |str| of its first |max_count|
+    // bytes at or after |pos| that are in the set, and returns how many were
+    // stored; a caller that got |max_count| of them carries on after the
+    // last one.  Each 16 or 32 byte block is turned into a bitmask of its
+    // members whose set bits are read off one by one, which beats one Scan()
+    // per byte found when they are close together, as delimiters are.
+    size_t FindAllOf(const StringPiece& str, size_t pos, size_t* offsets,
+                     size_t max_count) const;
+
+ private:
+    // The 256 bits are laid out as two 16-byte tables indexed by the low
+    // nibble of a byte: the first one for bytes below 0x80, the second for
+    // the others.  Bits 4 to 6 of the byte pick the bit within the entry.
+    // This is the layout PSHUFB needs to test a whole block of bytes at once.
+    static constexpr int WordIndex(char c)
+    {
+      return (static_cast<unsigned char>(c) >> 7) * 2 +
+          ((static_cast<unsigned char>(c) & 0x0F) >> 3);
+    }
+
+    static constexpr int BitIndex(char c)
+    {
+      return (static_cast<unsigned char>(c) & 0x07) * 8 +
+          ((static_cast<unsigned char>(c) >> 4) & 0x07);
+    }
+
+    static constexpr uint64 Word(const char* chars, int word)
+    {
+      return *chars == '\0' ? 0 :
+          ((WordIndex(*chars) == word ? GG_UINT64_C(1) << BitIndex(*chars)
+            : 0) | Word(chars + 1, word));
+    }
+
+    uint64 words_[4];
+  };
+
+}; // namespace util
+
+#endif // UTIL_CHAR_SET_H_
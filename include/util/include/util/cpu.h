@@ -0,0 +1,95 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#ifndef UTIL_CPU_H_
+#define UTIL_CPU_H_
+
+#include <string>
+
+#include "util/basictypes.h"
+#include "util/string_piece.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ARCH_CPU_X86_FAMILY 1
+#endif
+
+// Functions marked with TARGET_AVX2 / TARGET_SSE42 are compiled for that
+// instruction set whatever the flags of the rest of the file, so they must
+// only be called after checking CPUHasAVX2() / CPUHasSSE42().
+#if defined(ARCH_CPU_X86_FAMILY) && defined(__GNUC__)
+#define HAVE_TARGET_ATTRIBUTE 1
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+
+namespace util
+{
+  enum CPUFeatures
+  {
+    CPU_SSE42        = 1 << 0,
+    CPU_AVX2         = 1 << 1,
+    CPU_FEATURES_ALL = CPU_SSE42 | CPU_AVX2,
+  };
+
+  // Returns true if the processor running this code supports the given
+  // instruction set, and the operating system saves its registers.
+  bool CPUHasSSE42();
+  bool CPUHasAVX2();
+
+  // Restricts the features reported above to the ones both present and in
+  // |mask|, so that unit tests and benchmarks can run every code path on a
+  // single machine.  Pass CPU_FEATURES_ALL to restore the defaults.
+  void SetCPUFeatureMaskForTesting(int mask);
+
+  // The masks that select the plain, the SSE4.2 and the AVX2 code paths, for
+  // tests that run each of them in turn.
+  extern const int kCPUFeatureMasksForTesting[3];
+
+  // Sets the feature mask for its lifetime, and restores every feature when
+  // it goes out of scope, even if a failed ASSERT leaves the test early.
+  class ScopedCPUFeatureMask
+  {
+ public:
+    explicit ScopedCPUFeatureMask(int mask);
+    ~ScopedCPUFeatureMask();
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(ScopedCPUFeatureMask);
+  };
+
+  // Calls |test(mask)| once per mask of kCPUFeatureMasksForTesting, with
+  // that mask set, so that a test runs against every code path.
+  template <typename TEST>
+  void ForEachCPUFeatureMask(TEST test)
+  {
+    for (size_t i = 0; i < ARRAYSIZE_UNSAFE(kCPUFeatureMasksForTesting); ++i)
+    {
+      const ScopedCPUFeatureMask scoped_mask(kCPUFeatureMasksForTesting[i]);
+      test(kCPUFeatureMasksForTesting[i]);
+    }
+  }
+
+  // Returns a string of 0 to |max_length| bytes drawn from |alphabet| with
+  // rand(), in runs of 1 to |max_run| copies of the same byte, for the tests
+  // that compare the code paths above with a naive version.  A byte repeated
+  // in |alphabet| comes up that much more often.
+  std::string RandomString(const StringPiece& alphabet,
+                           size_t max_length,
+                           size_t max_run = 1);
+
+}; // namespace util
+
+#endif // UTIL_CPU_H_
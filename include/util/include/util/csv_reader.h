@@ -0,0 +1,159 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#ifndef UTIL_CSV_READER_H_
+#define UTIL_CSV_READER_H_
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "util/basictypes.h"
+#include "util/string_piece.h"
+
+namespace util
+{
+  // A row read by a CSVReader.  Its fields point into the input or into the
+  // row itself; they are valid until the next call on the reader.
+  class CSVRow
+  {
+ public:
+    CSVRow();
+    ~CSVRow();
+
+    size_t size() const { return fields_.size(); }
+    const StringPiece& operator[](size_t i) const { return fields_[i]; }
+    const std::vector<StringPiece>& fields() const { return fields_; }
+
+    // Parse field |i| as a number, with StringToInt() and friends.  Return
+    // false if the row has no field |i| or it is not a valid number.
+    bool GetInt(size_t i, int* value) const;
+    bool GetUint(size_t i, unsigned* value) const;
+    bool GetInt64(size_t i, int64* value) const;
+    bool GetUint64(size_t i, uint64* value) const;
+
+ private:
+    friend class CSVReader;
+
+    std::vector<StringPiece> fields_;
+
+    // The quoted fields with escaped quotes, unescaped.  It is reserved to
+    // the length of the row up front, so the fields pointing into it stay
+    // valid while the row is built.
+    std::string unescaped_;
+  };
+
+  // CSVReader reads RFC 4180 CSV, or TSV with a '\t' delimiter, from a
+  // buffer such as a mmap()ed file or from a stream of chunks.
+  //
+  // Rows end with "\n" or "\r\n".  A field in quotes may hold delimiters,
+  // line breaks and doubled quotes, which stand for one quote; its value is
+  // the text between the quotes.  Any other field is taken as it is.
+  //
+  // The input is scanned 64 bytes at a time: masks of its quotes,
+  // delimiters and line breaks are made with AVX2 or SSE2, and the bytes in
+  // quotes are found by a prefix XOR of the quote mask, carried from block
+  // to block, so the delimiters and line breaks that end fields are found
+  // without looking at each byte.
+  //
+  // EXAMPLE:
+  //
+  //   CSVReader reader;
+  //   reader.Append("id,name\n1,\"Smith, J\"\n");
+  //   reader.Finish();
+  //   CSVRow row;
+  //   while (reader.NextRow(&row))
+  //     printf("%d fields\n", static_cast<int>(row.size()));
+  class CSVReader
+  {
+ public:
+    explicit CSVReader(char delimiter = ',', char quote = '"');
+    ~CSVReader();
+
+    // Feeds the next chunk of the input, once NextRow() has returned false
+    // for the previous one.  |chunk| must stay valid until NextRow()
+    // returns false again; only a row cut by the end of a chunk is copied.
+    void Append(const StringPiece& chunk);
+
+    // Marks the end of the input, which ends the last row even without a
+    // line break.
+    void Finish();
+
+    // Reads the next complete row into |row|.  Returns false once the rows
+    // of the input fed so far are all read.
+    bool NextRow(CSVRow* row);
+
+ private:
+    // Starts scanning |length| bytes at |data| from |pos|, which is not in
+    // quotes when |in_quote| is false.
+    void StartScan(const char* data, size_t length, size_t pos,
+                   bool in_quote);
+
+    // Makes the masks of the block at |next_block_|.
+    void ScanBlock();
+
+    // Finds the next delimiter or line break out of quotes.  Returns false
+    // at the end of the data.
+    bool NextStructural(size_t* offset, bool* line_break);
+
+    // Reads the row starting at |*pos| of the data being scanned, and moves
+    // |*pos| past it.  Without a line break, the row is only complete when
+    // |at_end| is set; otherwise false is returned and |*pos| is left alone.
+    bool ReadRow(size_t* pos, bool at_end, CSVRow* row);
+
+    // Adds the field [begin, end) to |row|, unquoted.
+    void AddField(const char* begin, const char* end, CSVRow* row) const;
+
+    const char delimiter_;
+    const char quote_;
+
+    // The chunk being read, where its next row starts, and whether it is
+    // the data being scanned.
+    StringPiece chunk_;
+    size_t pos_;
+    bool scanning_chunk_;
+
+    // The start of a row cut by the end of a chunk, whose quote state is
+    // |pending_in_quote_|, and whether the rest of it has been appended.
+    // Once read, the row moves to |row_|, where its fields point.
+    std::string pending_;
+    bool pending_in_quote_;
+    bool pending_complete_;
+    std::string row_;
+
+    bool finished_;
+
+    // The scan: the data, the offset of the current block and of the next
+    // one, the delimiters and line breaks out of quotes not read yet in the
+    // current block, and whether the next block starts in quotes.
+    const char* data_;
+    size_t length_;
+    size_t block_;
+    size_t next_block_;
+    uint64 structural_;
+    uint64 line_breaks_;
+    bool in_quote_;
+
+    // The field ends of the row being read.
+    std::vector<size_t> ends_;
+
+    DISALLOW_COPY_AND_ASSIGN(CSVReader);
+  };
+
+}; // namespace util
+
+#endif // UTIL_CSV_READER_H_
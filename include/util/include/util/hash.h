@@ -0,0 +1,96 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#ifndef UTIL_HASH_H_
+#define UTIL_HASH_H_
+
+#include <stddef.h>
+
+#include "util/basictypes.h"
+#include "util/string_piece.h"
+
+namespace util
+{
+  // Fast 64-bit non-cryptographic hash of a string, in the style of wyhash:
+  // 16 or 48 bytes per round of 64x64->128 bit multiplications.  Good enough
+  // for hash tables and deduplication, but not against attackers choosing
+  // keys.  The value does not change from one run to the next.
+  uint64 Hash64(const StringPiece& str);
+
+  // Same as above, mixing |seed| in, e.g. to get independent hash functions.
+  uint64 Hash64(const StringPiece& str, uint64 seed);
+
+  // Same as Hash64() of the string with its ASCII letters lower-cased, so
+  // that strings equal for EqualsCaseInsensitiveASCII() hash the same.
+  uint64 Hash64IgnoringCaseASCII(const StringPiece& str, uint64 seed = 0);
+
+  // Hashes a string given in pieces: the result is Hash64() of the
+  // concatenation of all the pieces, however it is cut.
+  class Hash64Stream
+  {
+ public:
+    explicit Hash64Stream(uint64 seed = 0);
+
+    void Update(const StringPiece& piece);
+
+    // Returns the hash of everything passed to Update() so far.
+    uint64 Finish() const;
+
+ private:
+    static const size_t kBlockSize = 48;
+
+    void ConsumeBlock(const char* block);
+
+    uint64 seed_;
+    uint64 see1_;
+    uint64 see2_;
+    size_t length_;
+    // Bytes not hashed yet: the last ones may turn out to be the tail of the
+    // input, which is hashed differently.  The 16 bytes before them are kept
+    // too since the tail is read as the last 16 bytes of the input.
+    char previous_[16];
+    char pending_[kBlockSize];
+    size_t pending_length_;
+  };
+
+  // Hash and equality functors for containers of strings, e.g.
+  //   std::unordered_map<std::string, int, StringHash> counts;
+  //   std::unordered_set<std::string, CaseInsensitiveHashASCII,
+  //                      CaseInsensitiveEqualASCII> headers;
+  struct StringHash
+  {
+    size_t operator()(const StringPiece& str) const
+    {
+      return static_cast<size_t>(Hash64(str));
+    }
+  };
+
+  struct CaseInsensitiveHashASCII
+  {
+    size_t operator()(const StringPiece& str) const
+    {
+      return static_cast<size_t>(Hash64IgnoringCaseASCII(str));
+    }
+  };
+
+  struct CaseInsensitiveEqualASCII
+  {
+    bool operator()(const StringPiece& a, const StringPiece& b) const;
+  };
+
+}; // namespace util
+
+#endif // UTIL_HASH_H_
@@ -0,0 +1,127 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#ifndef UTIL_IP_ADDRESS_H_
+#define UTIL_IP_ADDRESS_H_
+
+#include <stddef.h>
+
+#include <string>
+
+#include "util/basictypes.h"
+#include "util/string_piece.h"
+
+namespace util
+{
+  // An IPv4 or IPv6 address, stored as its bytes in network order.
+  //
+  // The parsing and formatting functions work on the caller's buffers and
+  // never allocate: a literal is read in a single pass without splitting it
+  // into pieces, and a binary address is written straight into chars.
+  class IPAddress
+  {
+ public:
+    static const size_t kIPv4AddressSize = 4;
+    static const size_t kIPv6AddressSize = 16;
+
+    // The longest text forms written by ToChars(), without a trailing '\0'.
+    static const size_t kMaxIPv4StringLength = 15;
+    static const size_t kMaxIPv6StringLength = 39;
+
+    // An empty, invalid address.
+    IPAddress() : size_(0) {}
+
+    // Copies |size| bytes, which must be kIPv4AddressSize or
+    // kIPv6AddressSize; any other size gives an invalid address.
+    IPAddress(const uint8* bytes, size_t size);
+
+    // An IPv4 address given as a host order integer: 0x7F000001 is
+    // 127.0.0.1.
+    static IPAddress IPv4(uint32 address);
+
+    // Parses a dotted decimal IPv4 or an RFC 4291 IPv6 literal.  On failure
+    // returns false and the address becomes invalid.
+    bool AssignFromIPLiteral(const StringPiece& text);
+
+    bool IsValid() const { return size_ != 0; }
+    bool IsIPv4() const { return size_ == kIPv4AddressSize; }
+    bool IsIPv6() const { return size_ == kIPv6AddressSize; }
+
+    // True for the ::ffff:a.b.c.d addresses.
+    bool IsIPv4MappedIPv6() const;
+
+    const uint8* bytes() const { return bytes_; }
+    size_t size() const { return size_; }
+
+    // The address as a host order integer.  IsIPv4() must be true.
+    uint32 ToIPv4() const;
+
+    // Writes the text form of the address to |out|, which must have room for
+    // kMaxIPv6StringLength chars, and returns the number of chars written.
+    // IPv6 addresses are written in the RFC 5952 canonical form.  Writes
+    // nothing for an invalid address.
+    size_t ToChars(char* out) const;
+
+    std::string ToString() const;
+
+    bool operator==(const IPAddress& other) const;
+    bool operator!=(const IPAddress& other) const { return !(*this == other); }
+
+    // IPv4 addresses sort before IPv6 ones, then by bytes.
+    bool operator<(const IPAddress& other) const;
+
+ private:
+    uint8 bytes_[kIPv6AddressSize];
+    uint8 size_;
+  };
+
+  // Parses a dotted decimal IPv4 address: four numbers 0 to 255 without
+  // leading zeros, as inet_pton(AF_INET) does.  |address| gets the bytes in
+  // network order, or the host order integer.
+  bool ParseIPv4(const StringPiece& text, uint8 address[4]);
+  bool ParseIPv4(const StringPiece& text, uint32* address);
+
+  // Parses an RFC 4291 IPv6 address, with at most one "::" and an optional
+  // dotted IPv4 tail, as inet_pton(AF_INET6) does.
+  bool ParseIPv6(const StringPiece& text, uint8 address[16]);
+
+  // Write the text form of an address to |out|, which must have room for
+  // kMaxIPv4StringLength or kMaxIPv6StringLength chars, and return the
+  // number of chars written.
+  size_t FormatIPv4(const uint8 address[4], char* out);
+  size_t FormatIPv6(const uint8 address[16], char* out);
+
+  // Batch forms, for a column of addresses such as a field of a log file.
+  //
+  // ParseIPv4Batch() stores the host order integer of each of the |count|
+  // |texts| in |addresses| and whether it was valid in |valid| (an invalid
+  // text gives 0).  ParseIPAddressBatch() gives an invalid IPAddress for an
+  // invalid text.  Both return the number of valid addresses.
+  size_t ParseIPv4Batch(const StringPiece* texts, size_t count,
+                        uint32* addresses, bool* valid);
+  size_t ParseIPAddressBatch(const StringPiece* texts, size_t count,
+                             IPAddress* addresses);
+
+  // Append the text form of each of the |count| addresses to |output|, each
+  // one followed by |separator|.  |output| is grown once.
+  void FormatIPv4Batch(const uint32* addresses, size_t count, char separator,
+                       std::string* output);
+  void FormatIPAddressBatch(const IPAddress* addresses, size_t count,
+                            char separator, std::string* output);
+
+}; // namespace util
+
+#endif // UTIL_IP_ADDRESS_H_
@@ -0,0 +1,142 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#ifndef UTIL_IP_PREFIX_TABLE_H_
+#define UTIL_IP_PREFIX_TABLE_H_
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "util/basictypes.h"
+#include "util/ip_address.h"
+#include "util/string_piece.h"
+
+namespace util
+{
+  // Maps CIDR prefixes such as 10.0.0.0/8 or 2001:db8::/32 to values, e.g.
+  // a country or an ACL rule, and finds the value of the longest prefix
+  // matching an address.
+  //
+  // The table is a multibit trie: a first level indexed by the top 16 bits
+  // of the address, then one level of 256 entries per following byte.  The
+  // prefixes are expanded so that each entry holds the value of the longest
+  // prefix covering it, so a lookup stops at the first entry that is not a
+  // link to a deeper level: an IPv4 lookup takes at most 3 memory accesses,
+  // whatever the number of prefixes, and an IPv6 one 1 + (length - 16) / 8
+  // for a prefix of |length| bits.
+  //
+  // A table is immutable: it is made by a Builder, or attached to an image
+  // written by Serialize(), e.g. a file that is mmap()ed back, without
+  // copying it.
+  //
+  // EXAMPLE:
+  //
+  //   IPPrefixTable::Builder builder;
+  //   builder.Add("10.0.0.0/8", 1);
+  //   builder.Add("10.1.0.0/16", 2);
+  //   IPPrefixTable table;
+  //   builder.Build(&table);
+  //   table.LookupIPv4(0x0A010203);  // 2, for 10.1.2.3
+  class IPPrefixTable
+  {
+ public:
+    // Returned by the lookups when no prefix matches; values must be less.
+    static const uint32 kNoMatch = 0x7FFFFFFF;
+
+    class Builder
+    {
+   public:
+      Builder();
+      ~Builder();
+
+      // Adds the |prefix_length| first bits of |prefix|; the other bits of
+      // |prefix| are ignored.  Returns false if |prefix| is invalid,
+      // |prefix_length| longer than the address or |value| not less than
+      // kNoMatch.  If the same prefix is added twice, the last value wins.
+      bool Add(const IPAddress& prefix, size_t prefix_length, uint32 value);
+
+      // Same as above, for "address/length"; a bare address is a prefix of
+      // its full length.
+      bool Add(const StringPiece& cidr, uint32 value);
+
+      // Builds |table| from the prefixes added so far.
+      void Build(IPPrefixTable* table) const;
+
+   private:
+      struct Prefix
+      {
+        uint8 bytes[IPAddress::kIPv6AddressSize];
+        uint8 length;
+        bool ipv6;
+        uint32 value;
+      };
+
+      std::vector<Prefix> prefixes_;
+
+      DISALLOW_COPY_AND_ASSIGN(Builder);
+    };
+
+    // An empty table: every lookup gives kNoMatch.
+    IPPrefixTable();
+    ~IPPrefixTable();
+
+    // Returns the value of the longest prefix matching |address|, or
+    // kNoMatch.  IPv4 addresses are matched against the IPv4 prefixes, IPv6
+    // ones, including IPv4-mapped ones, against the IPv6 prefixes.
+    uint32 LookupIPv4(uint32 address) const;
+    uint32 Lookup(const IPAddress& address) const;
+
+    // Same as above for |count| addresses at once.  The lookups are
+    // interleaved, and the entry each one needs next is prefetched while the
+    // others proceed, so the memory accesses overlap instead of waiting on
+    // each other.
+    void LookupIPv4Batch(const uint32* addresses, size_t count,
+                         uint32* values) const;
+    void LookupBatch(const IPAddress* addresses, size_t count,
+                     uint32* values) const;
+
+    // Writes the table as a flat image that Attach() takes back.
+    void Serialize(std::string* image) const;
+
+    // Makes the table use the image at |data|, written by Serialize() on a
+    // machine of the same byte order, without copying it.  |data| must be
+    // 4-byte aligned and outlive the table.  Returns false, leaving the table
+    // empty, if |data| is not a valid image.
+    bool Attach(const void* data, size_t size);
+
+    // The size of the trie in bytes.
+    size_t MemoryUsage() const { return num_entries_ * sizeof(uint32); }
+
+ private:
+    void Reset(const uint32* entries, size_t num_entries);
+
+    // The trie: the IPv4 and IPv6 first levels of 65536 entries each, then
+    // the deeper levels, 256 entries each.  Entries are values, or
+    // kLink | (index of a deeper level / 256).
+    const uint32* entries_;
+    size_t num_entries_;
+
+    // The entries when the table owns them.
+    std::vector<uint32> storage_;
+
+    DISALLOW_COPY_AND_ASSIGN(IPPrefixTable);
+  };
+
+}; // namespace util
+
+#endif // UTIL_IP_PREFIX_TABLE_H_
@@ -0,0 +1,87 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#ifndef UTIL_STR_CAT_H_
+#define UTIL_STR_CAT_H_
+
+#include <initializer_list>
+#include <string>
+
+#include "util/basictypes.h"
+#include "util/string_piece.h"
+
+namespace util
+{
+  // One argument of StrCat() or StrAppend(): a string, or an integer written
+  // in decimal into the argument's own buffer.  It is only ever built as a
+  // temporary by those functions.
+  class StrCatArg
+  {
+ public:
+    StrCatArg(const char* str) : piece_(str) {}
+    StrCatArg(const std::string& str) : piece_(str) {}
+    StrCatArg(const StringPiece& str) : piece_(str) {}
+
+    StrCatArg(int value) { SetSigned(value); }
+    StrCatArg(unsigned int value) { SetUnsigned(value); }
+    StrCatArg(long value) { SetSigned(value); }
+    StrCatArg(unsigned long value) { SetUnsigned(value); }
+    StrCatArg(long long value) { SetSigned(value); }
+    StrCatArg(unsigned long long value) { SetUnsigned(value); }
+
+    // A char would be taken for a number; pass a string instead.
+    StrCatArg(char) = delete;
+
+    const StringPiece& piece() const { return piece_; }
+
+ private:
+    // Enough for the 20 digits of kuint64max, or a sign and 19 digits.
+    static const size_t kBufferSize = 20;
+
+    void SetSigned(long long value);
+    void SetUnsigned(unsigned long long value);
+
+    StringPiece piece_;
+    char digits_[kBufferSize];
+
+    DISALLOW_COPY_AND_ASSIGN(StrCatArg);
+  };
+
+  std::string StrCatPieces(std::initializer_list<StringPiece> pieces);
+  void StrAppendPieces(std::string* dest,
+                       std::initializer_list<StringPiece> pieces);
+
+  // Concatenates any number of strings, StringPieces and integers:
+  //   std::string key = StrCat("user:", user_id, ":", name);
+  // The size of the result is computed first, so it is allocated exactly
+  // once.  Integers are formatted without going through a stream.
+  template <typename... Args>
+  std::string StrCat(const Args&... args)
+  {
+    return StrCatPieces({ StrCatArg(args).piece()... });
+  }
+
+  // Same as above, appending to |*dest|, which grows at most once.  The
+  // arguments may point into |*dest|.
+  template <typename... Args>
+  void StrAppend(std::string* dest, const Args&... args)
+  {
+    StrAppendPieces(dest, { StrCatArg(args).piece()... });
+  }
+
+}; // namespace util
+
+#endif // UTIL_STR_CAT_H_
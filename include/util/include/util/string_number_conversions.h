@@ -22,26 +22,29 @@
 #include <vector>
 
 #include "util/basictypes.h"
+#include "util/string_piece.h"
 
 namespace util
 {
 
-bool StringToInt(const std::string &_input, int *_output);
-bool StringToUint(const std::string &_input, unsigned *_output);
-bool StringToInt64(const std::string &_input, int64 *_output);
-bool StringToUint64(const std::string &_input, uint64 *_output);
-bool StringToSizeT(const std::string &_input, size_t *_output);
+// The parsers take a StringPiece, so a slice of a larger buffer can be
+// converted without copying it into a std::string first.
+bool StringToInt(const StringPiece &_input, int *_output);
+bool StringToUint(const StringPiece &_input, unsigned *_output);
+bool StringToInt64(const StringPiece &_input, int64 *_output);
+bool StringToUint64(const StringPiece &_input, uint64 *_output);
+bool StringToSizeT(const StringPiece &_input, size_t *_output);
 
 template <typename VALUE>
-bool StringToIntImpl(const std::string &_input, VALUE *_output);
+bool StringToIntImpl(const StringPiece &_input, VALUE *_output);
 
 std::string HexEncode(const void* bytes, size_t size);
-bool HexStringToInt(const std::string &_input, int *_output);
-bool HexStringToBytes(const std::string& input, std::vector<uint8>* output);
-bool HexStringToASCIIString(const std::string &_input, std::string &_output);
+bool HexStringToInt(const StringPiece &_input, int *_output);
+bool HexStringToBytes(const StringPiece& input, std::vector<uint8>* output);
+bool HexStringToASCIIString(const StringPiece &_input, std::string &_output);
 void ByteToHexString(const uint8 _input, std::string *_output);
 void BytesToHexString(const std::vector<uint8> &_input, std::string *_output);
-void ASCIIStringToHexString(const std::string &_input, std::string *_output);
+void ASCIIStringToHexString(const StringPiece &_input, std::string *_output);
 void UintToHexString(const unsigned int _input, std::string *_output);
 
 template <typename T>
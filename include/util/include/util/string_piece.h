@@ -0,0 +1,187 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#ifndef UTIL_STRING_PIECE_H_
+#define UTIL_STRING_PIECE_H_
+
+#include <stddef.h>
+#include <string.h>
+
+#include <iosfwd>
+#include <string>
+
+namespace util
+{
+  // A StringPiece points to a run of chars owned by someone else: a
+  // std::string, a literal, a slice of a larger buffer.  Functions taking a
+  // StringPiece accept all of them without building a temporary std::string.
+  //
+  // The referenced memory must outlive the piece, so a StringPiece should
+  // normally be used for arguments and short-lived locals only.  It is cheap
+  // to copy and should be passed by value or const reference.
+  class StringPiece
+  {
+ public:
+    typedef size_t size_type;
+    typedef char value_type;
+    typedef const char* pointer;
+    typedef const char& reference;
+    typedef const char& const_reference;
+    typedef ptrdiff_t difference_type;
+    typedef const char* const_iterator;
+    typedef const char* iterator;
+
+    static const size_type npos;
+
+    StringPiece() : ptr_(NULL), length_(0) {}
+    StringPiece(const char* str)
+        : ptr_(str), length_((str == NULL) ? 0 : strlen(str)) {}
+    StringPiece(const std::string& str)
+        : ptr_(str.data()), length_(str.size()) {}
+    StringPiece(const char* offset, size_type len)
+        : ptr_(offset), length_(len) {}
+    StringPiece(const std::string::const_iterator& begin,
+                const std::string::const_iterator& end)
+        : ptr_((end > begin) ? &(*begin) : NULL),
+          length_((end > begin) ? static_cast<size_type>(end - begin) : 0) {}
+
+    const char* data() const { return ptr_; }
+    size_type size() const { return length_; }
+    size_type length() const { return length_; }
+    bool empty() const { return length_ == 0; }
+
+    void clear()
+    {
+      ptr_ = NULL;
+      length_ = 0;
+    }
+    void set(const char* data, size_type len)
+    {
+      ptr_ = data;
+      length_ = len;
+    }
+
+    char operator[](size_type i) const { return ptr_[i]; }
+
+    void remove_prefix(size_type n)
+    {
+      ptr_ += n;
+      length_ -= n;
+    }
+
+    void remove_suffix(size_type n)
+    {
+      length_ -= n;
+    }
+
+    int compare(const StringPiece& x) const
+    {
+      const size_type min_size = (length_ < x.length_) ? length_ : x.length_;
+      int r = (min_size == 0) ? 0 : memcmp(ptr_, x.ptr_, min_size);
+      if (r == 0)
+      {
+        if (length_ < x.length_)
+          r = -1;
+        else if (length_ > x.length_)
+          r = +1;
+      }
+      return r;
+    }
+
+    std::string as_string() const
+    {
+      // std::string doesn't like to take a NULL pointer even with a 0 size.
+      return empty() ? std::string() : std::string(data(), size());
+    }
+
+    void CopyToString(std::string* target) const
+    {
+      if (empty())
+        target->clear();
+      else
+        target->assign(data(), size());
+    }
+
+    void AppendToString(std::string* target) const
+    {
+      if (!empty())
+        target->append(data(), size());
+    }
+
+    bool starts_with(const StringPiece& x) const
+    {
+      return (length_ >= x.length_) &&
+          (x.length_ == 0 || memcmp(ptr_, x.ptr_, x.length_) == 0);
+    }
+
+    bool ends_with(const StringPiece& x) const
+    {
+      return (length_ >= x.length_) &&
+          (x.length_ == 0 ||
+           memcmp(ptr_ + (length_ - x.length_), x.ptr_, x.length_) == 0);
+    }
+
+    const_iterator begin() const { return ptr_; }
+    const_iterator end() const { return ptr_ + length_; }
+
+    size_type find(char c, size_type pos = 0) const;
+    size_type find(const StringPiece& s, size_type pos = 0) const;
+    size_type rfind(char c, size_type pos = npos) const;
+
+    StringPiece substr(size_type pos, size_type n = npos) const;
+
+ private:
+    const char* ptr_;
+    size_type length_;
+  };
+
+  inline bool operator==(const StringPiece& x, const StringPiece& y)
+  {
+    if (x.size() != y.size())
+      return false;
+    return x.size() == 0 || memcmp(x.data(), y.data(), x.size()) == 0;
+  }
+
+  inline bool operator!=(const StringPiece& x, const StringPiece& y)
+  {
+    return !(x == y);
+  }
+
+  inline bool operator<(const StringPiece& x, const StringPiece& y)
+  {
+    return x.compare(y) < 0;
+  }
+
+  inline bool operator>(const StringPiece& x, const StringPiece& y)
+  {
+    return y < x;
+  }
+
+  inline bool operator<=(const StringPiece& x, const StringPiece& y)
+  {
+    return !(x > y);
+  }
+
+  inline bool operator>=(const StringPiece& x, const StringPiece& y)
+  {
+    return !(x < y);
+  }
+
+  std::ostream& operator<<(std::ostream& o, const StringPiece& piece);
+
+}; // namespace util
+
+#endif // UTIL_STRING_PIECE_H_
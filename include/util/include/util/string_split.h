@@ -17,32 +17,118 @@
 #ifndef UTIL_STRING_SPLIT_H_
 #define UTIL_STRING_SPLIT_H_
 
+#include <stddef.h>
+
+#include <functional>
+#include <iterator>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "util/basictypes.h"
+#include "util/char_set.h"
+#include "util/string_piece.h"
+
 namespace util
 {
+  class StringSearcher;
+
   // |str| should not be in a multi-byte encoding like Shift-JIS or GBK in which
   // the trailing byte of a multi-byte character can be in the ASCII range.
   // UTF-8, and other single/multi-byte ASCII-compatible encodings are OK.
   // Note: |c| must be in the ASCII range.
-  void SplitString(const std::string& str,
+  void SplitString(const StringPiece& str,
                    char c,
                    std::vector<std::string>* r);
 
-  bool SplitStringIntoKeyValues(const std::string& line,
+  bool SplitStringIntoKeyValues(const StringPiece& line,
                                 char key_value_delimiter,
                                 std::string* key, std::vector<std::string>* values);
 
-  bool SplitStringIntoKeyValuePairs(const std::string& line,
+  bool SplitStringIntoKeyValuePairs(const StringPiece& line,
                                     char key_value_delimiter,
                                     char key_value_pair_delimiter,
                                     std::vector<std::pair<std::string, std::string> >* kv_pairs);
 
+  // KeyValueMap maps StringPiece keys to StringPiece values, e.g. the
+  // parameters of a query string by name, without copying them: they must
+  // outlive the map.  It is an open addressing table with linear probing,
+  // kept at most half full.  Clear() keeps the table, so a map reused from
+  // request to request stops allocating once it is large enough.
+  class KeyValueMap
+  {
+ public:
+    KeyValueMap();
+    ~KeyValueMap();
+
+    // Adds |key| with |value|.  If |key| is already in the map, it keeps its
+    // value and false is returned.
+    bool Insert(const StringPiece& key, const StringPiece& value);
+
+    // Returns the value of |key|, or NULL if it is not in the map.
+    const StringPiece* Find(const StringPiece& key) const;
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    void Clear();
+
+ private:
+    struct Entry
+    {
+      StringPiece key;
+      StringPiece value;
+      uint64 hash;
+      // The entry is in use when this is the generation of the map.
+      uint32 generation;
+    };
+
+    // Returns the entry of |key|, or the free entry where it would go.
+    Entry* Lookup(const StringPiece& key, uint64 hash) const;
+
+    void Grow();
+
+    // The table, of a power of two size; Clear() moves to a new generation
+    // rather than going over it.
+    std::vector<Entry> entries_;
+    size_t size_;
+    uint32 generation_;
+  };
+
+  // Same as SplitStringIntoKeyValuePairs, without copying: the keys and
+  // values point into |line|.  |kv_pairs| is cleared first; the map form
+  // keeps the first value of a key seen twice.
+  bool SplitStringPieceIntoKeyValuePairs(
+      const StringPiece& line,
+      char key_value_delimiter,
+      char key_value_pair_delimiter,
+      std::vector<std::pair<StringPiece, StringPiece> >* kv_pairs);
+  bool SplitStringPieceIntoKeyValuePairs(const StringPiece& line,
+                                         char key_value_delimiter,
+                                         char key_value_pair_delimiter,
+                                         KeyValueMap* kv_pairs);
+
+  // Splits the query string |*query| ("a=1&b=x+y%21", without the '?')
+  // into its parameters.  Keys and values are percent-decoded, '+' as a
+  // space, in place in |*query|, which they point into afterwards.  A
+  // parameter without '=' has an empty value; empty ones are skipped.
+  // |params| is cleared first; the map form keeps the first value of a
+  // parameter given twice.
+  void ParseQueryString(
+      std::string* query,
+      std::vector<std::pair<StringPiece, StringPiece> >* params);
+  void ParseQueryString(std::string* query, KeyValueMap* params);
+
   // The same as SplitString, but use a substring delimiter instead of a char.
-  void SplitStringUsingSubstr(const std::string& str,
-                              const std::string& s,
+  void SplitStringUsingSubstr(const StringPiece& str,
+                              const StringPiece& s,
+                              std::vector<std::string>* r);
+
+  // Same as above, with the delimiter prepared once in |s|, which is worth
+  // it when many lines are split on the same delimiter.  A case-insensitive
+  // |s| matches the delimiter in either case.
+  void SplitStringUsingSubstr(const StringPiece& str,
+                              const StringSearcher& s,
                               std::vector<std::string>* r);
 
 
@@ -50,7 +136,7 @@ namespace util
   // the trailing byte of a multi-byte character can be in the ASCII range.
   // UTF-8, and other single/multi-byte ASCII-compatible encodings are OK.
   // Note: |c| must be in the ASCII range.
-  void SplitStringDontTrim(const std::string& str,
+  void SplitStringDontTrim(const StringPiece& str,
                            char c,
                            std::vector<std::string>* r);
 
@@ -62,8 +148,158 @@ namespace util
   // Splits the string along whitespace (where whitespace is the five space
   // characters defined by HTML 5). Each contiguous block of non-whitespace
   // characters is added to result.
-  void SplitStringAlongWhitespace(const std::string& str,
+  void SplitStringAlongWhitespace(const StringPiece& str,
                                   std::vector<std::string>* result);
+
+  // Same as the functions above, but the fields are StringPieces pointing
+  // into |str|, which must outlive them.  Nothing is copied: |r| is cleared
+  // but keeps its capacity, so splitting line after line into the same
+  // vector does not allocate once it is large enough.
+  void SplitStringPiece(const StringPiece& str,
+                        char c,
+                        std::vector<StringPiece>* r);
+  void SplitStringPieceDontTrim(const StringPiece& str,
+                                char c,
+                                std::vector<StringPiece>* r);
+  void SplitStringPieceUsingSubstr(const StringPiece& str,
+                                   const StringPiece& s,
+                                   std::vector<StringPiece>* r);
+  void SplitStringPieceUsingSubstr(const StringPiece& str,
+                                   const StringSearcher& s,
+                                   std::vector<StringPiece>* r);
+  void SplitStringPieceAlongWhitespace(const StringPiece& str,
+                                       std::vector<StringPiece>* result);
+
+  // Splits a large buffer of records ended by |delimiter|, e.g. the lines
+  // of a file, on |num_threads| threads; 0 uses one per processor.  Unlike
+  // SplitString(), a delimiter ends a record rather than separating two,
+  // so "a\nb\n" holds 2 records, and nothing is trimmed.
+  //
+  // The buffer is cut into one slice per thread, each cut moved forward to
+  // just after a delimiter so that no record straddles two slices.  Each
+  // thread finds the delimiters of its slice as SplitString() does.
+  // Buffers below a few MB use fewer threads, down to the calling thread
+  // alone.
+  //
+  // This form stores in (*record_ends)[i] the end offsets of the records
+  // of slice i: the offset of their delimiter, or the size of |str| for a
+  // last record without one.  Each record starts just after the end of the
+  // one before it, or at 0.
+  void SplitStringParallel(const StringPiece& str,
+                           char delimiter,
+                           std::vector<std::vector<size_t> >* record_ends,
+                           size_t num_threads = 0);
+
+  // Same as above, calling |callback| with each record and the index of
+  // its slice instead.  The calls for one slice come in order from one
+  // thread, while the slices run concurrently, so state kept per slice
+  // needs no lock.
+  void SplitStringParallel(
+      const StringPiece& str,
+      char delimiter,
+      const std::function<void(const StringPiece& record, size_t slice)>&
+          callback,
+      size_t num_threads = 0);
+
+  // Splits |str| lazily: each field is found when the loop asks for it, so a
+  // loop that stops early never scans the rest of |str|.
+  //   for (const StringPiece& field : StringSplitter(line, ','))
+  //   {
+  //     if (field == "id")
+  //       break;
+  //   }
+  // The delimiter is a char, a substring or any char of a CharSet.  With
+  // TRIM_WHITESPACE, ASCII whitespace is trimmed from each field; with
+  // SKIP_EMPTY, empty fields are not returned.  As with SplitString(), an
+  // empty (or, when trimming, all-whitespace) |str| has no fields.  The
+  // fields point into |str|, which must outlive them.
+  class StringSplitter
+  {
+ public:
+    enum Options
+    {
+      TRIM_WHITESPACE = 1 << 0,
+      SKIP_EMPTY      = 1 << 1,
+    };
+
+    StringSplitter(const StringPiece& str, char delimiter,
+                   int options = TRIM_WHITESPACE);
+    StringSplitter(const StringPiece& str, const StringPiece& delimiter,
+                   int options = TRIM_WHITESPACE);
+    StringSplitter(const StringPiece& str, const CharSet& delimiters,
+                   int options = TRIM_WHITESPACE);
+
+    // The runs of non-whitespace chars of |str|, as in
+    // SplitStringAlongWhitespace().
+    static StringSplitter Whitespace(const StringPiece& str);
+
+    class Iterator
+    {
+   public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef StringPiece value_type;
+      typedef ptrdiff_t difference_type;
+      typedef const StringPiece* pointer;
+      typedef const StringPiece& reference;
+
+      const StringPiece& operator*() const { return field_; }
+      const StringPiece* operator->() const { return &field_; }
+
+      Iterator& operator++()
+      {
+        splitter_->Next(this);
+        return *this;
+      }
+
+      Iterator operator++(int)
+      {
+        Iterator old = *this;
+        splitter_->Next(this);
+        return old;
+      }
+
+      bool operator==(const Iterator& other) const
+      {
+        return next_ == other.next_ && last_ == other.last_;
+      }
+      bool operator!=(const Iterator& other) const
+      {
+        return !(*this == other);
+      }
+
+   private:
+      friend class StringSplitter;
+
+      const StringSplitter* splitter_;
+      StringPiece field_;
+      // Where the field after |field_| starts, or NULL past the end.
+      const char* next_;
+      // Whether |field_| ends at the end of the string.
+      bool last_;
+    };
+
+    Iterator begin() const;
+    Iterator end() const;
+
+ private:
+    enum Kind
+    {
+      CHAR,
+      SUBSTRING,
+      CHAR_SET,
+    };
+
+    // Finds the next field at or after |next|, skipping empty fields if
+    // required, and moves |iter| to it or to end().
+    void Next(Iterator* iter) const;
+
+    StringPiece str_;
+    Kind kind_;
+    char delimiter_;
+    StringPiece substring_;
+    CharSet delimiters_;
+    int options_;
+  };
   
   
 }; // namespace util
@@ -17,9 +17,14 @@
 #ifndef UTIL_STRING_TOKENIZER_H_
 #define UTIL_STRING_TOKENIZER_H_
 
+#include <stddef.h>
+
 #include <algorithm>
 #include <string>
 
+#include "util/char_set.h"
+#include "util/string_piece.h"
+
 namespace util
 {
   // StringTokenizerT is a simple string tokenizer class.  It works like an
@@ -179,14 +184,57 @@ namespace util
       token_end_ = string_begin;
       end_ = string_end;
       delims_ = delims;
+      delim_set_ = MakeDelimSet(delims);
       options_ = 0;
       token_is_delim_ = false;
     }
 
+    // Byte strings keep their delimiters as a CharSet as well, for the scans
+    // in QuickGetNext(); other strings leave it empty.
+    static CharSet MakeDelimSet(const std::string& delims)
+    {
+      return CharSet(StringPiece(delims));
+    }
+    template <class other>
+        static CharSet MakeDelimSet(const other&)
+    {
+      return CharSet();
+    }
+
     // Implementation of GetNext() for when we have no quote characters. We have
     // two separate implementations because AdvanceOne() is a hot spot in large
     // text files with large tokens.
+    // Byte strings find their tokens with CharSet scans, which test 16 or 32
+    // bytes at a time; other strings look up each char in |delims_|.
     bool QuickGetNext()
+    {
+      return QuickGetNext(static_cast<const char_type*>(NULL));
+    }
+
+    bool QuickGetNext(const char*)
+    {
+      token_is_delim_ = false;
+      if (token_end_ == end_)
+      {
+        token_begin_ = token_end_;
+        return false;
+      }
+      const char* p = &*token_end_;
+      const char* const end = p + (end_ - token_end_);
+      const char* begin = delim_set_.Scan(p, end, false);
+      token_begin_ = token_end_ + (begin - p);
+      if (begin == end)
+      {
+        token_end_ = token_begin_;
+        return false;
+      }
+      token_end_ = token_begin_ +
+          (delim_set_.Scan(begin + 1, end, true) - begin);
+      return true;
+    }
+
+    template <class other>
+        bool QuickGetNext(const other*)
     {
       token_is_delim_ = false;
       for (;;)
@@ -280,6 +328,7 @@ namespace util
     const_iterator token_end_;
     const_iterator end_;
     str delims_;
+    CharSet delim_set_;
     str quotes_;
     int options_;
     bool token_is_delim_;
@@ -19,8 +19,12 @@
 
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "util/char_set.h"
+#include "util/string_piece.h"
+
 namespace util
 {
   extern const wchar_t kWhitespaceWide[];
@@ -62,6 +66,21 @@ namespace util
                     const std::string& replace_with,
                     std::string* output);
 
+  // Same as above, but replaces the characters of |str| in place.  Growing
+  // |str| moves the untouched runs back to front, so |str| is reallocated at
+  // most once, and not at all when its capacity suffices.
+  bool ReplaceChars(std::string* str,
+                    const char replace_chars[],
+                    const StringPiece& replace_with);
+
+  // The rvalue forms of the copying functions in this file move |input| into
+  // |output| and work on it in place, reusing the caller's buffer instead of
+  // copying it.
+  bool ReplaceChars(std::string&& input,
+                    const char replace_chars[],
+                    const std::string& replace_with,
+                    std::string* output);
+
   // Removes characters in |remove_chars| from anywhere in |input|.  Returns true
   // if any characters were removed.  |remove_chars| must be null-terminated.
   // NOTE: Safe to use the same variable for both |input| and |output|.
@@ -72,6 +91,16 @@ namespace util
   bool RemoveChars(const std::string& input,
                    const std::string &remove,
                    std::string* output);
+  bool RemoveChars(std::string&& input,
+                   const char remove_chars[],
+                   std::string* output);
+
+  // Same as above, but removes the characters from |str| in place without
+  // allocating.  This version uses a pointer to clearly differentiate it from
+  // the copying variant.
+  bool RemoveChars(std::string* str, const char remove_chars[]);
+
+  bool RemoveChars(std::string* str, const std::string &remove);
 
   // Removes characters in |trim_chars| from the beginning and end of |input|.
   // |trim_chars| must be null-terminated.
@@ -79,12 +108,24 @@ namespace util
   bool TrimString(const std::string& input,
                   const char trim_chars[],
                   std::string* output);
+  bool TrimString(const std::string& input,
+                  const CharSet& trim_chars,
+                  std::string* output);
+  bool TrimString(std::string&& input,
+                  const CharSet& trim_chars,
+                  std::string* output);
+
+  // Trims |str| in place.  Nothing is copied or allocated.
+  bool TrimString(std::string* str, const char trim_chars[]);
+  bool TrimString(std::string* str, const CharSet& trim_chars);
 
   // Trims any whitespace from either end of the input string.  Returns where
   // whitespace was found.
   // The non-wide version has two functions:
   // * TrimWhitespaceASCII()
   //   This function is for ASCII strings and only looks for ASCII whitespace;
+  // * TrimWhitespace()
+  //   This function is for UTF-8 strings and looks for Unicode whitespace.
   // Please choose the best one according to your usage.
   // NOTE: Safe to use the same variable for both input and output.
   enum TrimPositions
@@ -99,11 +140,37 @@ namespace util
                                     TrimPositions positions,
                                     std::string* output);
 
-  // Deprecated. This function is only for backward compatibility and calls
-  // TrimWhitespaceASCII().
+  TrimPositions TrimWhitespaceASCII(std::string&& input,
+                                    TrimPositions positions,
+                                    std::string* output);
+
+  // Trims |str| in place.  Nothing is copied or allocated.
+  TrimPositions TrimWhitespaceASCII(std::string* str, TrimPositions positions);
+
+  // Returns the part of |input| left after trimming, pointing into |input|'s
+  // memory.  Nothing is copied or allocated.
+  StringPiece TrimWhitespaceASCII(const StringPiece& input,
+                                  TrimPositions positions);
+
+  // Same as TrimWhitespaceASCII(), for UTF-8 input: also trims the non-ASCII
+  // whitespace of kWhitespaceWide, such as NBSP (U+00A0) and the ideographic
+  // space (U+3000).  Only non-ASCII bytes are decoded, so pure ASCII input is
+  // about as fast as with TrimWhitespaceASCII().
   TrimPositions TrimWhitespace(const std::string& input,
                                TrimPositions positions,
                                std::string* output);
+  TrimPositions TrimWhitespace(std::string&& input,
+                               TrimPositions positions,
+                               std::string* output);
+  TrimPositions TrimWhitespace(std::string* str, TrimPositions positions);
+  StringPiece TrimWhitespace(const StringPiece& input,
+                             TrimPositions positions);
+
+  // Returns the part of |input| left after trimming |trim_chars| from
+  // |positions|, pointing into |input|'s memory.
+  StringPiece TrimString(const StringPiece& input,
+                         const CharSet& trim_chars,
+                         TrimPositions positions = TRIM_ALL);
 
   
   // Searches  for CR or LF characters.  Removes all contiguous whitespace
@@ -117,8 +184,33 @@ namespace util
   std::string CollapseWhitespaceASCII(const std::string& text,
                                       bool trim_sequences_with_line_breaks);
 
+  std::string CollapseWhitespaceASCII(std::string&& text,
+                                      bool trim_sequences_with_line_breaks);
+
+  // Same as above, but collapses |text| in place.
+  void CollapseWhitespaceASCII(std::string* text,
+                               bool trim_sequences_with_line_breaks);
+
+  // Same as CollapseWhitespaceASCII(), for UTF-8 input: sequences of any
+  // kWhitespaceWide characters are collapsed, to a single ASCII space.
+  std::string CollapseWhitespace(const std::string& text,
+                                 bool trim_sequences_with_line_breaks);
+  std::string CollapseWhitespace(std::string&& text,
+                                 bool trim_sequences_with_line_breaks);
+  void CollapseWhitespace(std::string* text,
+                          bool trim_sequences_with_line_breaks);
+
   // Converts the elements of the given string.  This version uses a pointer to
   // clearly differentiate it from the non-pointer variant.
+  // The std::string versions are vectorized; the templates below cover the
+  // other string types.
+  void StringToLowerASCII(std::string* s);
+  std::string StringToLowerASCII(const std::string& s);
+  std::string StringToLowerASCII(std::string&& s);
+  void StringToUpperASCII(std::string* s);
+  std::string StringToUpperASCII(const std::string& s);
+  std::string StringToUpperASCII(std::string&& s);
+
   template <class str>
       inline void StringToLowerASCII(str* s)
   {
@@ -166,23 +258,182 @@ namespace util
   //
   // e.g. @_input = "11223344" @_step=2
   //      after Reverse() @_output="44332211"
+  // A last partial group goes first: "AAABBBCC" with @_step=3 gives
+  // "CCBBBAAA".  Nothing is changed if @_step is 0 or not less than the
+  // length.
+  // NOTE: Safe to use the same variable for both @_input and @_output.
   // 
-  void Reverse(std::string _input, std::string *_output, const size_t _step);
+  void Reverse(const std::string& _input, std::string *_output,
+               const size_t _step);
+  void Reverse(std::string&& _input, std::string *_output,
+               const size_t _step);
+
+  // Same as above, reversing the |step|-byte groups of |str| (or of the
+  // |length| bytes at |data|) in place, in O(n) without allocating.  Steps
+  // of 1, 2, 4 and 8 swap 16 or 32 bytes at a time with SSE4.2 or AVX2 byte
+  // shuffles.  For the byte order of binary values, see util/sys_byteorder.h.
+  void Reverse(std::string* str, size_t step);
+  void Reverse(char* data, size_t length, size_t step);
 
   // 
   // @_ip     = XXX.XXX.XXX.XXX
   // @_output = XX XX XX XX
+  // An IPv6 @_ip gives its 16 bytes the same way.
   //
   // return false in case of @_ip is illegal
   // otherwise return true
   // 
-  bool IpToHexString(const std::string &_ip, std::string *_hex_string);
+  bool IpToHexString(const StringPiece& _ip, std::string *_hex_string);
 
   // 
   // @_hex_string = XX XX XX XX
   // @_ip         = XXX.XXX.XXX.XXX
+  // 16 bytes give an IPv6 @_ip.
   // 
-  bool HexStringToIp(std::string _hex_string, std::string *_ip);
+  bool HexStringToIp(const StringPiece& _hex_string, std::string *_ip);
+
+  // Escaping codecs.  All of them append to |output|, which is grown once to
+  // its final size, and copy the runs of bytes that need no escaping with
+  // memcpy; those runs are found 16 or 32 bytes at a time (see CharSet).
+  // |input| must not point into |output|.
+
+  // Escapes |input| as the body of a C string literal: \n, \r, \t, \", \'
+  // and \\ get their usual escape, the other control and non-ASCII bytes are
+  // written as three octal digits (\ooo) so that no following digit can be
+  // taken as part of the escape.
+  void EscapeC(const StringPiece& input, std::string* output);
+
+  // Reverses EscapeC(), also accepting \a, \b, \f, \v, \?, one to three
+  // octal digits and \xHH.  Returns false, leaving |output| as it was, on an
+  // unknown or truncated escape sequence.
+  bool UnescapeC(const StringPiece& input, std::string* output);
+
+  // Escapes |input| as the body of a JSON string (RFC 8259): " and \ are
+  // escaped, control chars become \b, \f, \n, \r, \t or \u00XX.  Non-ASCII
+  // bytes are copied unchanged, so UTF-8 text stays UTF-8.
+  void EscapeJSONString(const StringPiece& input, std::string* output);
+
+  // Reverses EscapeJSONString(): \uXXXX escapes, including surrogate pairs,
+  // are written as UTF-8.  Returns false, leaving |output| as it was, on an
+  // invalid escape sequence or an unpaired surrogate.
+  bool UnescapeJSONString(const StringPiece& input, std::string* output);
+
+  // Percent-encodes every byte of |input| but the RFC 3986 unreserved chars
+  // (A-Z a-z 0-9 - . _ ~).  If |space_as_plus| is true, spaces are written as
+  // '+' as in application/x-www-form-urlencoded.
+  void EscapePercent(const StringPiece& input, std::string* output,
+                     bool space_as_plus = false);
+
+  // Decodes the %XX sequences of |input|; a '%' not followed by two hex
+  // digits is copied as is.  If |plus_as_space| is true, '+' decodes to a
+  // space.
+  void UnescapePercent(const StringPiece& input, std::string* output,
+                       bool plus_as_space = false);
+
+  // Same as above, in place: the |length| bytes at |data| are decoded into
+  // themselves, which they never outgrow, and the decoded length is
+  // returned.
+  size_t UnescapePercentInPlace(char* data, size_t length,
+                                bool plus_as_space = false);
+
+  // MultiReplacer replaces many substrings of a text in a single pass.  The
+  // (needle, replacement) pairs are compiled into an Aho-Corasick automaton,
+  // so the cost of a rewrite is linear in the text whatever the number of
+  // needles.  Matches are chosen leftmost-longest: of all the needles found,
+  // the one starting first wins, and of those starting at the same position,
+  // the longest one.  Replaced text is not scanned again.
+  //
+  // Empty needles are ignored; for duplicate needles the first pair wins.
+  //
+  // EXAMPLE:
+  //
+  //   std::vector<std::pair<std::string, std::string> > pairs;
+  //   pairs.push_back(std::make_pair("password=", "password=***"));
+  //   pairs.push_back(std::make_pair("token", "***"));
+  //   MultiReplacer replacer(pairs);
+  //   std::string line;
+  //   replacer.Replace("token=1 password=2", &line);
+  //
+  // Output:
+  //
+  //   ***=1 password=***2
+  //
+  // Text arriving in chunks goes through a MultiReplacer::Stream, which holds
+  // back the few trailing bytes that may still be part of a match.
+  class MultiReplacer
+  {
+ public:
+    explicit MultiReplacer(
+        const std::vector<std::pair<std::string, std::string> >& replacements);
+
+    // Writes |input| with every match replaced into |output| and returns the
+    // number of replacements.
+    // NOTE: Safe to use the same variable for both |input| and |output|.
+    size_t Replace(const std::string& input, std::string* output) const;
+
+    class Stream
+    {
+   public:
+      // |replacer| must outlive the stream.
+      explicit Stream(const MultiReplacer* replacer);
+
+      // Feeds the next chunk of text and appends to |output| everything that
+      // can no longer be affected by later chunks.  Returns the number of
+      // replacements made.
+      size_t Append(const char* data, size_t length, std::string* output);
+      size_t Append(const std::string& data, std::string* output);
+
+      // Flushes the held back text to |output| at the end of the input.
+      size_t Finish(std::string* output);
+
+   private:
+      const MultiReplacer* replacer_;
+      std::string pending_;
+    };
+
+ private:
+    struct Match
+    {
+      size_t begin;
+      size_t end;
+      size_t pattern;
+    };
+
+    // Finds the leftmost-longest match in [pos, length) of |data|.  When
+    // |at_end| is false, more text may follow |data|, so a match is only
+    // reported once no later byte can change the decision.  Returns false if
+    // no match was found; |*safe_end| is then set to the position up to which
+    // |data| is known not to be part of any match.
+    bool FindNext(const char* data, size_t length, size_t pos, bool at_end,
+                  Match* match, size_t* safe_end) const;
+
+    // Runs FindNext() over |data| and appends the rewritten text to |output|.
+    // Returns the number of replacements; |*consumed| is set to the length of
+    // the prefix of |data| that was written out.
+    size_t ReplaceInto(const char* data, size_t length, bool at_end,
+                       std::string* output, size_t* consumed) const;
+
+    size_t NextState(size_t state, unsigned char c) const
+    {
+      return transitions_[state * num_classes_ + byte_classes_[c]];
+    }
+
+    std::vector<std::pair<std::string, std::string> > patterns_;
+
+    // Bytes that appear in no needle share class 0; every other byte has a
+    // class of its own.  The DFA has one row of |num_classes_| entries per
+    // state, the root being state 0.
+    unsigned char byte_classes_[256];
+    size_t num_classes_;
+    std::vector<unsigned int> transitions_;
+
+    // For each state: the length of the text it stands for, and the longest
+    // needle that is a suffix of it (kNoPattern if none).
+    std::vector<unsigned int> depth_;
+    std::vector<size_t> match_;
+
+    static const size_t kNoPattern = static_cast<size_t>(-1);
+  };
 
   // ------------------------------------------------------------
   // --------------------- Update End -------------------------
@@ -255,18 +506,24 @@ namespace util
 
   // Returns true if the passed string is empty or contains only white-space
   // characters.
-  bool ContainsOnlyWhitespaceASCII(const std::string& str);
+  bool ContainsOnlyWhitespaceASCII(const StringPiece& str);
+
+  // Returns true if |str| contains only 7-bit ASCII characters.  An empty
+  // string is ASCII.
+  bool IsStringASCII(const StringPiece& str);
 
   // Returns true if |input| is empty or contains only characters found in
   // |characters|.
-  bool ContainsOnlyChars(const std::string& input,
-                         const std::string& characters);
+  bool ContainsOnlyChars(const StringPiece& input,
+                         const StringPiece& characters);
+  bool ContainsOnlyChars(const StringPiece& input,
+                         const CharSet& characters);
 
   // Compare the lower-case form of the given string against the given ASCII
   // string.  This is useful for doing checking if an input string matches some
   // token, and it is optimized to avoid intermediate string copies.  This API is
   // borrowed from the equivalent APIs in Mozilla.
-  bool LowerCaseEqualsASCII(const std::string& a, const char* b);
+  bool LowerCaseEqualsASCII(const StringPiece& a, const char* b);
 
   // Same thing, but with string iterators instead.
   bool LowerCaseEqualsASCII(std::string::const_iterator a_begin,
@@ -276,28 +533,177 @@ namespace util
                             const char* a_end,
                             const char* b);
 
+  // Returns true if |a| and |b| are equal once ASCII letters are lower-cased.
+  // Other bytes must match exactly.
+  bool EqualsCaseInsensitiveASCII(const StringPiece& a, const StringPiece& b);
+
   // Performs a case-sensitive string compare. The behavior is undefined if both
   // strings are not ASCII.
   // Returns true if str starts with search, or false otherwise.
-  bool StartsWithASCII(const std::string& str,
-                       const std::string& search,
+  bool StartsWithASCII(const StringPiece& str,
+                       const StringPiece& search,
                        bool case_sensitive);
 
   // Returns true if str ends with search, or false otherwise.
-  bool EndsWith(const std::string& str,
-                const std::string& search,
+  bool EndsWith(const StringPiece& str,
+                const StringPiece& search,
+                bool case_sensitive);
+
+  // Returns the position of the first occurrence of |search| in |text| at or
+  // after |pos|, or StringPiece::npos.  An empty |search| is found at |pos|.
+  // When |case_sensitive| is false, ASCII letters match either case.
+  size_t Find(const StringPiece& text,
+              const StringPiece& search,
+              size_t pos,
+              bool case_sensitive);
+
+  // Returns true if |text| contains |search|.
+  bool Contains(const StringPiece& text,
+                const StringPiece& search,
                 bool case_sensitive);
 
+  // Fills |positions| with the start of every non-overlapping occurrence of
+  // |search| in |text|, scanning left to right, and returns their number.
+  size_t FindAll(const StringPiece& text,
+                 const StringPiece& search,
+                 bool case_sensitive,
+                 std::vector<size_t>* positions);
+
+  // StringSearcher does the same for a pattern that is looked for many times:
+  // the pattern is copied and lower-cased once for case-insensitive
+  // searches, and the filter on its first and last byte that picks the
+  // positions worth comparing is built once too.
+  class StringSearcher
+  {
+ public:
+    // The first/last byte filter of a search: a position can only match if
+    // its first byte, or'ed with |first_mask|, is |first_value|, and the same
+    // for the last byte.  With |fold| the comparison ignores case, and with
+    // |fold_search| the search itself still has to be lower-cased.
+    struct Filter
+    {
+      Filter() {}
+      Filter(const char* search, size_t search_length, bool fold,
+             bool fold_search);
+
+      char first_value;
+      char first_mask;
+      char last_value;
+      char last_mask;
+      bool fold;
+      bool fold_search;
+    };
+
+    StringSearcher(const StringPiece& search, bool case_sensitive);
+
+    size_t Find(const StringPiece& text, size_t pos) const;
+    bool Contains(const StringPiece& text) const;
+    size_t FindAll(const StringPiece& text,
+                   std::vector<size_t>* positions) const;
+
+    // Stores in |offsets| the starts of the first |max_count|
+    // non-overlapping occurrences at or after |pos|, and returns how many
+    // were stored; call it again from after the last one for the next
+    // batch.  Returns 0 for an empty search.
+    size_t FindAll(const StringPiece& text,
+                   size_t pos,
+                   size_t* offsets,
+                   size_t max_count) const;
+
+    const std::string& search() const { return search_; }
+    bool case_sensitive() const { return case_sensitive_; }
+
+ private:
+    std::string search_;
+    bool case_sensitive_;
+    Filter filter_;
+  };
+
+  // Returns the Levenshtein distance between |a| and |b|: the smallest number
+  // of byte insertions, deletions and substitutions turning one into the
+  // other.  Myers' bit-parallel algorithm handles 64 rows of the distance
+  // matrix per step, which makes it O(n * ceil(m / 64)) for lengths n >= m.
+  size_t EditDistance(const StringPiece& a, const StringPiece& b);
+
+  // Same as above, but stops as soon as the distance is known to be larger
+  // than |max_distance| and returns |max_distance| + 1 then.
+  size_t BoundedEditDistance(const StringPiece& a,
+                             const StringPiece& b,
+                             size_t max_distance);
+
+  // Fills |matches| with the indices, in increasing order, of the
+  // |candidates| at most |max_distance| edits away from |query|, and returns
+  // their number.  The query is preprocessed once, and the candidates are
+  // split across up to |num_threads| threads; 0 uses one per processor.
+  // Each thread gets at least 1024 candidates, so shorter lists use fewer
+  // threads, down to the calling thread alone.
+  size_t FindWithinEditDistance(const StringPiece& query,
+                                const std::vector<std::string>& candidates,
+                                size_t max_distance,
+                                std::vector<size_t>* matches,
+                                size_t num_threads = 0);
+
   // Splits a string into its fields delimited by any of the characters in
   // |delimiters|.  Each field is added to the |tokens| vector.  Returns the
-  // number of tokens found.
-  size_t Tokenize(const std::string& str,
-                  const std::string& delimiters,
+  // number of tokens found.  The StringPiece tokens point into |str|.
+  size_t Tokenize(const StringPiece& str,
+                  const StringPiece& delimiters,
                   std::vector<std::string>* tokens);
+  size_t Tokenize(const StringPiece& str,
+                  const CharSet& delimiters,
+                  std::vector<std::string>* tokens);
+  size_t Tokenize(const StringPiece& str,
+                  const StringPiece& delimiters,
+                  std::vector<StringPiece>* tokens);
+  size_t Tokenize(const StringPiece& str,
+                  const CharSet& delimiters,
+                  std::vector<StringPiece>* tokens);
 
   
   // Does the opposite of SplitString().
   std::string JoinString(const std::vector<std::string>& parts, char s);
+  std::string JoinString(const std::vector<std::string>& parts,
+                         const StringPiece& separator);
+  std::string JoinString(const std::vector<StringPiece>& parts,
+                         const StringPiece& separator);
+
+  // Same as above for the elements of [first, last), which may be anything a
+  // StringPiece can be built from.  The range is walked twice: once to size
+  // the result, which is allocated exactly once, and once to fill it.
+  template <typename Iterator>
+      std::string JoinString(Iterator first, Iterator last,
+                             const StringPiece& separator)
+  {
+    if (first == last)
+      return std::string();
+
+    size_t length = 0;
+    size_t count = 0;
+    for (Iterator iter = first; iter != last; ++iter, ++count)
+      length += StringPiece(*iter).size();
+    length += (count - 1) * separator.size();
+
+    std::string result;
+    result.resize(length);
+    if (length == 0)
+      return result;
+    char* out = &result[0];
+    for (bool first_part = true; first != last; ++first, first_part = false)
+    {
+      if (!first_part && !separator.empty())
+      {
+        memcpy(out, separator.data(), separator.size());
+        out += separator.size();
+      }
+      const StringPiece part(*first);
+      if (!part.empty())
+      {
+        memcpy(out, part.data(), part.size());
+        out += part.size();
+      }
+    }
+    return result;
+  }
 
 
   // Returns true if the string passed in matches the pattern. The pattern
@@ -305,8 +711,8 @@ namespace util
   // The backslash character (\) is an escape character for * and ?
   // We limit the patterns to having a max of 16 * or ? characters.
   // ? matches 0 or 1 character, while * matches 0 or more characters.
-  bool MatchPattern(const std::string& string,
-                    const std::string& pattern);
+  bool MatchPattern(const StringPiece& string,
+                    const StringPiece& pattern);
 
   template<typename T>
       void PrintVector(const std::vector<T> &_vec)
@@ -346,12 +752,12 @@ namespace util
 
   // 
   // @_ip    = XXX.XXX.XXX.XXX
-  // or @_ip = XX XX XX XX
+  // or an IPv6 address, see util/ip_address.h
   //
   // return false if @_ip is invalid
   // otherwise return true
   // 
-  bool IsIp(const std::string &_ip);
+  bool IsIp(const StringPiece& _ip);
 
   // 
   // @_mac    = XX:XX:XX:XX:XX:XX
@@ -360,7 +766,35 @@ namespace util
   // return false if @_mac is invalid
   // otherwise return true
   // 
-  bool IsMac(const std::string &_mac);
+  bool IsMac(const StringPiece& _mac);
+
+  // The length of "XX:XX:XX:XX:XX:XX".
+  const size_t kMacAddressStringLength = 17;
+
+  // Parses a MAC address written as six pairs of hex digits of either case,
+  // separated by ':', '-' or ' ' (the same one throughout), into the 48-bit
+  // integer 0xXXXXXXXXXXXX.  The whole address is checked and decoded at
+  // once with SSE4.2 byte shuffles when available.
+  bool ParseMacAddress(const StringPiece& text, uint64* mac);
+
+  // Writes the 48-bit |mac| to |out| as kMacAddressStringLength chars (no
+  // '\0'), with |separator| between the bytes and upper or lower case hex
+  // digits.
+  void FormatMacAddress(uint64 mac, char separator, bool upper_case,
+                        char* out);
+  std::string FormatMacAddress(uint64 mac, char separator = ':',
+                               bool upper_case = true);
+
+  // Batch forms, for a column of addresses.  ParseMacAddressBatch() stores
+  // each of the |count| |texts| in |macs| and whether it was valid in
+  // |valid| (an invalid text gives 0), and returns the number of valid
+  // addresses.  FormatMacAddressBatch() appends each address followed by
+  // |delimiter| to |output|, which is grown once.
+  size_t ParseMacAddressBatch(const StringPiece* texts, size_t count,
+                              uint64* macs, bool* valid);
+  void FormatMacAddressBatch(const uint64* macs, size_t count,
+                             char separator, bool upper_case, char delimiter,
+                             std::string* output);
 
   // 
   // @_port works only for TCP
@@ -0,0 +1,99 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+// This header defines cross-platform ByteSwap() implementations for 16, 32
+// and 64-bit values, and NetToHostXX() / HostToNetXX() functions equivalent
+// to the traditional ntohX() and htonX() functions, plus byte swapping of
+// whole buffers.
+
+#ifndef UTIL_SYS_BYTEORDER_H_
+#define UTIL_SYS_BYTEORDER_H_
+
+#include <stddef.h>
+
+#include "util/basictypes.h"
+
+namespace util
+{
+  // Returns a value with all bytes in |x| swapped, i.e. reverses the
+  // endianness.
+  inline uint16 ByteSwap(uint16 x)
+  {
+    return __builtin_bswap16(x);
+  }
+
+  inline uint32 ByteSwap(uint32 x)
+  {
+    return __builtin_bswap32(x);
+  }
+
+  inline uint64 ByteSwap(uint64 x)
+  {
+    return __builtin_bswap64(x);
+  }
+
+  // Converts the bytes in |x| from host order (endianness) to little endian,
+  // and back: a no-op on x86.
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  inline uint16 ByteSwapToLE16(uint16 x) { return x; }
+  inline uint32 ByteSwapToLE32(uint32 x) { return x; }
+  inline uint64 ByteSwapToLE64(uint64 x) { return x; }
+
+  // Converts the bytes in |x| from network to host order (endianness), and
+  // returns the result.
+  inline uint16 NetToHost16(uint16 x) { return ByteSwap(x); }
+  inline uint32 NetToHost32(uint32 x) { return ByteSwap(x); }
+  inline uint64 NetToHost64(uint64 x) { return ByteSwap(x); }
+#else
+  inline uint16 ByteSwapToLE16(uint16 x) { return ByteSwap(x); }
+  inline uint32 ByteSwapToLE32(uint32 x) { return ByteSwap(x); }
+  inline uint64 ByteSwapToLE64(uint64 x) { return ByteSwap(x); }
+
+  inline uint16 NetToHost16(uint16 x) { return x; }
+  inline uint32 NetToHost32(uint32 x) { return x; }
+  inline uint64 NetToHost64(uint64 x) { return x; }
+#endif
+
+  // Converts the bytes in |x| from host to network order (endianness), and
+  // returns the result.
+  inline uint16 HostToNet16(uint16 x) { return NetToHost16(x); }
+  inline uint32 HostToNet32(uint32 x) { return NetToHost32(x); }
+  inline uint64 HostToNet64(uint64 x) { return NetToHost64(x); }
+
+  // Reverses the bytes of each |element_size|-byte element of the |size|
+  // bytes at |data|, e.g. to convert an array of big endian integers read
+  // from the network or a file.  |data| needs no alignment; a last partial
+  // element is left as is.  2, 4 and 8-byte elements are swapped 16 or 32
+  // bytes at a time with SSE4.2 or AVX2 byte shuffles.
+  void ByteSwapBuffer(void* data, size_t size, size_t element_size);
+
+  // Same as ByteSwapBuffer() on a host order buffer, for a network order
+  // (big endian) result, and back: a no-op on big endian machines.
+  inline void HostToNetBuffer(void* data, size_t size, size_t element_size)
+  {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    ByteSwapBuffer(data, size, element_size);
+#endif
+  }
+
+  inline void NetToHostBuffer(void* data, size_t size, size_t element_size)
+  {
+    HostToNetBuffer(data, size, element_size);
+  }
+
+}; // namespace util
+
+#endif // UTIL_SYS_BYTEORDER_H_
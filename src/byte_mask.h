@@ -0,0 +1,84 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+// Internal to libutil: shared by the sources that scan 64-byte blocks.
+
+#ifndef UTIL_BYTE_MASK_H_
+#define UTIL_BYTE_MASK_H_
+
+#include "util/basictypes.h"
+#include "util/cpu.h"
+
+#if defined(HAVE_TARGET_ATTRIBUTE)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace util
+{
+  // Bit i of the result is set when byte i of the 64 bytes at |p| is |c|.
+  // The AVX2 and SSE2 forms are for loops compiled for that instruction
+  // set, where they are inlined; ByteMask64() picks one on each call.
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  TARGET_AVX2
+  static inline uint64 ByteMask64AVX2(const char* p, char c)
+  {
+    const __m256i needle = _mm256_set1_epi8(c);
+    const uint32 low = _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), needle));
+    const uint32 high = _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32)),
+        needle));
+    return (static_cast<uint64>(high) << 32) | low;
+  }
+#endif
+
+#if defined(__SSE2__)
+  static inline uint64 ByteMask64SSE2(const char* p, char c)
+  {
+    const __m128i needle = _mm_set1_epi8(c);
+    uint64 mask = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+      const __m128i chunk =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+      mask |= static_cast<uint64>(static_cast<uint16>(
+          _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)))) << (16 * i);
+    }
+    return mask;
+  }
+#endif
+
+  static inline uint64 ByteMask64(const char* p, char c)
+  {
+#if defined(HAVE_TARGET_ATTRIBUTE)
+    if (CPUHasAVX2())
+      return ByteMask64AVX2(p, c);
+#endif
+#if defined(__SSE2__)
+    return ByteMask64SSE2(p, c);
+#else
+    uint64 mask = 0;
+    for (int i = 0; i < 64; ++i)
+      mask |= static_cast<uint64>(p[i] == c) << i;
+    return mask;
+#endif
+  }
+
+}; // namespace util
+
+#endif // UTIL_BYTE_MASK_H_
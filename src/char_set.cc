@@ -0,0 +1,405 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/char_set.h"
+
+#include "util/cpu.h"
+
+#if defined(HAVE_TARGET_ATTRIBUTE)
+#include <immintrin.h>
+#endif
+
+namespace util
+{
+
+CharSet::CharSet(const StringPiece& chars)
+    : words_{0, 0, 0, 0}
+{
+  for (StringPiece::const_iterator c = chars.begin(); c != chars.end(); ++c)
+    Add(*c);
+}
+
+#if defined(HAVE_TARGET_ATTRIBUTE)
+// Set membership of 16 (32) bytes at once: PSHUFB looks up the table entry of
+// each byte by its low nibble, a second PSHUFB turns bits 4 to 6 of the byte
+// into the bit to test in that entry.  PSHUFB yields 0 for indices with the
+// top bit set, which selects between the table of bytes below 0x80 and the
+// table of the others.  The result has 0xFF in the bytes of |chunk| that are
+// members.
+TARGET_SSE42
+static inline __m128i MemberBytesSSE42(__m128i chunk, __m128i low_table,
+                                       __m128i high_table)
+{
+  const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                     1, 2, 4, 8, 16, 32, 64, -128);
+  const __m128i entry = _mm_or_si128(
+      _mm_shuffle_epi8(low_table, chunk),
+      _mm_shuffle_epi8(high_table,
+                       _mm_xor_si128(chunk, _mm_set1_epi8(-128))));
+  const __m128i bit = _mm_shuffle_epi8(
+      bits, _mm_and_si128(_mm_srli_epi16(chunk, 4), _mm_set1_epi8(0x0F)));
+  return _mm_cmpeq_epi8(_mm_and_si128(entry, bit), bit);
+}
+
+TARGET_SSE42
+static inline unsigned int MembersSSE42(const char* p, __m128i low_table,
+                                        __m128i high_table)
+{
+  return _mm_movemask_epi8(MemberBytesSSE42(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), low_table,
+      high_table));
+}
+
+TARGET_AVX2
+static inline __m256i MemberBytesAVX2(__m256i chunk, __m256i low_table,
+                                      __m256i high_table)
+{
+  const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                        1, 2, 4, 8, 16, 32, 64, -128,
+                                        1, 2, 4, 8, 16, 32, 64, -128,
+                                        1, 2, 4, 8, 16, 32, 64, -128);
+  const __m256i entry = _mm256_or_si256(
+      _mm256_shuffle_epi8(low_table, chunk),
+      _mm256_shuffle_epi8(high_table,
+                          _mm256_xor_si256(chunk, _mm256_set1_epi8(-128))));
+  const __m256i bit = _mm256_shuffle_epi8(
+      bits,
+      _mm256_and_si256(_mm256_srli_epi16(chunk, 4), _mm256_set1_epi8(0x0F)));
+  return _mm256_cmpeq_epi8(_mm256_and_si256(entry, bit), bit);
+}
+
+TARGET_AVX2
+static inline unsigned int MembersAVX2(const char* p, __m256i low_table,
+                                       __m256i high_table)
+{
+  return _mm256_movemask_epi8(MemberBytesAVX2(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), low_table,
+      high_table));
+}
+
+// The block scans below skip the 16 (32) byte blocks at the front (back) of
+// [begin, end) that hold no byte of the requested kind, and return where the
+// caller has to carry on.
+TARGET_SSE42
+static const char* ScanSSE42(const uint64* words, const char* p,
+                             const char* end, bool in_set)
+{
+  const __m128i low_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+  const __m128i high_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2));
+  const unsigned int flip = in_set ? 0 : 0xFFFFu;
+  for (; end - p >= 16; p += 16)
+  {
+    const unsigned int mask =
+        MembersSSE42(p, low_table, high_table) ^ flip;
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return p;
+}
+
+TARGET_SSE42
+static const char* ReverseScanSSE42(const uint64* words, const char* begin,
+                                    const char* end, bool in_set)
+{
+  const __m128i low_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+  const __m128i high_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2));
+  const unsigned int flip = in_set ? 0 : 0xFFFFu;
+  for (; end - begin >= 16; end -= 16)
+  {
+    const unsigned int mask =
+        MembersSSE42(end - 16, low_table, high_table) ^ flip;
+    if (mask != 0)
+      return end - (__builtin_clz(mask) - 16);
+  }
+  return end;
+}
+
+TARGET_AVX2
+static const char* ScanAVX2(const uint64* words, const char* p,
+                            const char* end, bool in_set)
+{
+  const __m256i low_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words)));
+  const __m256i high_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2)));
+  const unsigned int flip = in_set ? 0 : 0xFFFFFFFFu;
+  for (; end - p >= 32; p += 32)
+  {
+    const unsigned int mask =
+        MembersAVX2(p, low_table, high_table) ^ flip;
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return p;
+}
+
+TARGET_AVX2
+static const char* ReverseScanAVX2(const uint64* words, const char* begin,
+                                   const char* end, bool in_set)
+{
+  const __m256i low_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words)));
+  const __m256i high_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2)));
+  const unsigned int flip = in_set ? 0 : 0xFFFFFFFFu;
+  for (; end - begin >= 32; end -= 32)
+  {
+    const unsigned int mask =
+        MembersAVX2(end - 32, low_table, high_table) ^ flip;
+    if (mask != 0)
+      return end - __builtin_clz(mask);
+  }
+  return end;
+}
+
+// Stores the offsets from |base| of the members of the blocks from |p| on
+// in |offsets|, from |*count| on.  Stops at the end of the last whole block
+// or once |max_count| offsets are stored, and returns where the caller has
+// to carry on.
+TARGET_SSE42
+static const char* FindAllSSE42(const uint64* words, const char* base,
+                                const char* p, const char* end,
+                                size_t* offsets, size_t max_count,
+                                size_t* count)
+{
+  const __m128i low_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+  const __m128i high_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2));
+  size_t n = *count;
+  for (; end - p >= 16; p += 16)
+  {
+    for (unsigned int mask = MembersSSE42(p, low_table, high_table);
+         mask != 0; mask &= mask - 1)
+    {
+      if (n == max_count)
+      {
+        *count = n;
+        return p;
+      }
+      offsets[n++] = p - base + __builtin_ctz(mask);
+    }
+  }
+  *count = n;
+  return p;
+}
+
+TARGET_AVX2
+static const char* FindAllAVX2(const uint64* words, const char* base,
+                               const char* p, const char* end,
+                               size_t* offsets, size_t max_count,
+                               size_t* count)
+{
+  const __m256i low_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words)));
+  const __m256i high_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2)));
+  size_t n = *count;
+  for (; end - p >= 32; p += 32)
+  {
+    for (unsigned int mask = MembersAVX2(p, low_table, high_table);
+         mask != 0; mask &= mask - 1)
+    {
+      if (n == max_count)
+      {
+        *count = n;
+        return p;
+      }
+      offsets[n++] = p - base + __builtin_ctz(mask);
+    }
+  }
+  *count = n;
+  return p;
+}
+
+// Replace the members of the blocks from |p| on by |c|, blending each block
+// with its member mask, and return where the caller has to carry on.
+TARGET_SSE42
+static char* ReplaceSSE42(const uint64* words, char* p, char* end, char c)
+{
+  const __m128i low_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+  const __m128i high_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2));
+  const __m128i replacement = _mm_set1_epi8(c);
+  for (; end - p >= 16; p += 16)
+  {
+    __m128i* block = reinterpret_cast<__m128i*>(p);
+    const __m128i chunk = _mm_loadu_si128(block);
+    const __m128i members = MemberBytesSSE42(chunk, low_table, high_table);
+    if (_mm_movemask_epi8(members) != 0)
+      _mm_storeu_si128(block, _mm_blendv_epi8(chunk, replacement, members));
+  }
+  return p;
+}
+
+TARGET_AVX2
+static char* ReplaceAVX2(const uint64* words, char* p, char* end, char c)
+{
+  const __m256i low_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words)));
+  const __m256i high_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2)));
+  const __m256i replacement = _mm256_set1_epi8(c);
+  for (; end - p >= 32; p += 32)
+  {
+    __m256i* block = reinterpret_cast<__m256i*>(p);
+    const __m256i chunk = _mm256_loadu_si256(block);
+    const __m256i members = MemberBytesAVX2(chunk, low_table, high_table);
+    if (_mm256_movemask_epi8(members) != 0)
+      _mm256_storeu_si256(block,
+                          _mm256_blendv_epi8(chunk, replacement, members));
+  }
+  return p;
+}
+#endif
+
+void
+CharSet::Replace(char* begin, char* end, char c) const
+{
+  char* p = begin;
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasAVX2())
+    p = ReplaceAVX2(words_, p, end, c);
+  if (CPUHasSSE42())
+    p = ReplaceSSE42(words_, p, end, c);
+#endif
+  for (; p != end; ++p)
+  {
+    if (Contains(*p))
+      *p = c;
+  }
+}
+
+const char*
+CharSet::Scan(const char* begin, const char* end, bool in_set) const
+{
+  const char* p = begin;
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasAVX2())
+  {
+    p = ScanAVX2(words_, p, end, in_set);
+    if (end - p >= 32)
+      return p;
+  }
+  if (CPUHasSSE42())
+  {
+    p = ScanSSE42(words_, p, end, in_set);
+    if (end - p >= 16)
+      return p;
+  }
+#endif
+  for (; p != end; ++p)
+  {
+    if (Contains(*p) == in_set)
+      return p;
+  }
+  return end;
+}
+
+const char*
+CharSet::ReverseScan(const char* begin, const char* end, bool in_set) const
+{
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasAVX2())
+  {
+    const char* found = ReverseScanAVX2(words_, begin, end, in_set);
+    if (found - begin >= 32)
+      return found;
+    end = found;
+  }
+  if (CPUHasSSE42())
+  {
+    const char* found = ReverseScanSSE42(words_, begin, end, in_set);
+    if (found - begin >= 16)
+      return found;
+    end = found;
+  }
+#endif
+  for (; end != begin; --end)
+  {
+    if (Contains(end[-1]) == in_set)
+      return end;
+  }
+  return begin;
+}
+
+size_t
+CharSet::FindAllOf(const StringPiece& str, size_t pos, size_t* offsets,
+                   size_t max_count) const
+{
+  if (pos >= str.length())
+    return 0;
+  const char* p = str.data() + pos;
+  const char* const end = str.end();
+  size_t count = 0;
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasAVX2())
+    p = FindAllAVX2(words_, str.data(), p, end, offsets, max_count, &count);
+  else if (CPUHasSSE42())
+    p = FindAllSSE42(words_, str.data(), p, end, offsets, max_count, &count);
+#endif
+  for (; p != end && count != max_count; ++p)
+  {
+    if (Contains(*p))
+      offsets[count++] = p - str.data();
+  }
+  return count;
+}
+
+size_t
+CharSet::FindFirstOf(const StringPiece& str, size_t pos) const
+{
+  if (pos >= str.length())
+    return StringPiece::npos;
+  const char* found = Scan(str.data() + pos, str.end(), true);
+  return (found == str.end()) ? StringPiece::npos : found - str.data();
+}
+
+size_t
+CharSet::FindFirstNotOf(const StringPiece& str, size_t pos) const
+{
+  if (pos >= str.length())
+    return StringPiece::npos;
+  const char* found = Scan(str.data() + pos, str.end(), false);
+  return (found == str.end()) ? StringPiece::npos : found - str.data();
+}
+
+size_t
+CharSet::FindLastOf(const StringPiece& str, size_t pos) const
+{
+  if (str.empty())
+    return StringPiece::npos;
+  const size_t end = (pos < str.length()) ? pos + 1 : str.length();
+  const char* found = ReverseScan(str.data(), str.data() + end, true);
+  return (found == str.data()) ? StringPiece::npos : found - str.data() - 1;
+}
+
+size_t
+CharSet::FindLastNotOf(const StringPiece& str, size_t pos) const
+{
+  if (str.empty())
+    return StringPiece::npos;
+  const size_t end = (pos < str.length()) ? pos + 1 : str.length();
+  const char* found = ReverseScan(str.data(), str.data() + end, false);
+  return (found == str.data()) ? StringPiece::npos : found - str.data() - 1;
+}
+
+}; // namespace util
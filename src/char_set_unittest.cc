@@ -0,0 +1,170 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/char_set.h"
+
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "util/cpu.h"
+#include "third_party/gtest/include/gtest/gtest.h"
+
+namespace util
+{
+
+static constexpr CharSet kSeparators(",; ");
+
+// Built at compile time.
+static_assert(kSeparators.Contains(','), "',' is a separator");
+static_assert(!kSeparators.Contains('a'), "'a' is not a separator");
+
+TEST(CharSetTest, Contains)
+{
+  const std::string chars("\x01" "az\x7f\x80\xa0\xff", 7);
+  const CharSet from_literal("\x01" "az\x7f\x80\xa0\xff");
+  const CharSet from_piece((StringPiece(chars)));
+  for (int c = 0; c < 256; ++c)
+  {
+    const bool expect = chars.find(static_cast<char>(c)) != std::string::npos;
+    EXPECT_EQ(expect, from_literal.Contains(static_cast<char>(c)))
+        << "char:" << c;
+    EXPECT_EQ(expect, from_piece.Contains(static_cast<char>(c)))
+        << "char:" << c;
+  }
+
+  // A StringPiece may hold '\0', a literal ends there.
+  EXPECT_TRUE(CharSet(StringPiece("a\0b", 3)).Contains('\0'));
+  EXPECT_FALSE(CharSet("a\0b").Contains('\0'));
+  EXPECT_FALSE(CharSet("a\0b").Contains('b'));
+
+  CharSet set;
+  EXPECT_TRUE(set.empty());
+  set.Add('\xe3');
+  EXPECT_FALSE(set.empty());
+  EXPECT_TRUE(set.Contains('\xe3'));
+  EXPECT_FALSE(set.Contains('\x63'));
+}
+
+TEST(CharSetTest, Find)
+{
+  const StringPiece str("a, b;;c ");
+  EXPECT_EQ(1U, kSeparators.FindFirstOf(str));
+  EXPECT_EQ(4U, kSeparators.FindFirstOf(str, 4));
+  EXPECT_EQ(StringPiece::npos, kSeparators.FindFirstOf(str, 8));
+  EXPECT_EQ(0U, kSeparators.FindFirstNotOf(str));
+  EXPECT_EQ(3U, kSeparators.FindFirstNotOf(str, 1));
+  EXPECT_EQ(7U, kSeparators.FindLastOf(str));
+  EXPECT_EQ(5U, kSeparators.FindLastOf(str, 5));
+  EXPECT_EQ(6U, kSeparators.FindLastNotOf(str));
+  EXPECT_EQ(3U, kSeparators.FindLastNotOf(str, 5));
+  EXPECT_EQ(StringPiece::npos, kSeparators.FindLastNotOf(StringPiece(" ;")));
+  EXPECT_EQ(StringPiece::npos, kSeparators.FindFirstOf(StringPiece()));
+  EXPECT_EQ(StringPiece::npos, kSeparators.FindLastOf(StringPiece()));
+}
+
+// Every byte value once, to draw random sets and strings from.
+static std::string AllBytes()
+{
+  std::string bytes;
+  for (int c = 0; c < 256; ++c)
+    bytes += static_cast<char>(c);
+  return bytes;
+}
+
+TEST(CharSetTest, VectorizedPaths)
+{
+  const std::string all_bytes = AllBytes();
+  srand(2014);
+  ForEachCPUFeatureMask([&](int mask) {
+    for (int round = 0; round < 500; ++round)
+    {
+      // Sets of every size, over all 256 byte values.
+      const std::string chars = RandomString(all_bytes, 39);
+      const CharSet set((StringPiece(chars)));
+
+      // Long runs of members and non-members so that blocks get skipped.
+      const std::string str =
+          RandomString(chars + RandomString(all_bytes, 40), 149, 40);
+      const size_t pos = rand() % (str.length() + 2);
+
+      EXPECT_EQ(str.find_first_of(chars, pos), set.FindFirstOf(str, pos))
+          << "mask:" << mask;
+      EXPECT_EQ(str.find_first_not_of(chars, pos),
+                set.FindFirstNotOf(str, pos)) << "mask:" << mask;
+      EXPECT_EQ(str.find_last_of(chars, pos), set.FindLastOf(str, pos))
+          << "mask:" << mask;
+      EXPECT_EQ(str.find_last_not_of(chars, pos),
+                set.FindLastNotOf(str, pos)) << "mask:" << mask;
+      EXPECT_EQ(str.find_last_of(chars), set.FindLastOf(str))
+          << "mask:" << mask;
+      EXPECT_EQ(str.find_last_not_of(chars), set.FindLastNotOf(str))
+          << "mask:" << mask;
+
+      std::string expect(str);
+      for (size_t i = 0; i < expect.length(); ++i)
+      {
+        if (chars.find(expect[i]) != std::string::npos)
+          expect[i] = '*';
+      }
+      std::string replaced(str);
+      set.Replace(&replaced[0], &replaced[0] + replaced.length(), '*');
+      EXPECT_EQ(expect, replaced) << "mask:" << mask;
+    }
+  });
+}
+
+TEST(CharSetTest, FindAllOf)
+{
+  const std::string all_bytes = AllBytes();
+  srand(2014);
+  ForEachCPUFeatureMask([&](int mask) {
+    for (int round = 0; round < 300; ++round)
+    {
+      const std::string chars = RandomString(all_bytes, 7);
+      const CharSet set((StringPiece(chars)));
+
+      // About one member in three.
+      const std::string str =
+          RandomString(chars + RandomString(all_bytes, 14), 299);
+      size_t pos = rand() % (str.length() + 2);
+
+      std::vector<size_t> expect;
+      for (size_t i = pos; i < str.length(); ++i)
+      {
+        if (chars.find(str[i]) != std::string::npos)
+          expect.push_back(i);
+      }
+
+      // Small batches make the kernels stop and resume mid-block.
+      const size_t max_count = 1 + rand() % 20;
+      std::vector<size_t> found;
+      size_t offsets[20];
+      for (;;)
+      {
+        const size_t count = set.FindAllOf(str, pos, offsets, max_count);
+        found.insert(found.end(), offsets, offsets + count);
+        if (count != max_count)
+          break;
+        pos = offsets[count - 1] + 1;
+      }
+      EXPECT_EQ(expect, found) << "mask:" << mask << " round:" << round;
+    }
+  });
+}
+
+}; // namespace util
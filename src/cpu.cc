@@ -0,0 +1,88 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/cpu.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+namespace util
+{
+
+static int DetectCPUFeatures()
+{
+  int features = 0;
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.2"))
+    features |= CPU_SSE42;
+  if (__builtin_cpu_supports("avx2"))
+    features |= CPU_AVX2;
+#endif
+  return features;
+}
+
+static const int g_detected_features = DetectCPUFeatures();
+static int g_features = g_detected_features;
+
+bool
+CPUHasSSE42()
+{
+  return (g_features & CPU_SSE42) != 0;
+}
+
+bool
+CPUHasAVX2()
+{
+  return (g_features & CPU_AVX2) != 0;
+}
+
+void
+SetCPUFeatureMaskForTesting(int mask)
+{
+  g_features = g_detected_features & mask;
+}
+
+const int kCPUFeatureMasksForTesting[3] = { 0, CPU_SSE42, CPU_FEATURES_ALL };
+
+ScopedCPUFeatureMask::ScopedCPUFeatureMask(int mask)
+{
+  SetCPUFeatureMaskForTesting(mask);
+}
+
+ScopedCPUFeatureMask::~ScopedCPUFeatureMask()
+{
+  SetCPUFeatureMaskForTesting(CPU_FEATURES_ALL);
+}
+
+std::string
+RandomString(const StringPiece& alphabet, size_t max_length, size_t max_run)
+{
+  std::string result;
+  if (alphabet.empty())
+    return result;
+  const size_t length = rand() % (max_length + 1);
+  while (result.length() < length)
+  {
+    const char c = alphabet[rand() % alphabet.size()];
+    const size_t run = 1 + rand() % std::max<size_t>(max_run, 1);
+    result.append(std::min(run, length - result.length()), c);
+  }
+  return result;
+}
+
+}; // namespace util
@@ -0,0 +1,57 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/cpu.h"
+
+#include "third_party/gtest/include/gtest/gtest.h"
+
+namespace util
+{
+
+TEST(CPUTest, SetCPUFeatureMaskForTesting)
+{
+  const bool has_sse42 = CPUHasSSE42();
+  const bool has_avx2 = CPUHasAVX2();
+
+  SetCPUFeatureMaskForTesting(0);
+  EXPECT_FALSE(CPUHasSSE42());
+  EXPECT_FALSE(CPUHasAVX2());
+
+  SetCPUFeatureMaskForTesting(CPU_SSE42);
+  EXPECT_EQ(has_sse42, CPUHasSSE42());
+  EXPECT_FALSE(CPUHasAVX2());
+
+  // A mask can only take features away.
+  SetCPUFeatureMaskForTesting(CPU_FEATURES_ALL);
+  EXPECT_EQ(has_sse42, CPUHasSSE42());
+  EXPECT_EQ(has_avx2, CPUHasAVX2());
+}
+
+TEST(CPUTest, ScopedCPUFeatureMask)
+{
+  const bool has_sse42 = CPUHasSSE42();
+  const bool has_avx2 = CPUHasAVX2();
+
+  {
+    const ScopedCPUFeatureMask scoped_mask(CPU_SSE42);
+    EXPECT_EQ(has_sse42, CPUHasSSE42());
+    EXPECT_FALSE(CPUHasAVX2());
+  }
+  EXPECT_EQ(has_sse42, CPUHasSSE42());
+  EXPECT_EQ(has_avx2, CPUHasAVX2());
+}
+
+} // namespace util
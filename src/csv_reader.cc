@@ -0,0 +1,331 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/csv_reader.h"
+
+#include <string.h>
+
+#include "src/byte_mask.h"
+#include "util/cpu.h"
+#include "util/string_number_conversions.h"
+
+namespace util
+{
+
+// Bit i of each mask is set when byte i of a 64-byte block is a quote, a
+// delimiter or a '\n'.
+struct BlockMasks
+{
+  uint64 quotes;
+  uint64 delimiters;
+  uint64 line_breaks;
+};
+
+#if defined(HAVE_TARGET_ATTRIBUTE)
+TARGET_AVX2
+static void FindMasksAVX2(const char* p, char quote, char delimiter,
+                          BlockMasks* masks)
+{
+  masks->quotes = ByteMask64AVX2(p, quote);
+  masks->delimiters = ByteMask64AVX2(p, delimiter);
+  masks->line_breaks = ByteMask64AVX2(p, '\n');
+}
+#endif
+
+static void FindMasks(const char* p, char quote, char delimiter,
+                      BlockMasks* masks)
+{
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasAVX2())
+  {
+    FindMasksAVX2(p, quote, delimiter, masks);
+    return;
+  }
+#endif
+  masks->quotes = ByteMask64(p, quote);
+  masks->delimiters = ByteMask64(p, delimiter);
+  masks->line_breaks = ByteMask64(p, '\n');
+}
+
+// Bit i of the result is the XOR of bits 0 to i of |x|: with |x| the quote
+// mask, the bits set are those of the bytes in quotes, opening quotes
+// included and closing ones not.
+static inline uint64 PrefixXor(uint64 x)
+{
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+CSVRow::CSVRow()
+{
+}
+
+CSVRow::~CSVRow()
+{
+}
+
+bool
+CSVRow::GetInt(size_t i, int* value) const
+{
+  return i < fields_.size() && StringToInt(fields_[i], value);
+}
+
+bool
+CSVRow::GetUint(size_t i, unsigned* value) const
+{
+  return i < fields_.size() && StringToUint(fields_[i], value);
+}
+
+bool
+CSVRow::GetInt64(size_t i, int64* value) const
+{
+  return i < fields_.size() && StringToInt64(fields_[i], value);
+}
+
+bool
+CSVRow::GetUint64(size_t i, uint64* value) const
+{
+  return i < fields_.size() && StringToUint64(fields_[i], value);
+}
+
+CSVReader::CSVReader(char delimiter, char quote)
+    : delimiter_(delimiter),
+      quote_(quote),
+      pos_(0),
+      scanning_chunk_(false),
+      pending_in_quote_(false),
+      pending_complete_(false),
+      finished_(false),
+      data_(NULL),
+      length_(0),
+      block_(0),
+      next_block_(0),
+      structural_(0),
+      line_breaks_(0),
+      in_quote_(false)
+{
+}
+
+CSVReader::~CSVReader()
+{
+}
+
+void
+CSVReader::Append(const StringPiece& chunk)
+{
+  chunk_ = chunk;
+  pos_ = 0;
+  scanning_chunk_ = false;
+  if (pending_.empty())
+    return;
+
+  // Only the rest of the cut row is copied: the chunk is scanned from the
+  // quote state the row was cut in, up to the first line break out of
+  // quotes.
+  StartScan(chunk.data(), chunk.size(), 0, pending_in_quote_);
+  size_t offset = 0;
+  bool line_break = false;
+  while (NextStructural(&offset, &line_break) && !line_break)
+  {
+  }
+  if (line_break)
+  {
+    pending_.append(chunk.data(), offset + 1);
+    pending_complete_ = true;
+    pos_ = offset + 1;
+  }
+  else
+  {
+    pending_.append(chunk.data(), chunk.size());
+    pending_in_quote_ = in_quote_;
+    pos_ = chunk.size();
+  }
+}
+
+void
+CSVReader::Finish()
+{
+  finished_ = true;
+}
+
+bool
+CSVReader::NextRow(CSVRow* row)
+{
+  if (!pending_.empty() && (pending_complete_ || finished_))
+  {
+    row_.swap(pending_);
+    pending_.clear();
+    pending_complete_ = false;
+    scanning_chunk_ = false;
+    StartScan(row_.data(), row_.size(), 0, false);
+    size_t pos = 0;
+    return ReadRow(&pos, true, row);
+  }
+
+  if (pos_ == chunk_.size())
+    return false;
+  if (!scanning_chunk_)
+  {
+    StartScan(chunk_.data(), chunk_.size(), pos_, false);
+    scanning_chunk_ = true;
+  }
+  if (ReadRow(&pos_, finished_, row))
+    return true;
+
+  // The row goes on in the next chunk.
+  pending_.assign(chunk_.data() + pos_, chunk_.size() - pos_);
+  pending_in_quote_ = in_quote_;
+  pos_ = chunk_.size();
+  return false;
+}
+
+void
+CSVReader::StartScan(const char* data, size_t length, size_t pos,
+                     bool in_quote)
+{
+  data_ = data;
+  length_ = length;
+  block_ = pos;
+  next_block_ = pos;
+  structural_ = 0;
+  line_breaks_ = 0;
+  in_quote_ = in_quote;
+}
+
+void
+CSVReader::ScanBlock()
+{
+  const char* p = data_ + next_block_;
+  const size_t size = length_ - next_block_;
+  // The bytes past the end are masked off below, but must be defined.
+  char buffer[64] = { 0 };
+  if (size < 64)
+  {
+    memcpy(buffer, p, size);
+    p = buffer;
+  }
+  BlockMasks masks;
+  FindMasks(p, quote_, delimiter_, &masks);
+  if (size < 64)
+  {
+    const uint64 valid = (GG_UINT64_C(1) << size) - 1;
+    masks.quotes &= valid;
+    masks.delimiters &= valid;
+    masks.line_breaks &= valid;
+  }
+
+  const uint64 in_quote =
+      PrefixXor(masks.quotes) ^ (in_quote_ ? ~GG_UINT64_C(0) : 0);
+  in_quote_ = (in_quote >> 63) != 0;
+  structural_ = (masks.delimiters | masks.line_breaks) & ~in_quote;
+  line_breaks_ = masks.line_breaks & ~in_quote;
+  block_ = next_block_;
+  next_block_ += 64;
+}
+
+bool
+CSVReader::NextStructural(size_t* offset, bool* line_break)
+{
+  while (structural_ == 0)
+  {
+    if (next_block_ >= length_)
+      return false;
+    ScanBlock();
+  }
+  const int bit = __builtin_ctzll(structural_);
+  *offset = block_ + bit;
+  *line_break = ((line_breaks_ >> bit) & 1) != 0;
+  structural_ &= structural_ - 1;
+  return true;
+}
+
+bool
+CSVReader::ReadRow(size_t* pos, bool at_end, CSVRow* row)
+{
+  ends_.clear();
+  size_t offset = 0;
+  bool line_break = false;
+  while (NextStructural(&offset, &line_break))
+  {
+    ends_.push_back(offset);
+    if (line_break)
+      break;
+  }
+  if (!line_break)
+  {
+    if (!at_end || *pos == length_)
+      return false;
+    ends_.push_back(length_);
+  }
+
+  const size_t row_end = ends_.back();
+  row->fields_.clear();
+  row->unescaped_.clear();
+  row->unescaped_.reserve(row_end - *pos);
+  size_t begin = *pos;
+  for (size_t i = 0; i < ends_.size(); ++i)
+  {
+    size_t end = ends_[i];
+    // The '\r' of a "\r\n" line break.
+    if (line_break && i + 1 == ends_.size() && end > begin &&
+        data_[end - 1] == '\r')
+      --end;
+    AddField(data_ + begin, data_ + end, row);
+    begin = ends_[i] + 1;
+  }
+  *pos = line_break ? row_end + 1 : row_end;
+  return true;
+}
+
+void
+CSVReader::AddField(const char* begin, const char* end, CSVRow* row) const
+{
+  StringPiece field(begin, end - begin);
+  if (field.size() >= 2 && *begin == quote_ && *(end - 1) == quote_)
+  {
+    field = StringPiece(begin + 1, field.size() - 2);
+    const char* quote = static_cast<const char*>(
+        memchr(field.data(), quote_, field.size()));
+    if (quote != NULL)
+    {
+      // Doubled quotes stand for one.
+      std::string* unescaped = &row->unescaped_;
+      const size_t start = unescaped->size();
+      const char* p = field.data();
+      const char* const field_end = field.end();
+      while (quote != NULL)
+      {
+        unescaped->append(p, quote + 1 - p);
+        p = quote + 1;
+        if (p != field_end && *p == quote_)
+          ++p;
+        quote = static_cast<const char*>(
+            memchr(p, quote_, field_end - p));
+      }
+      unescaped->append(p, field_end - p);
+      field = StringPiece(unescaped->data() + start,
+                          unescaped->size() - start);
+    }
+  }
+  row->fields_.push_back(field);
+}
+
+}; // namespace util
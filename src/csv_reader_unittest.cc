@@ -0,0 +1,205 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/csv_reader.h"
+
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "util/basictypes.h"
+#include "util/cpu.h"
+#include "third_party/gtest/include/gtest/gtest.h"
+
+namespace util
+{
+
+typedef std::vector<std::vector<std::string> > Rows;
+
+// Reads |input|, fed in chunks of at most |chunk_size| bytes.
+static Rows ReadCSV(const std::string& input, size_t chunk_size,
+                    char delimiter = ',')
+{
+  Rows rows;
+  CSVReader reader(delimiter);
+  CSVRow row;
+  for (size_t pos = 0; pos < input.size(); pos += chunk_size)
+  {
+    reader.Append(StringPiece(input).substr(pos, chunk_size));
+    while (reader.NextRow(&row))
+    {
+      rows.push_back(std::vector<std::string>());
+      for (size_t i = 0; i < row.size(); ++i)
+        rows.back().push_back(row[i].as_string());
+    }
+  }
+  reader.Finish();
+  while (reader.NextRow(&row))
+  {
+    rows.push_back(std::vector<std::string>());
+    for (size_t i = 0; i < row.size(); ++i)
+      rows.back().push_back(row[i].as_string());
+  }
+  return rows;
+}
+
+// The same, a byte at a time.
+static Rows ReadCSVBytewise(const std::string& input)
+{
+  Rows rows;
+  std::vector<std::string> raw;
+  std::string field;
+  bool in_quote = false;
+  for (size_t i = 0; i <= input.size(); ++i)
+  {
+    const bool at_end = (i == input.size());
+    if (!at_end && input[i] == '"')
+      in_quote = !in_quote;
+    if (at_end || (!in_quote && (input[i] == ',' || input[i] == '\n')))
+    {
+      if (at_end && raw.empty() && field.empty())
+        break;
+      if (!at_end && input[i] == '\n' && !field.empty() &&
+          field[field.size() - 1] == '\r')
+        field.erase(field.size() - 1);
+      raw.push_back(field);
+      field.clear();
+      if (at_end || input[i] == '\n')
+      {
+        rows.push_back(std::vector<std::string>());
+        for (size_t j = 0; j < raw.size(); ++j)
+        {
+          std::string value = raw[j];
+          if (value.size() >= 2 && value[0] == '"' &&
+              value[value.size() - 1] == '"')
+          {
+            value = value.substr(1, value.size() - 2);
+            for (size_t k = 0; k < value.size(); ++k)
+            {
+              if (value[k] == '"' && k + 1 < value.size() &&
+                  value[k + 1] == '"')
+                value.erase(k + 1, 1);
+            }
+          }
+          rows.back().push_back(value);
+        }
+        raw.clear();
+      }
+      continue;
+    }
+    field += input[i];
+  }
+  return rows;
+}
+
+TEST(CSVReaderTest, Fields)
+{
+  static const struct
+  {
+    const char* input;
+    const char* rows;
+  } cases[] = {
+    { "", "" },
+    { "\n", "[]" },
+    { "a", "[a]" },
+    { "a,b\n", "[a|b]" },
+    { "a,b\r\nc,d\r\n", "[a|b][c|d]" },
+    { "a,,\n,\n", "[a||][|]" },
+    { " a , b ", "[ a | b ]" },
+    { "\"a,b\",c", "[a,b|c]" },
+    { "\"\",\"\"\"\"", "[|\"]" },
+    { "\"say \"\"hi\"\"\",x\n", "[say \"hi\"|x]" },
+    { "\"two\nlines\",\"cr\r\nlf\"\r\nz", "[two\nlines|cr\r\nlf][z]" },
+    { "a\"b,c", "[a\"b,c]" },
+    { "\"open,a\nb", "[\"open,a\nb]" },
+    { "a\rb,c\r", "[a\rb|c\r]" },
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    const Rows rows = ReadCSV(cases[i].input, 1024);
+    std::string printed;
+    for (size_t r = 0; r < rows.size(); ++r)
+    {
+      printed += '[';
+      for (size_t f = 0; f < rows[r].size(); ++f)
+        printed += (f == 0 ? "" : "|") + rows[r][f];
+      printed += ']';
+    }
+    EXPECT_EQ(cases[i].rows, printed) << "cases:" << i + 1;
+    EXPECT_EQ(ReadCSVBytewise(cases[i].input), rows) << "cases:" << i + 1;
+  }
+}
+
+TEST(CSVReaderTest, TSV)
+{
+  const Rows rows = ReadCSV("id\tname\n1\t\"a\tb,c\"\n", 1024, '\t');
+  ASSERT_EQ(2U, rows.size());
+  ASSERT_EQ(2U, rows[1].size());
+  EXPECT_EQ("1", rows[1][0]);
+  EXPECT_EQ("a\tb,c", rows[1][1]);
+}
+
+// Long inputs fed in chunks of every size must give the rows a byte by
+// byte reading gives, whatever the blocks and chunks cut.
+TEST(CSVReaderTest, Chunks)
+{
+  // Mostly letters, so that the fields are a few bytes long.
+  static const char kChars[] = "abababababab,\"\n\r";
+
+  srand(2014);
+  ForEachCPUFeatureMask([&](int mask) {
+    for (int round = 0; round < 100; ++round)
+    {
+      const std::string input = RandomString(kChars, 399);
+      const Rows expect = ReadCSVBytewise(input);
+      EXPECT_EQ(expect, ReadCSV(input, input.size() + 1))
+          << "mask:" << mask << " round:" << round;
+      EXPECT_EQ(expect, ReadCSV(input, 1 + rand() % 100))
+          << "mask:" << mask << " round:" << round;
+      EXPECT_EQ(expect, ReadCSV(input, 1))
+          << "mask:" << mask << " round:" << round;
+    }
+  });
+}
+
+TEST(CSVReaderTest, Columns)
+{
+  CSVReader reader;
+  reader.Append("42,-7,18446744073709551615,x\n");
+  reader.Finish();
+  CSVRow row;
+  ASSERT_TRUE(reader.NextRow(&row));
+
+  int i = 0;
+  unsigned u = 0;
+  int64 i64 = 0;
+  uint64 u64 = 0;
+  EXPECT_TRUE(row.GetInt(0, &i));
+  EXPECT_EQ(42, i);
+  EXPECT_TRUE(row.GetInt64(1, &i64));
+  EXPECT_EQ(-7, i64);
+  EXPECT_TRUE(row.GetUint(0, &u));
+  EXPECT_EQ(42U, u);
+  EXPECT_TRUE(row.GetUint64(2, &u64));
+  EXPECT_EQ(GG_UINT64_C(18446744073709551615), u64);
+  EXPECT_FALSE(row.GetInt(3, &i));
+  EXPECT_FALSE(row.GetInt(4, &i));
+  EXPECT_FALSE(reader.NextRow(&row));
+}
+
+}; // namespace util
@@ -0,0 +1,271 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/hash.h"
+
+#include <string.h>
+
+#include "util/string_util.h"
+
+namespace util
+{
+
+static const uint64 kSecret[4] = {
+  GG_UINT64_C(0xa0761d6478bd642f), GG_UINT64_C(0xe7037ed1a0b428db),
+  GG_UINT64_C(0x8ebc6af09c88c6e3), GG_UINT64_C(0x589965cc75374cc3),
+};
+
+// Replaces |*a| and |*b| by the low and high halves of their 128-bit product.
+static inline void Multiply(uint64* a, uint64* b)
+{
+#if defined(__SIZEOF_INT128__)
+  const unsigned __int128 product = static_cast<unsigned __int128>(*a) * *b;
+  *a = static_cast<uint64>(product);
+  *b = static_cast<uint64>(product >> 64);
+#else
+  const uint64 a_high = *a >> 32;
+  const uint64 a_low = static_cast<uint32>(*a);
+  const uint64 b_high = *b >> 32;
+  const uint64 b_low = static_cast<uint32>(*b);
+  const uint64 middle0 = a_high * b_low;
+  const uint64 middle1 = a_low * b_high;
+  const uint64 low0 = a_low * b_low;
+  const uint64 low1 = low0 + (middle0 << 32);
+  const uint64 low = low1 + (middle1 << 32);
+  *b = a_high * b_high + (middle0 >> 32) + (middle1 >> 32) +
+      (low1 < low0) + (low < low1);
+  *a = low;
+#endif
+}
+
+static inline uint64 Mix(uint64 a, uint64 b)
+{
+  Multiply(&a, &b);
+  return a ^ b;
+}
+
+// Lower-cases the ASCII letters among the bytes packed in |x|, all at once:
+// adding to the low 7 bits of each byte sets its top bit from 'A' on, and
+// from past 'Z' on.
+static inline uint64 LowerCaseWordASCII(uint64 x)
+{
+  const uint64 kOnes = GG_UINT64_C(0x0101010101010101);
+  const uint64 low_bits = x & (0x7F * kOnes);
+  const uint64 from_a = low_bits + (0x80 - 'A') * kOnes;
+  const uint64 past_z = low_bits + (0x80 - 'Z' - 1) * kOnes;
+  const uint64 upper = (from_a ^ past_z) & ~x & (0x80 * kOnes);
+  return x | (upper >> 2);
+}
+
+// Reads the input, lower-cased when |kFold| is true.
+template <bool kFold>
+struct HashReader
+{
+  static inline uint64 Read8(const char* p)
+  {
+    uint64 value;
+    memcpy(&value, p, sizeof(value));
+    return kFold ? LowerCaseWordASCII(value) : value;
+  }
+
+  static inline uint64 Read4(const char* p)
+  {
+    uint32 value;
+    memcpy(&value, p, sizeof(value));
+    return kFold ? LowerCaseWordASCII(value) : value;
+  }
+
+  static inline uint64 Read1(const char* p)
+  {
+    return static_cast<unsigned char>(kFold ? ToLowerASCII(*p) : *p);
+  }
+
+  // 1 to 3 bytes.
+  static inline uint64 Read3(const char* p, size_t length)
+  {
+    return (Read1(p) << 16) | (Read1(p + length / 2) << 8) |
+        Read1(p + length - 1);
+  }
+};
+
+static inline uint64 MixSeed(uint64 seed)
+{
+  return seed ^ Mix(seed ^ kSecret[0], kSecret[1]);
+}
+
+template <bool kFold>
+static inline void HashBlock(const char* p, uint64* seed, uint64* see1,
+                             uint64* see2)
+{
+  typedef HashReader<kFold> R;
+  *seed = Mix(R::Read8(p) ^ kSecret[1], R::Read8(p + 8) ^ *seed);
+  *see1 = Mix(R::Read8(p + 16) ^ kSecret[2], R::Read8(p + 24) ^ *see1);
+  *see2 = Mix(R::Read8(p + 32) ^ kSecret[3], R::Read8(p + 40) ^ *see2);
+}
+
+static inline uint64 HashFinish(uint64 a, uint64 b, uint64 seed,
+                                size_t length)
+{
+  a ^= kSecret[1];
+  b ^= seed;
+  Multiply(&a, &b);
+  return Mix(a ^ kSecret[0] ^ length, b ^ kSecret[1]);
+}
+
+// Hashes the last |remaining| bytes, starting at |p|, of an input of
+// |length| bytes longer than 16.  The 16 bytes before |p| must be readable
+// if |remaining| is not larger than 16.
+template <bool kFold>
+static uint64 HashTail(const char* p, size_t remaining, uint64 seed,
+                       size_t length)
+{
+  typedef HashReader<kFold> R;
+  while (remaining > 16)
+  {
+    seed = Mix(R::Read8(p) ^ kSecret[1], R::Read8(p + 8) ^ seed);
+    p += 16;
+    remaining -= 16;
+  }
+  return HashFinish(R::Read8(p + remaining - 16), R::Read8(p + remaining - 8),
+                    seed, length);
+}
+
+// |seed| has been through MixSeed().
+template <bool kFold>
+static uint64 HashBytes(const char* p, size_t length, uint64 seed)
+{
+  typedef HashReader<kFold> R;
+  if (length <= 16)
+  {
+    uint64 a = 0;
+    uint64 b = 0;
+    if (length >= 4)
+    {
+      // Two overlapping pairs of 4-byte words cover 4 to 16 bytes.
+      const size_t step = (length >> 3) << 2;
+      a = (R::Read4(p) << 32) | R::Read4(p + step);
+      b = (R::Read4(p + length - 4) << 32) | R::Read4(p + length - 4 - step);
+    }
+    else if (length > 0)
+    {
+      a = R::Read3(p, length);
+    }
+    return HashFinish(a, b, seed, length);
+  }
+
+  size_t remaining = length;
+  if (remaining > 48)
+  {
+    uint64 see1 = seed;
+    uint64 see2 = seed;
+    do
+    {
+      HashBlock<kFold>(p, &seed, &see1, &see2);
+      p += 48;
+      remaining -= 48;
+    } while (remaining > 48);
+    seed ^= see1 ^ see2;
+  }
+  return HashTail<kFold>(p, remaining, seed, length);
+}
+
+uint64
+Hash64(const StringPiece& str)
+{
+  return Hash64(str, 0);
+}
+
+uint64
+Hash64(const StringPiece& str, uint64 seed)
+{
+  return HashBytes<false>(str.data(), str.size(), MixSeed(seed));
+}
+
+uint64
+Hash64IgnoringCaseASCII(const StringPiece& str, uint64 seed)
+{
+  return HashBytes<true>(str.data(), str.size(), MixSeed(seed));
+}
+
+const size_t Hash64Stream::kBlockSize;
+
+Hash64Stream::Hash64Stream(uint64 seed)
+    : seed_(MixSeed(seed)),
+      see1_(seed_),
+      see2_(seed_),
+      length_(0),
+      pending_length_(0)
+{
+}
+
+void
+Hash64Stream::ConsumeBlock(const char* block)
+{
+  HashBlock<false>(block, &seed_, &see1_, &see2_);
+  memcpy(previous_, block + kBlockSize - sizeof(previous_),
+         sizeof(previous_));
+}
+
+void
+Hash64Stream::Update(const StringPiece& piece)
+{
+  const char* data = piece.data();
+  size_t length = piece.size();
+  length_ += length;
+
+  // A block is only hashed once more input follows it, as Hash64() does.
+  if (pending_length_ + length <= kBlockSize)
+  {
+    if (length != 0)
+      memcpy(pending_ + pending_length_, data, length);
+    pending_length_ += length;
+    return;
+  }
+  if (pending_length_ != 0)
+  {
+    const size_t fill = kBlockSize - pending_length_;
+    memcpy(pending_ + pending_length_, data, fill);
+    ConsumeBlock(pending_);
+    data += fill;
+    length -= fill;
+  }
+  for (; length > kBlockSize; data += kBlockSize, length -= kBlockSize)
+    ConsumeBlock(data);
+  memcpy(pending_, data, length);
+  pending_length_ = length;
+}
+
+uint64
+Hash64Stream::Finish() const
+{
+  if (length_ <= kBlockSize)
+    return HashBytes<false>(pending_, pending_length_, seed_);
+
+  char tail[sizeof(previous_) + kBlockSize];
+  memcpy(tail, previous_, sizeof(previous_));
+  memcpy(tail + sizeof(previous_), pending_, pending_length_);
+  return HashTail<false>(tail + sizeof(previous_), pending_length_,
+                         seed_ ^ see1_ ^ see2_, length_);
+}
+
+bool
+CaseInsensitiveEqualASCII::operator()(const StringPiece& a,
+                                      const StringPiece& b) const
+{
+  return EqualsCaseInsensitiveASCII(a, b);
+}
+
+}; // namespace util
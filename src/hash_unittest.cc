@@ -0,0 +1,147 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/hash.h"
+
+#include <stdlib.h>
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "util/string_util.h"
+#include "third_party/gtest/include/gtest/gtest.h"
+
+namespace util
+{
+
+static std::string RandomBytes(size_t length)
+{
+  std::string bytes;
+  for (size_t i = 0; i < length; ++i)
+    bytes += static_cast<char>(rand() % 256);
+  return bytes;
+}
+
+TEST(HashTest, Hash64)
+{
+  // Every length through the short, medium and block paths.
+  std::set<uint64> hashes;
+  const std::string bytes = RandomBytes(300);
+  for (size_t length = 0; length <= bytes.length(); ++length)
+  {
+    const StringPiece piece(bytes.data(), length);
+    EXPECT_EQ(Hash64(piece), Hash64(piece, 0));
+    EXPECT_NE(Hash64(piece, 0), Hash64(piece, 1));
+    hashes.insert(Hash64(piece));
+  }
+  EXPECT_EQ(bytes.length() + 1, hashes.size());
+
+  EXPECT_NE(Hash64(""), Hash64(StringPiece("\0", 1)));
+  EXPECT_NE(Hash64(StringPiece("\0", 1)), Hash64(StringPiece("\0\0", 2)));
+  EXPECT_EQ(Hash64(std::string("token")), Hash64("token"));
+}
+
+TEST(HashTest, Hash64Bits)
+{
+  // Flipping any input bit flips about half of the output bits.
+  srand(2014);
+  static const size_t kLengths[] = { 3, 8, 16, 33, 100 };
+  for (size_t l = 0; l < ARRAYSIZE_UNSAFE(kLengths); ++l)
+  {
+    std::string bytes = RandomBytes(kLengths[l]);
+    const uint64 hash = Hash64(bytes);
+    int changed_bits = 0;
+    for (size_t bit = 0; bit < bytes.length() * 8; ++bit)
+    {
+      bytes[bit / 8] ^= 1 << (bit % 8);
+      changed_bits += __builtin_popcountll(hash ^ Hash64(bytes));
+      bytes[bit / 8] ^= 1 << (bit % 8);
+    }
+    const double average =
+        static_cast<double>(changed_bits) / (bytes.length() * 8);
+    EXPECT_GT(average, 28.0) << "length:" << kLengths[l];
+    EXPECT_LT(average, 36.0) << "length:" << kLengths[l];
+  }
+}
+
+TEST(HashTest, Hash64Stream)
+{
+  srand(2014);
+  const std::string bytes = RandomBytes(200);
+  for (size_t length = 0; length <= bytes.length(); length += 7)
+  {
+    const StringPiece input(bytes.data(), length);
+    const uint64 expect = Hash64(input, 42);
+    for (size_t split = 0; split <= length; ++split)
+    {
+      Hash64Stream stream(42);
+      stream.Update(input.substr(0, split));
+      stream.Update(input.substr(split));
+      EXPECT_EQ(expect, stream.Finish()) << length << " " << split;
+    }
+
+    // Many small pieces of random sizes.
+    Hash64Stream stream(42);
+    for (size_t pos = 0; pos < length; )
+    {
+      const size_t piece = std::min<size_t>(rand() % 60, length - pos);
+      stream.Update(input.substr(pos, piece));
+      pos += piece;
+    }
+    EXPECT_EQ(expect, stream.Finish()) << length;
+  }
+
+  EXPECT_EQ(Hash64(""), Hash64Stream().Finish());
+}
+
+TEST(HashTest, Hash64IgnoringCaseASCII)
+{
+  srand(2014);
+  static const char kChars[] = "aAzZ@[`{09 \x80\xc1\xe1\xff";
+  for (size_t length = 0; length < 120; ++length)
+  {
+    std::string str;
+    for (size_t i = 0; i < length; ++i)
+      str += kChars[rand() % (sizeof(kChars) - 1)];
+    EXPECT_EQ(Hash64(StringToLowerASCII(str), 7),
+              Hash64IgnoringCaseASCII(str, 7)) << str;
+    EXPECT_EQ(Hash64IgnoringCaseASCII(StringToUpperASCII(str)),
+              Hash64IgnoringCaseASCII(str)) << str;
+  }
+}
+
+TEST(HashTest, Functors)
+{
+  std::unordered_map<std::string, int, StringHash> counts;
+  ++counts["a"];
+  ++counts["b"];
+  ++counts["a"];
+  EXPECT_EQ(2, counts["a"]);
+  EXPECT_EQ(1, counts["b"]);
+
+  std::unordered_set<std::string, CaseInsensitiveHashASCII,
+                     CaseInsensitiveEqualASCII> headers;
+  headers.insert("Content-Type");
+  EXPECT_FALSE(headers.insert("content-type").second);
+  EXPECT_TRUE(headers.count("CONTENT-TYPE"));
+  EXPECT_FALSE(headers.count("Content-Length"));
+  // Only ASCII letters are folded.
+  EXPECT_FALSE(CaseInsensitiveEqualASCII()("\xc3\xa9", "\xc3\x89"));
+}
+
+}; // namespace util
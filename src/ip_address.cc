@@ -0,0 +1,448 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/ip_address.h"
+
+#include <string.h>
+
+namespace util
+{
+
+const size_t IPAddress::kIPv4AddressSize;
+const size_t IPAddress::kIPv6AddressSize;
+const size_t IPAddress::kMaxIPv4StringLength;
+const size_t IPAddress::kMaxIPv6StringLength;
+
+static const char kLowerHexDigits[] = "0123456789abcdef";
+
+// The value of each hex digit, 0xFF for the other chars.
+#define XX 0xFF
+static const uint8 kHexValues[256] = {
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+   0,  1,  2,  3,  4,  5,  6,  7,  8,  9, XX, XX, XX, XX, XX, XX,
+  XX, 10, 11, 12, 13, 14, 15, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, 10, 11, 12, 13, 14, 15, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+};
+#undef XX
+
+static inline bool IsDecimalDigit(char c)
+{
+  return static_cast<unsigned char>(c - '0') <= 9;
+}
+
+// Parses the dotted decimal address [p, end) into a host order integer.
+static bool ParseIPv4Chars(const char* p, const char* end, uint32* address)
+{
+  uint32 result = 0;
+  for (int i = 0; i < 4; ++i)
+  {
+    if (i != 0)
+    {
+      if (p == end || *p != '.')
+        return false;
+      ++p;
+    }
+    if (p == end || !IsDecimalDigit(*p))
+      return false;
+    uint32 octet = *p++ - '0';
+    if (p != end && IsDecimalDigit(*p))
+    {
+      // "01" is not an octet: inet_aton() would read it as octal.
+      if (octet == 0)
+        return false;
+      octet = octet * 10 + (*p++ - '0');
+      if (p != end && IsDecimalDigit(*p))
+      {
+        octet = octet * 10 + (*p++ - '0');
+        if (octet > 255)
+          return false;
+      }
+    }
+    result = (result << 8) | octet;
+  }
+  if (p != end)
+    return false;
+  *address = result;
+  return true;
+}
+
+static inline void StoreIPv4(uint32 address, uint8* bytes)
+{
+  bytes[0] = static_cast<uint8>(address >> 24);
+  bytes[1] = static_cast<uint8>(address >> 16);
+  bytes[2] = static_cast<uint8>(address >> 8);
+  bytes[3] = static_cast<uint8>(address);
+}
+
+static inline uint32 LoadIPv4(const uint8* bytes)
+{
+  return (static_cast<uint32>(bytes[0]) << 24) |
+      (static_cast<uint32>(bytes[1]) << 16) |
+      (static_cast<uint32>(bytes[2]) << 8) | bytes[3];
+}
+
+bool
+ParseIPv4(const StringPiece& text, uint32* address)
+{
+  return ParseIPv4Chars(text.data(), text.data() + text.size(), address);
+}
+
+bool
+ParseIPv4(const StringPiece& text, uint8 address[4])
+{
+  uint32 value;
+  if (!ParseIPv4(text, &value))
+    return false;
+  StoreIPv4(value, address);
+  return true;
+}
+
+bool
+ParseIPv6(const StringPiece& text, uint8 address[16])
+{
+  const char* p = text.data();
+  const char* const end = p + text.size();
+
+  uint32 groups[8];
+  int count = 0;
+  // Index in |groups| of the "::", if any.
+  int gap = -1;
+
+  if (p != end && *p == ':')
+  {
+    if (end - p < 2 || p[1] != ':')
+      return false;
+    gap = 0;
+    p += 2;
+  }
+  while (p != end)
+  {
+    if (count == 8)
+      return false;
+    const char* const start = p;
+    uint32 group = kHexValues[static_cast<uint8>(*p)];
+    if (group > 0x0F)
+      return false;
+    for (++p; p != end && p - start < 4; ++p)
+    {
+      const uint32 digit = kHexValues[static_cast<uint8>(*p)];
+      if (digit > 0x0F)
+        break;
+      group = (group << 4) | digit;
+    }
+
+    if (p != end && *p == '.')
+    {
+      // The last 32 bits written as an IPv4 address.
+      uint32 ipv4;
+      if (count > 6 || !ParseIPv4Chars(start, end, &ipv4))
+        return false;
+      groups[count++] = ipv4 >> 16;
+      groups[count++] = ipv4 & 0xFFFF;
+      break;
+    }
+    groups[count++] = group;
+    if (p == end)
+      break;
+    // Also rejects groups of more than four digits.
+    if (*p != ':' || ++p == end)
+      return false;
+    if (*p == ':')
+    {
+      if (gap >= 0)
+        return false;
+      gap = count;
+      ++p;
+    }
+  }
+
+  // "::" stands for at least one group of zeros.
+  if (gap < 0 ? count != 8 : count == 8)
+    return false;
+
+  const int zeros = 8 - count;
+  for (int i = 0, j = 0; i < 8; ++i)
+  {
+    const uint32 group = (i >= gap && i < gap + zeros) ? 0 : groups[j++];
+    address[2 * i] = static_cast<uint8>(group >> 8);
+    address[2 * i + 1] = static_cast<uint8>(group);
+  }
+  return true;
+}
+
+static inline char* WriteOctet(uint32 octet, char* out)
+{
+  if (octet >= 100)
+  {
+    *out++ = static_cast<char>('0' + octet / 100);
+    octet %= 100;
+    *out++ = static_cast<char>('0' + octet / 10);
+    octet %= 10;
+  }
+  else if (octet >= 10)
+  {
+    *out++ = static_cast<char>('0' + octet / 10);
+    octet %= 10;
+  }
+  *out++ = static_cast<char>('0' + octet);
+  return out;
+}
+
+static char* WriteIPv4(const uint8* address, char* out)
+{
+  out = WriteOctet(address[0], out);
+  for (int i = 1; i < 4; ++i)
+  {
+    *out++ = '.';
+    out = WriteOctet(address[i], out);
+  }
+  return out;
+}
+
+size_t
+FormatIPv4(const uint8 address[4], char* out)
+{
+  return WriteIPv4(address, out) - out;
+}
+
+static inline char* WriteHexGroup(uint32 group, char* out)
+{
+  if (group >= 0x1000)
+    *out++ = kLowerHexDigits[group >> 12];
+  if (group >= 0x100)
+    *out++ = kLowerHexDigits[(group >> 8) & 0x0F];
+  if (group >= 0x10)
+    *out++ = kLowerHexDigits[(group >> 4) & 0x0F];
+  *out++ = kLowerHexDigits[group & 0x0F];
+  return out;
+}
+
+static bool IsIPv4Mapped(const uint8* address)
+{
+  static const uint8 kPrefix[] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF
+  };
+  return memcmp(address, kPrefix, sizeof(kPrefix)) == 0;
+}
+
+size_t
+FormatIPv6(const uint8 address[16], char* out)
+{
+  char* p = out;
+  if (IsIPv4Mapped(address))
+  {
+    memcpy(p, "::ffff:", 7);
+    return WriteIPv4(address + 12, p + 7) - out;
+  }
+
+  uint32 groups[8];
+  for (int i = 0; i < 8; ++i)
+    groups[i] = (static_cast<uint32>(address[2 * i]) << 8) | address[2 * i + 1];
+
+  // The first of the longest runs of two or more zero groups becomes "::".
+  int gap = -1;
+  int gap_length = 1;
+  for (int i = 0; i < 8;)
+  {
+    if (groups[i] != 0)
+    {
+      ++i;
+      continue;
+    }
+    int j = i + 1;
+    while (j < 8 && groups[j] == 0)
+      ++j;
+    if (j - i > gap_length)
+    {
+      gap = i;
+      gap_length = j - i;
+    }
+    i = j;
+  }
+
+  for (int i = 0; i < 8; ++i)
+  {
+    if (i == gap)
+    {
+      *p++ = ':';
+      *p++ = ':';
+      i += gap_length - 1;
+      continue;
+    }
+    if (i != 0 && i != gap + gap_length)
+      *p++ = ':';
+    p = WriteHexGroup(groups[i], p);
+  }
+  return p - out;
+}
+
+IPAddress::IPAddress(const uint8* bytes, size_t size)
+    : size_(0)
+{
+  if (size == kIPv4AddressSize || size == kIPv6AddressSize)
+  {
+    memcpy(bytes_, bytes, size);
+    size_ = static_cast<uint8>(size);
+  }
+}
+
+IPAddress
+IPAddress::IPv4(uint32 address)
+{
+  IPAddress result;
+  StoreIPv4(address, result.bytes_);
+  result.size_ = kIPv4AddressSize;
+  return result;
+}
+
+bool
+IPAddress::AssignFromIPLiteral(const StringPiece& text)
+{
+  // An IPv6 literal always has a ':' within its first five chars, while an
+  // IPv4 one never has.
+  if (text.empty())
+  {
+    size_ = 0;
+    return false;
+  }
+  const size_t probe = text.size() < 5 ? text.size() : 5;
+  if (memchr(text.data(), ':', probe))
+  {
+    size_ = ParseIPv6(text, bytes_) ? kIPv6AddressSize : 0;
+  }
+  else
+  {
+    size_ = ParseIPv4(text, bytes_) ? kIPv4AddressSize : 0;
+  }
+  return size_ != 0;
+}
+
+bool
+IPAddress::IsIPv4MappedIPv6() const
+{
+  return IsIPv6() && IsIPv4Mapped(bytes_);
+}
+
+uint32
+IPAddress::ToIPv4() const
+{
+  return LoadIPv4(bytes_);
+}
+
+size_t
+IPAddress::ToChars(char* out) const
+{
+  if (IsIPv4())
+    return FormatIPv4(bytes_, out);
+  if (IsIPv6())
+    return FormatIPv6(bytes_, out);
+  return 0;
+}
+
+std::string
+IPAddress::ToString() const
+{
+  char buffer[kMaxIPv6StringLength];
+  return std::string(buffer, ToChars(buffer));
+}
+
+bool
+IPAddress::operator==(const IPAddress& other) const
+{
+  return size_ == other.size_ && memcmp(bytes_, other.bytes_, size_) == 0;
+}
+
+bool
+IPAddress::operator<(const IPAddress& other) const
+{
+  if (size_ != other.size_)
+    return size_ < other.size_;
+  return memcmp(bytes_, other.bytes_, size_) < 0;
+}
+
+size_t
+ParseIPv4Batch(const StringPiece* texts, size_t count,
+               uint32* addresses, bool* valid)
+{
+  size_t parsed = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    uint32 address = 0;
+    valid[i] = ParseIPv4Chars(texts[i].data(),
+                              texts[i].data() + texts[i].size(), &address);
+    addresses[i] = valid[i] ? address : 0;
+    parsed += valid[i];
+  }
+  return parsed;
+}
+
+size_t
+ParseIPAddressBatch(const StringPiece* texts, size_t count,
+                    IPAddress* addresses)
+{
+  size_t parsed = 0;
+  for (size_t i = 0; i < count; ++i)
+    parsed += addresses[i].AssignFromIPLiteral(texts[i]);
+  return parsed;
+}
+
+void
+FormatIPv4Batch(const uint32* addresses, size_t count, char separator,
+                std::string* output)
+{
+  const size_t old_size = output->size();
+  output->resize(old_size + count * (IPAddress::kMaxIPv4StringLength + 1));
+  char* const begin = &(*output)[old_size];
+  char* out = begin;
+  for (size_t i = 0; i < count; ++i)
+  {
+    uint8 bytes[4];
+    StoreIPv4(addresses[i], bytes);
+    out = WriteIPv4(bytes, out);
+    *out++ = separator;
+  }
+  output->resize(old_size + (out - begin));
+}
+
+void
+FormatIPAddressBatch(const IPAddress* addresses, size_t count,
+                     char separator, std::string* output)
+{
+  const size_t old_size = output->size();
+  output->resize(old_size + count * (IPAddress::kMaxIPv6StringLength + 1));
+  char* const begin = &(*output)[old_size];
+  char* out = begin;
+  for (size_t i = 0; i < count; ++i)
+  {
+    out += addresses[i].ToChars(out);
+    *out++ = separator;
+  }
+  output->resize(old_size + (out - begin));
+}
+
+}; // namespace util
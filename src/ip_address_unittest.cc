@@ -0,0 +1,251 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/ip_address.h"
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "util/basictypes.h"
+#include "third_party/gtest/include/gtest/gtest.h"
+
+namespace util
+{
+
+TEST(IPAddressTest, ParseIPv4)
+{
+  static const struct
+  {
+    const char* input;
+    bool success;
+    uint32 expect;
+  } cases[] = {
+    {"0.0.0.0", true, 0},
+    {"127.0.0.1", true, 0x7F000001},
+    {"192.168.4.12", true, 0xC0A8040C},
+    {"255.255.255.255", true, 0xFFFFFFFF},
+    {"", false, 0},
+    {"1.2.3", false, 0},
+    {"1.2.3.4.5", false, 0},
+    {"1.2.3.256", false, 0},
+    {"1.2.3.1000", false, 0},
+    {"01.2.3.4", false, 0},
+    {"1..3.4", false, 0},
+    {"1.2.3.4.", false, 0},
+    {" 1.2.3.4", false, 0},
+    {"1.2.3.4 ", false, 0},
+    {"1.2.3.a", false, 0},
+    {"-1.2.3.4", false, 0},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    uint32 address = 0;
+    EXPECT_EQ(cases[i].success, ParseIPv4(cases[i].input, &address))
+        << "cases:" << i + 1;
+    if (cases[i].success)
+    {
+      EXPECT_EQ(cases[i].expect, address) << "cases:" << i + 1;
+    }
+
+    uint8 bytes[4];
+    uint8 expect[4];
+    EXPECT_EQ(cases[i].success, ParseIPv4(cases[i].input, bytes))
+        << "cases:" << i + 1;
+    EXPECT_EQ(cases[i].success, inet_pton(AF_INET, cases[i].input, expect) == 1)
+        << "cases:" << i + 1;
+    if (cases[i].success)
+    {
+      EXPECT_EQ(0, memcmp(expect, bytes, 4)) << "cases:" << i + 1;
+    }
+  }
+}
+
+TEST(IPAddressTest, ParseIPv6)
+{
+  static const struct
+  {
+    const char* input;
+    bool success;
+  } cases[] = {
+    {"::", true},
+    {"::1", true},
+    {"1::", true},
+    {"2001:db8::ff00:42:8329", true},
+    {"2001:0DB8:0000:0000:0000:FF00:0042:8329", true},
+    {"1:2:3:4:5:6:7:8", true},
+    {"1::8", true},
+    {"1:2:3:4:5:6::8", true},
+    {"::ffff:192.168.4.12", true},
+    {"64:ff9b::1.2.3.4", true},
+    {"1:2:3:4:5:6:1.2.3.4", true},
+    {"", false},
+    {":", false},
+    {":::", false},
+    {"1:2:3:4:5:6:7", false},
+    {"1:2:3:4:5:6:7:8:9", false},
+    {"1:2:3:4:5:6:7::8", false},
+    {"1:2:3:4:5:6:7:8::", false},
+    {"1::2::3", false},
+    {":1::2", false},
+    {"1::2:", false},
+    {"12345::", false},
+    {"g::", false},
+    {"::1.2.3", false},
+    {"::1.2.3.4:5", false},
+    {"1:2:3:4:5:6:7:1.2.3.4", false},
+    {"::01.2.3.4", false},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    uint8 bytes[16];
+    uint8 expect[16];
+    EXPECT_EQ(cases[i].success, ParseIPv6(cases[i].input, bytes))
+        << "cases:" << i + 1;
+    EXPECT_EQ(cases[i].success,
+              inet_pton(AF_INET6, cases[i].input, expect) == 1)
+        << "cases:" << i + 1;
+    if (cases[i].success)
+    {
+      EXPECT_EQ(0, memcmp(expect, bytes, 16)) << "cases:" << i + 1;
+    }
+  }
+}
+
+TEST(IPAddressTest, ToString)
+{
+  static const struct
+  {
+    const char* input;
+    const char* expect;
+  } cases[] = {
+    {"0.0.0.0", "0.0.0.0"},
+    {"10.0.100.255", "10.0.100.255"},
+    {"0:0:0:0:0:0:0:0", "::"},
+    {"0:0:0:0:0:0:0:1", "::1"},
+    {"1:0:0:0:0:0:0:0", "1::"},
+    {"2001:0DB8:0000:0000:0000:FF00:0042:8329", "2001:db8::ff00:42:8329"},
+    // A single zero group is not shortened.
+    {"2001:db8:0:1:1:1:1:1", "2001:db8:0:1:1:1:1:1"},
+    // The first of two longest runs is.
+    {"1:0:0:2:0:0:3:4", "1::2:0:0:3:4"},
+    {"1:0:0:2:0:0:0:3", "1:0:0:2::3"},
+    {"::ffff:c0a8:40c", "::ffff:192.168.4.12"},
+    {"ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff",
+     "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    IPAddress address;
+    EXPECT_TRUE(address.AssignFromIPLiteral(cases[i].input))
+        << "cases:" << i + 1;
+    EXPECT_EQ(cases[i].expect, address.ToString()) << "cases:" << i + 1;
+  }
+
+  EXPECT_EQ("", IPAddress().ToString());
+}
+
+TEST(IPAddressTest, IPAddress)
+{
+  IPAddress address;
+  EXPECT_FALSE(address.IsValid());
+  EXPECT_TRUE(address.AssignFromIPLiteral("192.168.4.12"));
+  EXPECT_TRUE(address.IsIPv4());
+  EXPECT_EQ(0xC0A8040Cu, address.ToIPv4());
+  EXPECT_TRUE(address == IPAddress::IPv4(0xC0A8040C));
+
+  EXPECT_TRUE(address.AssignFromIPLiteral("::ffff:192.168.4.12"));
+  EXPECT_TRUE(address.IsIPv6());
+  EXPECT_TRUE(address.IsIPv4MappedIPv6());
+  EXPECT_TRUE(address != IPAddress::IPv4(0xC0A8040C));
+  EXPECT_TRUE(IPAddress::IPv4(0xFFFFFFFF) < address);
+
+  EXPECT_FALSE(address.AssignFromIPLiteral("192.168.4"));
+  EXPECT_FALSE(address.IsValid());
+
+  static const uint8 kBytes[] = { 1, 2, 3 };
+  EXPECT_FALSE(IPAddress(kBytes, sizeof(kBytes)).IsValid());
+}
+
+TEST(IPAddressTest, RoundTripMatchesInet)
+{
+  srand(38);
+  for (int round = 0; round < 2000; ++round)
+  {
+    // Runs of zero groups are frequent, to exercise "::".
+    uint8 bytes[16];
+    for (size_t i = 0; i < sizeof(bytes); i += 2)
+    {
+      const bool zero = rand() % 2 == 0;
+      bytes[i] = zero ? 0 : static_cast<uint8>(rand() % 256);
+      bytes[i + 1] = zero ? 0 : static_cast<uint8>(rand() % 256);
+    }
+
+    char text[IPAddress::kMaxIPv6StringLength];
+    char expect[INET6_ADDRSTRLEN];
+    const size_t length = FormatIPv6(bytes, text);
+    ASSERT_TRUE(inet_ntop(AF_INET6, bytes, expect, sizeof(expect)));
+    uint8 parsed[16];
+    EXPECT_TRUE(ParseIPv6(StringPiece(text, length), parsed));
+    EXPECT_EQ(0, memcmp(bytes, parsed, 16));
+    // glibc writes ::a.b.c.d for the deprecated IPv4-compatible addresses.
+    if (memcmp(bytes, "\0\0\0\0\0\0\0\0\0\0\0\0", 12) != 0)
+    {
+      EXPECT_EQ(expect, std::string(text, length));
+    }
+
+    const size_t ipv4_length = FormatIPv4(bytes + 12, text);
+    ASSERT_TRUE(inet_ntop(AF_INET, bytes + 12, expect, sizeof(expect)));
+    EXPECT_EQ(expect, std::string(text, ipv4_length));
+    EXPECT_TRUE(ParseIPv4(StringPiece(text, ipv4_length), parsed));
+    EXPECT_EQ(0, memcmp(bytes + 12, parsed, 4));
+  }
+}
+
+TEST(IPAddressTest, Batch)
+{
+  const StringPiece texts[] = {
+    "10.0.0.1", "bad", "::1", "255.255.255.255",
+  };
+  uint32 ipv4[4];
+  bool valid[4];
+  EXPECT_EQ(2u, ParseIPv4Batch(texts, 4, ipv4, valid));
+  EXPECT_TRUE(valid[0]);
+  EXPECT_FALSE(valid[1]);
+  EXPECT_FALSE(valid[2]);
+  EXPECT_TRUE(valid[3]);
+  EXPECT_EQ(0x0A000001u, ipv4[0]);
+  EXPECT_EQ(0u, ipv4[1]);
+  EXPECT_EQ(0xFFFFFFFFu, ipv4[3]);
+
+  std::string output("ips:");
+  FormatIPv4Batch(ipv4, 4, ',', &output);
+  EXPECT_EQ("ips:10.0.0.1,0.0.0.0,0.0.0.0,255.255.255.255,", output);
+
+  IPAddress addresses[4];
+  EXPECT_EQ(3u, ParseIPAddressBatch(texts, 4, addresses));
+  EXPECT_FALSE(addresses[1].IsValid());
+  output.clear();
+  FormatIPAddressBatch(addresses, 4, '\n', &output);
+  EXPECT_EQ("10.0.0.1\n\n::1\n255.255.255.255\n", output);
+}
+
+}; // namespace util
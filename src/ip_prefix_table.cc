@@ -0,0 +1,362 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/ip_prefix_table.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+namespace util
+{
+
+const uint32 IPPrefixTable::kNoMatch;
+
+// An entry with this bit set links to a deeper level.
+static const uint32 kLink = 0x80000000;
+
+static const size_t kRootSize = 1 << 16;
+static const size_t kNodeSize = 1 << 8;
+static const size_t kIPv4Root = 0;
+static const size_t kIPv6Root = kRootSize;
+
+// The most levels below the first one: one per byte after the first two.
+static const uint8 kMaxIPv4Levels = 2;
+static const uint8 kMaxIPv6Levels = 14;
+
+// A lookup works on this many addresses at once in the batch forms.
+static const size_t kBatchSize = 16;
+
+// The header of a Serialize() image, followed by the entries.
+static const uint32 kImageMagic = 0x54504950;  // "PIPT"
+static const uint32 kImageVersion = 1;
+static const size_t kImageHeaderSize = 4;
+
+static inline size_t LinkedNode(uint32 entry)
+{
+  return static_cast<size_t>(entry & ~kLink) * kNodeSize;
+}
+
+static inline void Prefetch(const uint32* entry)
+{
+  __builtin_prefetch(entry);
+}
+
+// The first level of an empty table.
+static const std::vector<uint32>& EmptyEntries()
+{
+  static const std::vector<uint32> entries(2 * kRootSize,
+                                           IPPrefixTable::kNoMatch);
+  return entries;
+}
+
+IPPrefixTable::Builder::Builder()
+{
+}
+
+IPPrefixTable::Builder::~Builder()
+{
+}
+
+bool
+IPPrefixTable::Builder::Add(const IPAddress& prefix, size_t prefix_length,
+                            uint32 value)
+{
+  if (!prefix.IsValid() || prefix_length > prefix.size() * 8 ||
+      value >= kNoMatch)
+    return false;
+
+  Prefix entry;
+  memset(entry.bytes, 0, sizeof(entry.bytes));
+  memcpy(entry.bytes, prefix.bytes(), (prefix_length + 7) / 8);
+  if (prefix_length % 8 != 0)
+    entry.bytes[prefix_length / 8] &= 0xFF << (8 - prefix_length % 8);
+  entry.length = static_cast<uint8>(prefix_length);
+  entry.ipv6 = prefix.IsIPv6();
+  entry.value = value;
+  prefixes_.push_back(entry);
+  return true;
+}
+
+bool
+IPPrefixTable::Builder::Add(const StringPiece& cidr, uint32 value)
+{
+  const size_t slash = cidr.find('/');
+  IPAddress prefix;
+  if (!prefix.AssignFromIPLiteral(cidr.substr(0, slash)))
+    return false;
+  if (slash == StringPiece::npos)
+    return Add(prefix, prefix.size() * 8, value);
+
+  const StringPiece digits = cidr.substr(slash + 1);
+  if (digits.empty() || digits.size() > 3)
+    return false;
+  size_t prefix_length = 0;
+  for (size_t i = 0; i < digits.size(); ++i)
+  {
+    if (digits[i] < '0' || digits[i] > '9')
+      return false;
+    prefix_length = prefix_length * 10 + (digits[i] - '0');
+  }
+  return Add(prefix, prefix_length, value);
+}
+
+void
+IPPrefixTable::Builder::Build(IPPrefixTable* table) const
+{
+  // Shorter prefixes go first, so that each one only has to overwrite the
+  // entries it covers: all the longer ones, and the deeper levels they
+  // create, come after it.  The stable sort keeps the last of duplicate
+  // prefixes last.
+  std::vector<const Prefix*> order;
+  order.reserve(prefixes_.size());
+  for (size_t i = 0; i < prefixes_.size(); ++i)
+    order.push_back(&prefixes_[i]);
+  std::stable_sort(order.begin(), order.end(),
+                   [](const Prefix* a, const Prefix* b) {
+                     return a->length < b->length;
+                   });
+
+  std::vector<uint32> entries(2 * kRootSize, kNoMatch);
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    const Prefix& prefix = *order[i];
+    size_t node = prefix.ipv6 ? kIPv6Root : kIPv4Root;
+    size_t index = (prefix.bytes[0] << 8) | prefix.bytes[1];
+    size_t bits = 16;
+    while (prefix.length > bits)
+    {
+      // Entries covered by a shorter prefix pass its value down.
+      if (!(entries[node + index] & kLink))
+      {
+        const uint32 inherited = entries[node + index];
+        const size_t child = entries.size();
+        entries.resize(child + kNodeSize, inherited);
+        entries[node + index] = kLink | static_cast<uint32>(child / kNodeSize);
+      }
+      node = LinkedNode(entries[node + index]);
+      index = prefix.bytes[bits / 8];
+      bits += 8;
+    }
+
+    // The prefix covers 2^(bits - length) entries of the level; none of them
+    // is a link yet, since only longer prefixes make links.
+    const size_t span = static_cast<size_t>(1) << (bits - prefix.length);
+    std::fill(entries.begin() + node + (index & ~(span - 1)),
+              entries.begin() + node + (index & ~(span - 1)) + span,
+              prefix.value);
+  }
+
+  table->storage_.swap(entries);
+  table->Reset(&table->storage_[0], table->storage_.size());
+}
+
+IPPrefixTable::IPPrefixTable()
+{
+  Reset(&EmptyEntries()[0], EmptyEntries().size());
+}
+
+IPPrefixTable::~IPPrefixTable()
+{
+}
+
+void
+IPPrefixTable::Reset(const uint32* entries, size_t num_entries)
+{
+  entries_ = entries;
+  num_entries_ = num_entries;
+}
+
+uint32
+IPPrefixTable::LookupIPv4(uint32 address) const
+{
+  uint32 entry = entries_[kIPv4Root + (address >> 16)];
+  if (entry & kLink)
+  {
+    entry = entries_[LinkedNode(entry) + ((address >> 8) & 0xFF)];
+    if (entry & kLink)
+      entry = entries_[LinkedNode(entry) + (address & 0xFF)];
+  }
+  return entry;
+}
+
+uint32
+IPPrefixTable::Lookup(const IPAddress& address) const
+{
+  if (address.IsIPv4())
+    return LookupIPv4(address.ToIPv4());
+  if (!address.IsIPv6())
+    return kNoMatch;
+
+  const uint8* bytes = address.bytes();
+  uint32 entry = entries_[kIPv6Root + ((bytes[0] << 8) | bytes[1])];
+  for (size_t i = 2; entry & kLink; ++i)
+    entry = entries_[LinkedNode(entry) + bytes[i]];
+  return entry;
+}
+
+void
+IPPrefixTable::LookupIPv4Batch(const uint32* addresses, size_t count,
+                               uint32* values) const
+{
+  size_t positions[kBatchSize];
+  for (size_t begin = 0; begin < count; begin += kBatchSize)
+  {
+    const size_t n = std::min(kBatchSize, count - begin);
+    const uint32* batch = addresses + begin;
+    uint32* results = values + begin;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      positions[i] = kIPv4Root + (batch[i] >> 16);
+      Prefetch(entries_ + positions[i]);
+    }
+    // Each round reads the entries prefetched by the previous one.
+    for (size_t i = 0; i < n; ++i)
+    {
+      results[i] = entries_[positions[i]];
+      if (results[i] & kLink)
+      {
+        positions[i] = LinkedNode(results[i]) + ((batch[i] >> 8) & 0xFF);
+        Prefetch(entries_ + positions[i]);
+      }
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (results[i] & kLink)
+      {
+        results[i] = entries_[positions[i]];
+        if (results[i] & kLink)
+        {
+          positions[i] = LinkedNode(results[i]) + (batch[i] & 0xFF);
+          Prefetch(entries_ + positions[i]);
+        }
+      }
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (results[i] & kLink)
+        results[i] = entries_[positions[i]];
+    }
+  }
+}
+
+void
+IPPrefixTable::LookupBatch(const IPAddress* addresses, size_t count,
+                           uint32* values) const
+{
+  size_t positions[kBatchSize];
+  size_t depths[kBatchSize];
+  for (size_t begin = 0; begin < count; begin += kBatchSize)
+  {
+    const size_t n = std::min(kBatchSize, count - begin);
+    const IPAddress* batch = addresses + begin;
+    uint32* results = values + begin;
+
+    size_t pending = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      const uint8* bytes = batch[i].bytes();
+      results[i] = kNoMatch;
+      if (!batch[i].IsValid())
+        continue;
+      positions[i] = (batch[i].IsIPv6() ? kIPv6Root : kIPv4Root) +
+          ((bytes[0] << 8) | bytes[1]);
+      depths[i] = 2;
+      results[i] = kLink;
+      Prefetch(entries_ + positions[i]);
+      ++pending;
+    }
+    while (pending != 0)
+    {
+      for (size_t i = 0; i < n; ++i)
+      {
+        if (!(results[i] & kLink))
+          continue;
+        results[i] = entries_[positions[i]];
+        if (results[i] & kLink)
+        {
+          positions[i] = LinkedNode(results[i]) +
+              batch[i].bytes()[depths[i]++];
+          Prefetch(entries_ + positions[i]);
+        }
+        else
+        {
+          --pending;
+        }
+      }
+    }
+  }
+}
+
+void
+IPPrefixTable::Serialize(std::string* image) const
+{
+  const uint32 header[kImageHeaderSize] = {
+    kImageMagic, kImageVersion, static_cast<uint32>(num_entries_), 0
+  };
+  image->resize(sizeof(header) + MemoryUsage());
+  memcpy(&(*image)[0], header, sizeof(header));
+  memcpy(&(*image)[sizeof(header)], entries_, MemoryUsage());
+}
+
+bool
+IPPrefixTable::Attach(const void* data, size_t size)
+{
+  storage_.clear();
+  Reset(&EmptyEntries()[0], EmptyEntries().size());
+
+  const uint32* header = static_cast<const uint32*>(data);
+  if (reinterpret_cast<size_t>(data) % sizeof(uint32) != 0 ||
+      size < kImageHeaderSize * sizeof(uint32) ||
+      header[0] != kImageMagic || header[1] != kImageVersion)
+    return false;
+  const size_t num_entries = header[2];
+  if (num_entries < 2 * kRootSize ||
+      (num_entries - 2 * kRootSize) % kNodeSize != 0 ||
+      size != (kImageHeaderSize + num_entries) * sizeof(uint32))
+    return false;
+
+  // Check the links once, so that no lookup can leave the image or go
+  // deeper than the bytes of its address.  Links only go forward, so every
+  // node is seen after all the nodes linking to it.
+  const uint32* entries = header + kImageHeaderSize;
+  std::vector<uint8> levels_left((num_entries - 2 * kRootSize) / kNodeSize,
+                                 kMaxIPv6Levels);
+  for (size_t i = 0; i < num_entries; ++i)
+  {
+    if (!(entries[i] & kLink))
+      continue;
+    const size_t node = LinkedNode(entries[i]);
+    if (node <= i || node < 2 * kRootSize || node + kNodeSize > num_entries)
+      return false;
+    size_t left;
+    if (i < kIPv6Root)
+      left = kMaxIPv4Levels;
+    else if (i < 2 * kRootSize)
+      left = kMaxIPv6Levels;
+    else
+      left = levels_left[(i - 2 * kRootSize) / kNodeSize];
+    if (left == 0)
+      return false;
+    uint8& child_left = levels_left[(node - 2 * kRootSize) / kNodeSize];
+    child_left = std::min<uint8>(child_left, left - 1);
+  }
+  Reset(entries, num_entries);
+  return true;
+}
+
+}; // namespace util
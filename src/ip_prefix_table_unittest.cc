@@ -0,0 +1,240 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/ip_prefix_table.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "util/basictypes.h"
+#include "third_party/gtest/include/gtest/gtest.h"
+
+namespace util
+{
+
+TEST(IPPrefixTableTest, Lookup)
+{
+  IPPrefixTable::Builder builder;
+  EXPECT_TRUE(builder.Add("10.0.0.0/8", 1));
+  EXPECT_TRUE(builder.Add("10.1.0.0/16", 2));
+  EXPECT_TRUE(builder.Add("10.1.2.0/24", 3));
+  EXPECT_TRUE(builder.Add("10.1.2.128/25", 4));
+  EXPECT_TRUE(builder.Add("10.1.2.3", 5));
+  EXPECT_TRUE(builder.Add("192.168.0.0/15", 6));
+  EXPECT_TRUE(builder.Add("0.0.0.0/0", 7));
+  EXPECT_TRUE(builder.Add("2001:db8::/32", 8));
+  EXPECT_TRUE(builder.Add("2001:db8:1:2::/64", 9));
+  EXPECT_TRUE(builder.Add("2001:db8:1:2::1/128", 10));
+  // The host bits are ignored, and a duplicate replaces the value.
+  EXPECT_TRUE(builder.Add("172.16.99.1/12", 11));
+  EXPECT_TRUE(builder.Add("172.16.0.0/12", 12));
+
+  EXPECT_FALSE(builder.Add("10.0.0.0/33", 1));
+  EXPECT_FALSE(builder.Add("10.0.0.0/", 1));
+  EXPECT_FALSE(builder.Add("10.0.0.0/8/8", 1));
+  EXPECT_FALSE(builder.Add("10.0.0/8", 1));
+  EXPECT_FALSE(builder.Add("::/129", 1));
+  EXPECT_FALSE(builder.Add("10.0.0.0/8", IPPrefixTable::kNoMatch));
+
+  IPPrefixTable table;
+  EXPECT_EQ(IPPrefixTable::kNoMatch, table.LookupIPv4(0x0A000001));
+  builder.Build(&table);
+
+  static const struct
+  {
+    const char* address;
+    uint32 expect;
+  } cases[] = {
+    {"10.0.0.1", 1},
+    {"10.1.0.1", 2},
+    {"10.1.2.1", 3},
+    {"10.1.2.3", 5},
+    {"10.1.2.4", 3},
+    {"10.1.2.200", 4},
+    {"10.2.2.3", 1},
+    {"192.168.1.1", 6},
+    {"192.169.255.255", 6},
+    {"192.170.0.0", 7},
+    {"172.31.255.255", 12},
+    {"172.32.0.0", 7},
+    {"8.8.8.8", 7},
+    {"2001:db8::1", 8},
+    {"2001:db8:1:2::1", 10},
+    {"2001:db8:1:2::2", 9},
+    {"2001:db8:1:3::1", 8},
+    {"2001:db9::1", IPPrefixTable::kNoMatch},
+    {"::ffff:10.1.2.3", IPPrefixTable::kNoMatch},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    IPAddress address;
+    ASSERT_TRUE(address.AssignFromIPLiteral(cases[i].address));
+    EXPECT_EQ(cases[i].expect, table.Lookup(address)) << "cases:" << i + 1;
+    if (address.IsIPv4())
+    {
+      EXPECT_EQ(cases[i].expect, table.LookupIPv4(address.ToIPv4()))
+          << "cases:" << i + 1;
+    }
+  }
+  EXPECT_EQ(IPPrefixTable::kNoMatch, table.Lookup(IPAddress()));
+}
+
+// Finds the longest matching prefix the slow way.
+struct ReferencePrefix
+{
+  IPAddress prefix;
+  size_t length;
+  uint32 value;
+};
+
+static bool PrefixMatches(const ReferencePrefix& prefix,
+                          const IPAddress& address)
+{
+  if (prefix.prefix.size() != address.size())
+    return false;
+  for (size_t bit = 0; bit < prefix.length; ++bit)
+  {
+    const int mask = 0x80 >> (bit % 8);
+    if ((prefix.prefix.bytes()[bit / 8] & mask) !=
+        (address.bytes()[bit / 8] & mask))
+      return false;
+  }
+  return true;
+}
+
+static uint32 ReferenceLookup(const std::vector<ReferencePrefix>& prefixes,
+                              const IPAddress& address)
+{
+  uint32 value = IPPrefixTable::kNoMatch;
+  size_t longest = 0;
+  for (size_t i = 0; i < prefixes.size(); ++i)
+  {
+    if (PrefixMatches(prefixes[i], address) &&
+        (value == IPPrefixTable::kNoMatch || prefixes[i].length >= longest))
+    {
+      value = prefixes[i].value;
+      longest = prefixes[i].length;
+    }
+  }
+  return value;
+}
+
+// Addresses sharing a few leading bytes, so that prefixes nest often.
+static IPAddress RandomAddress(bool ipv6)
+{
+  uint8 bytes[16] = { 0 };
+  const size_t size = ipv6 ? 16 : 4;
+  for (size_t i = 0; i < size; ++i)
+    bytes[i] = static_cast<uint8>(i < size / 2 ? rand() % 2 : rand() % 256);
+  return IPAddress(bytes, size);
+}
+
+TEST(IPPrefixTableTest, MatchesReference)
+{
+  srand(39);
+  std::vector<ReferencePrefix> prefixes;
+  IPPrefixTable::Builder builder;
+  for (int i = 0; i < 300; ++i)
+  {
+    ReferencePrefix prefix;
+    prefix.prefix = RandomAddress(i % 3 == 0);
+    prefix.length = rand() % (prefix.prefix.size() * 8 + 1);
+    prefix.value = i;
+    prefixes.push_back(prefix);
+    ASSERT_TRUE(builder.Add(prefix.prefix, prefix.length, prefix.value));
+  }
+  IPPrefixTable table;
+  builder.Build(&table);
+
+  std::string image;
+  table.Serialize(&image);
+  // std::string data is not guaranteed to be aligned.
+  std::vector<uint32> aligned(image.size() / sizeof(uint32));
+  memcpy(&aligned[0], image.data(), image.size());
+  IPPrefixTable attached;
+  ASSERT_TRUE(attached.Attach(&aligned[0], image.size()));
+  EXPECT_EQ(table.MemoryUsage(), attached.MemoryUsage());
+
+  std::vector<IPAddress> addresses;
+  std::vector<uint32> ipv4;
+  for (int i = 0; i < 2000; ++i)
+  {
+    addresses.push_back(RandomAddress(i % 2 == 0));
+    if (addresses.back().IsIPv4())
+      ipv4.push_back(addresses.back().ToIPv4());
+  }
+
+  std::vector<uint32> values(addresses.size());
+  std::vector<uint32> ipv4_values(ipv4.size());
+  table.LookupBatch(&addresses[0], addresses.size(), &values[0]);
+  attached.LookupIPv4Batch(&ipv4[0], ipv4.size(), &ipv4_values[0]);
+  for (size_t i = 0, j = 0; i < addresses.size(); ++i)
+  {
+    const uint32 expect = ReferenceLookup(prefixes, addresses[i]);
+    EXPECT_EQ(expect, table.Lookup(addresses[i])) << addresses[i].ToString();
+    EXPECT_EQ(expect, attached.Lookup(addresses[i]))
+        << addresses[i].ToString();
+    EXPECT_EQ(expect, values[i]) << addresses[i].ToString();
+    if (addresses[i].IsIPv4())
+    {
+      EXPECT_EQ(expect, ipv4_values[j++]) << addresses[i].ToString();
+    }
+  }
+}
+
+TEST(IPPrefixTableTest, AttachRejectsBadImages)
+{
+  IPPrefixTable::Builder builder;
+  builder.Add("10.1.2.0/24", 1);
+  IPPrefixTable table;
+  builder.Build(&table);
+  std::string image;
+  table.Serialize(&image);
+  std::vector<uint32> words(image.size() / sizeof(uint32));
+  memcpy(&words[0], image.data(), image.size());
+
+  IPPrefixTable attached;
+  ASSERT_TRUE(attached.Attach(&words[0], image.size()));
+  EXPECT_EQ(1u, attached.LookupIPv4(0x0A010203));
+
+  // Truncated.
+  EXPECT_FALSE(attached.Attach(&words[0], image.size() - 4));
+  EXPECT_EQ(IPPrefixTable::kNoMatch, attached.LookupIPv4(0x0A010203));
+  // Misaligned.
+  EXPECT_FALSE(attached.Attach(reinterpret_cast<char*>(&words[0]) + 1,
+                               image.size() - 1));
+
+  // A link out of the image, and one back to a node before it.
+  const size_t header = 4;
+  const size_t link = header + 0x0A01;
+  std::vector<uint32> bad(words);
+  bad[link] = 0x80000000 | 0x7FFFFF;
+  EXPECT_FALSE(attached.Attach(&bad[0], image.size()));
+  bad = words;
+  bad[header + 2 * 65536 + 2] = words[link];
+  EXPECT_FALSE(attached.Attach(&bad[0], image.size()));
+
+  // Bad magic.
+  bad = words;
+  bad[0] = 0;
+  EXPECT_FALSE(attached.Attach(&bad[0], image.size()));
+}
+
+}; // namespace util
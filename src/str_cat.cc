@@ -0,0 +1,121 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/str_cat.h"
+
+#include <string.h>
+
+namespace util
+{
+
+// "00" to "99", so that digits are written two at a time.
+static const char kDigitPairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536"
+    "37383940414243444546474849505152535455565758596061626364656667686970717273"
+    "7475767778798081828384858687888990919293949596979899";
+
+// Writes the decimal digits of |value| so that they end at |end|, and returns
+// the first one.
+static char* WriteDecimalBackward(unsigned long long value, char* end)
+{
+  while (value >= 100)
+  {
+    const size_t pair = static_cast<size_t>(value % 100) * 2;
+    value /= 100;
+    end -= 2;
+    memcpy(end, kDigitPairs + pair, 2);
+  }
+  if (value >= 10)
+  {
+    end -= 2;
+    memcpy(end, kDigitPairs + value * 2, 2);
+  }
+  else
+  {
+    *--end = static_cast<char>('0' + value);
+  }
+  return end;
+}
+
+void
+StrCatArg::SetUnsigned(unsigned long long value)
+{
+  char* end = digits_ + kBufferSize;
+  const char* begin = WriteDecimalBackward(value, end);
+  piece_.set(begin, end - begin);
+}
+
+void
+StrCatArg::SetSigned(long long value)
+{
+  char* end = digits_ + kBufferSize;
+  if (value >= 0)
+  {
+    SetUnsigned(value);
+    return;
+  }
+
+  // Negating in unsigned arithmetic also works for the smallest value.
+  char* begin = WriteDecimalBackward(0 - static_cast<unsigned long long>(value),
+                                     end);
+  *--begin = '-';
+  piece_.set(begin, end - begin);
+}
+
+static size_t TotalSize(std::initializer_list<StringPiece> pieces)
+{
+  size_t size = 0;
+  for (const StringPiece* piece = pieces.begin(); piece != pieces.end();
+       ++piece)
+    size += piece->size();
+  return size;
+}
+
+std::string
+StrCatPieces(std::initializer_list<StringPiece> pieces)
+{
+  std::string result;
+  result.reserve(TotalSize(pieces));
+  for (const StringPiece* piece = pieces.begin(); piece != pieces.end();
+       ++piece)
+    piece->AppendToString(&result);
+  return result;
+}
+
+void
+StrAppendPieces(std::string* dest, std::initializer_list<StringPiece> pieces)
+{
+  const size_t size = dest->size() + TotalSize(pieces);
+  if (size > dest->capacity())
+  {
+    // Build the result aside: pieces pointing into |dest| stay valid until it
+    // is replaced.
+    std::string result;
+    result.reserve(size);
+    result.append(*dest);
+    for (const StringPiece* piece = pieces.begin(); piece != pieces.end();
+         ++piece)
+      piece->AppendToString(&result);
+    dest->swap(result);
+    return;
+  }
+
+  for (const StringPiece* piece = pieces.begin(); piece != pieces.end();
+       ++piece)
+    piece->AppendToString(dest);
+}
+
+}; // namespace util
@@ -0,0 +1,95 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/str_cat.h"
+
+#include <sstream>
+#include <stdlib.h>
+
+#include "third_party/gtest/include/gtest/gtest.h"
+
+namespace util
+{
+
+TEST(StrCatTest, Strings)
+{
+  const std::string str("string");
+  const StringPiece piece("piece");
+  EXPECT_EQ("", StrCat());
+  EXPECT_EQ("", StrCat(""));
+  EXPECT_EQ("literal", StrCat("literal"));
+  EXPECT_EQ("literal-string-piece", StrCat("literal-", str, "-", piece));
+  EXPECT_EQ("ab", StrCat(std::string("a"), StringPiece(), "b"));
+}
+
+TEST(StrCatTest, Integers)
+{
+  static const struct
+  {
+    long long value;
+    const char* output;
+  } cases[] = {
+    {0, "0"},
+    {7, "7"},
+    {10, "10"},
+    {99, "99"},
+    {100, "100"},
+    {-1, "-1"},
+    {-10, "-10"},
+    {1234567890123LL, "1234567890123"},
+    {kint64max, "9223372036854775807"},
+    {kint64min, "-9223372036854775808"},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+    EXPECT_EQ(cases[i].output, StrCat(cases[i].value)) << "cases:" << i + 1;
+
+  EXPECT_EQ("18446744073709551615", StrCat(kuint64max));
+  EXPECT_EQ("-2147483648", StrCat(kint32min));
+  EXPECT_EQ("4294967295", StrCat(kuint32max));
+  EXPECT_EQ("id=42 size=7 delta=-3",
+            StrCat("id=", 42, " size=", sizeof(int64) - 1, " delta=", -3L));
+
+  srand(2014);
+  for (int i = 0; i < 1000; ++i)
+  {
+    const long long value =
+        (static_cast<long long>(rand()) << 33) ^ rand() ^ -(i & 1);
+    std::ostringstream expect;
+    expect << value;
+    EXPECT_EQ(expect.str(), StrCat(value));
+  }
+}
+
+TEST(StrCatTest, StrAppend)
+{
+  std::string dest = "a";
+  StrAppend(&dest);
+  EXPECT_EQ("a", dest);
+  StrAppend(&dest, "b", std::string("c"), 1, StringPiece("d"));
+  EXPECT_EQ("abc1d", dest);
+
+  // Arguments may point into |dest|, whether or not it has to grow.
+  std::string self = "xy";
+  self.shrink_to_fit();
+  StrAppend(&self, self, StringPiece(self).substr(1));
+  EXPECT_EQ("xyxyy", self);
+  self.reserve(100);
+  StrAppend(&self, self, "!");
+  EXPECT_EQ("xyxyyxyxyy!", self);
+}
+
+}; // namespace util
@@ -291,45 +291,45 @@ class BaseHexIteratorRangeToIntTraits
 
 template <typename VALUE, int BASE>
 class StringToNumberTraits
-    : public BaseIteratorRangeToNumberTraits<std::string::const_iterator,
+    : public BaseIteratorRangeToNumberTraits<StringPiece::const_iterator,
                                              VALUE,
                                              BASE>
 {};
 
 template <typename VALUE>
 bool
-StringToIntImpl(const std::string &_input, VALUE *_output)
+StringToIntImpl(const StringPiece &_input, VALUE *_output)
 {
   return IteratorRangeToNumber<StringToNumberTraits<VALUE, 10> >::Invoke(
       _input.begin(), _input.end(), _output);
 }
 
 bool
-StringToInt(const std::string &_input, int *_output)
+StringToInt(const StringPiece &_input, int *_output)
 {
   return StringToIntImpl(_input, _output);
 }
 
 bool
-StringToUint(const std::string &_input, unsigned *_output)
+StringToUint(const StringPiece &_input, unsigned *_output)
 {
   return StringToIntImpl(_input, _output);
 }
 
 bool
-StringToInt64(const std::string &_input, int64 *_output)
+StringToInt64(const StringPiece &_input, int64 *_output)
 {
   return StringToIntImpl(_input, _output);
 }
 
 bool
-StringToUint64(const std::string &_input, uint64 *_output)
+StringToUint64(const StringPiece &_input, uint64 *_output)
 {
   return StringToIntImpl(_input, _output);
 }
 
 bool
-StringToSizeT(const std::string &_input, size_t *_output)
+StringToSizeT(const StringPiece &_input, size_t *_output)
 {
   return StringToIntImpl(_input, _output);
 }
@@ -353,7 +353,7 @@ HexEncode(const void *_bytes, size_t _size)
 }
 
 
-typedef BaseHexIteratorRangeToIntTraits<std::string::const_iterator>
+typedef BaseHexIteratorRangeToIntTraits<StringPiece::const_iterator>
 HexIteratorRangeToIntTraits;
 
 template<typename STR>
@@ -375,22 +375,24 @@ bool HexStringToBytesT(const STR& input, std::vector<uint8>* output)
 }
 
 bool
-HexStringToInt(const std::string &_input, int *_output)
+HexStringToInt(const StringPiece &_input, int *_output)
 {
   return IteratorRangeToNumber<HexIteratorRangeToIntTraits>::Invoke(
       _input.begin(), _input.end(), _output);
 }
 
 bool
-HexStringToBytes(const std::string &_input, std::vector<uint8> *_output)
+HexStringToBytes(const StringPiece &_input, std::vector<uint8> *_output)
 {
+  if (_input.find(' ') == StringPiece::npos)
+    return HexStringToBytesT(_input, _output);
   std::string inputNoWhitespace;
-  ReplaceChars(_input, " ", "", &inputNoWhitespace);
+  RemoveChars(_input.as_string(), " ", &inputNoWhitespace);
   return HexStringToBytesT(inputNoWhitespace, _output);
 }
 
 bool
-HexStringToASCIIString(const std::string &_input, std::string &_output)
+HexStringToASCIIString(const StringPiece &_input, std::string &_output)
 {
   std::vector<uint8> output_vec;
   bool result = HexStringToBytes(_input, &output_vec);
@@ -442,7 +444,7 @@ BytesToHexString(const std::vector<uint8> &_input, std::string *_output)
 }
 
 void
-ASCIIStringToHexString(const std::string &_input, std::string *_output)
+ASCIIStringToHexString(const StringPiece &_input, std::string *_output)
 {
   const std::vector<uint8> input_vec(_input.begin(), _input.end());
   BytesToHexString(input_vec, _output);
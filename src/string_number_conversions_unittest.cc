@@ -75,6 +75,32 @@ TEST(StringNumberConversionsTest, StringToInt)
   EXPECT_EQ(6, output);
 }
 
+TEST(StringNumberConversionsTest, StringToIntFromSlices)
+{
+  // Each field is parsed in place, without a NUL after it.
+  const char buffer[] = "12,-34,ff,567";
+  int output = 0;
+  EXPECT_TRUE(StringToInt(StringPiece(buffer, 2), &output));
+  EXPECT_EQ(12, output);
+  EXPECT_TRUE(StringToInt(StringPiece(buffer + 3, 3), &output));
+  EXPECT_EQ(-34, output);
+  EXPECT_FALSE(StringToInt(StringPiece(buffer, 4), &output));
+  EXPECT_TRUE(HexStringToInt(StringPiece(buffer + 7, 2), &output));
+  EXPECT_EQ(255, output);
+
+  uint64 output64 = 0;
+  EXPECT_TRUE(StringToUint64(StringPiece(buffer + 10, 3), &output64));
+  EXPECT_EQ(567U, output64);
+  size_t output_size = 0;
+  EXPECT_TRUE(StringToSizeT(StringPiece(buffer + 10, 2), &output_size));
+  EXPECT_EQ(56U, output_size);
+
+  std::vector<uint8> bytes;
+  EXPECT_TRUE(HexStringToBytes(StringPiece(buffer + 7, 2), &bytes));
+  ASSERT_EQ(1U, bytes.size());
+  EXPECT_EQ(0xFF, bytes[0]);
+}
+
 TEST(StringNumberConversionsTest, StringToInt64)
 {
   static const struct
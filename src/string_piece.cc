@@ -0,0 +1,83 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/string_piece.h"
+
+#include <algorithm>
+#include <ostream>
+
+namespace util
+{
+
+const StringPiece::size_type StringPiece::npos = std::string::npos;
+
+StringPiece::size_type
+StringPiece::find(char c, size_type pos) const
+{
+  if (pos >= length_)
+    return npos;
+
+  const void* result = memchr(ptr_ + pos, c, length_ - pos);
+  return (result == NULL) ? npos :
+      static_cast<const char*>(result) - ptr_;
+}
+
+StringPiece::size_type
+StringPiece::find(const StringPiece& s, size_type pos) const
+{
+  if (pos > length_)
+    return npos;
+
+  const char* result = std::search(ptr_ + pos, ptr_ + length_,
+                                   s.ptr_, s.ptr_ + s.length_);
+  const size_type xpos = result - ptr_;
+  return (xpos + s.length_ <= length_) ? xpos : npos;
+}
+
+StringPiece::size_type
+StringPiece::rfind(char c, size_type pos) const
+{
+  if (length_ == 0)
+    return npos;
+
+  for (size_type i = std::min(pos, length_ - 1); ; --i)
+  {
+    if (ptr_[i] == c)
+      return i;
+    if (i == 0)
+      break;
+  }
+  return npos;
+}
+
+StringPiece
+StringPiece::substr(size_type pos, size_type n) const
+{
+  if (pos > length_)
+    pos = length_;
+  if (n > length_ - pos)
+    n = length_ - pos;
+  return StringPiece(ptr_ + pos, n);
+}
+
+std::ostream&
+operator<<(std::ostream& o, const StringPiece& piece)
+{
+  o.write(piece.data(), static_cast<std::streamsize>(piece.size()));
+  return o;
+}
+
+}; // namespace util
@@ -0,0 +1,86 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/string_piece.h"
+
+#include "third_party/gtest/include/gtest/gtest.h"
+
+namespace util
+{
+
+TEST(StringPieceTest, Constructors)
+{
+  const std::string str("i love dog");
+  EXPECT_EQ(str, StringPiece(str).as_string());
+  EXPECT_EQ(str, StringPiece("i love dog").as_string());
+  EXPECT_EQ("i love", StringPiece(str.data(), 6).as_string());
+  EXPECT_EQ("love", StringPiece(str.begin() + 2, str.begin() + 6).as_string());
+
+  EXPECT_TRUE(StringPiece().empty());
+  EXPECT_TRUE(StringPiece(static_cast<const char*>(NULL)).empty());
+  EXPECT_TRUE(StringPiece(str.begin(), str.begin()).empty());
+  EXPECT_EQ("", StringPiece().as_string());
+}
+
+TEST(StringPieceTest, Compare)
+{
+  EXPECT_TRUE(StringPiece("abc") == StringPiece("abc"));
+  EXPECT_TRUE(StringPiece() == StringPiece(""));
+  EXPECT_TRUE(StringPiece("abc") != StringPiece("abd"));
+  EXPECT_TRUE(StringPiece("ab") < StringPiece("abc"));
+  EXPECT_TRUE(StringPiece("abd") > StringPiece("abc"));
+  EXPECT_TRUE(StringPiece("abc") <= StringPiece("abc"));
+  EXPECT_TRUE(StringPiece("abc") >= StringPiece("ab"));
+  EXPECT_EQ(0, StringPiece("abc").compare("abc"));
+
+  EXPECT_TRUE(StringPiece("javascript:url").starts_with("javascript"));
+  EXPECT_FALSE(StringPiece("java").starts_with("javascript"));
+  EXPECT_TRUE(StringPiece("Foo.plugin").ends_with(".plugin"));
+  EXPECT_TRUE(StringPiece("Foo.plugin").ends_with(""));
+  EXPECT_FALSE(StringPiece("plugin").ends_with(".plugin"));
+}
+
+TEST(StringPieceTest, FindAndSubstr)
+{
+  const StringPiece piece("one,two,three");
+  EXPECT_EQ(3U, piece.find(','));
+  EXPECT_EQ(7U, piece.find(',', 4));
+  EXPECT_EQ(StringPiece::npos, piece.find('x'));
+  EXPECT_EQ(StringPiece::npos, piece.find(',', 100));
+  EXPECT_EQ(4U, piece.find("two"));
+  EXPECT_EQ(0U, piece.find(""));
+  EXPECT_EQ(StringPiece::npos, piece.find("four"));
+  EXPECT_EQ(7U, piece.rfind(','));
+  EXPECT_EQ(3U, piece.rfind(',', 6));
+  EXPECT_EQ(StringPiece::npos, piece.rfind(',', 2));
+
+  EXPECT_EQ("two", piece.substr(4, 3).as_string());
+  EXPECT_EQ("three", piece.substr(8).as_string());
+  EXPECT_EQ("", piece.substr(100).as_string());
+
+  StringPiece trimmed = piece;
+  trimmed.remove_prefix(4);
+  trimmed.remove_suffix(6);
+  EXPECT_EQ("two", trimmed.as_string());
+
+  std::string out = "x";
+  trimmed.AppendToString(&out);
+  EXPECT_EQ("xtwo", out);
+  trimmed.CopyToString(&out);
+  EXPECT_EQ("two", out);
+}
+
+} // namespace util
@@ -16,38 +16,151 @@
 
 #include "util/string_split.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "src/byte_mask.h"
+#include "src/thread_joiner.h"
+#include "util/basictypes.h"
+#include "util/cpu.h"
+#include "util/hash.h"
 #include "util/string_util.h"
 
 namespace util
 {
 
+// The number of delimiter offsets looked up per call of FindByteOffsets() or
+// StringSearcher::FindAll().
+static const size_t kDelimiterBatch = 128;
+
+// Delimiters are found 64 bytes at a time: the bytes equal to the delimiter
+// are turned into a 64-bit mask, whose set bits are then read off.  Each
+// kernel stores the offsets from |base| in |offsets| from |*count| on, stops
+// at the end of the last whole block or once |max_count| offsets are stored,
+// and returns where the caller has to carry on.
+#if defined(HAVE_TARGET_ATTRIBUTE)
+TARGET_AVX2
+static const char* FindByteOffsetsAVX2(const char* base, const char* p,
+                                       const char* end, char c,
+                                       size_t* offsets, size_t max_count,
+                                       size_t* count)
+{
+  size_t n = *count;
+  for (; end - p >= 64; p += 64)
+  {
+    for (uint64 mask = ByteMask64AVX2(p, c); mask != 0; mask &= mask - 1)
+    {
+      if (n == max_count)
+      {
+        *count = n;
+        return p;
+      }
+      offsets[n++] = p - base + __builtin_ctzll(mask);
+    }
+  }
+  *count = n;
+  return p;
+}
+#endif
+
+#if defined(__SSE2__)
+static const char* FindByteOffsetsSSE2(const char* base, const char* p,
+                                       const char* end, char c,
+                                       size_t* offsets, size_t max_count,
+                                       size_t* count)
+{
+  size_t n = *count;
+  for (; end - p >= 64; p += 64)
+  {
+    for (uint64 mask = ByteMask64SSE2(p, c); mask != 0; mask &= mask - 1)
+    {
+      if (n == max_count)
+      {
+        *count = n;
+        return p;
+      }
+      offsets[n++] = p - base + __builtin_ctzll(mask);
+    }
+  }
+  *count = n;
+  return p;
+}
+#endif
+
+// Stores in |offsets| the positions in |str| of its first |max_count| bytes
+// equal to |c| at or after |pos|, and returns how many were stored.
+static size_t FindByteOffsets(const StringPiece& str, size_t pos, char c,
+                              size_t* offsets, size_t max_count)
+{
+  const char* p = str.data() + pos;
+  const char* const end = str.end();
+  size_t count = 0;
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasAVX2())
+    p = FindByteOffsetsAVX2(str.data(), p, end, c, offsets, max_count,
+                            &count);
+#endif
+#if defined(__SSE2__)
+  if (count != max_count)
+    p = FindByteOffsetsSSE2(str.data(), p, end, c, offsets, max_count,
+                            &count);
+#endif
+  for (; p != end && count != max_count; ++p)
+  {
+    if (*p == c)
+      offsets[count++] = p - str.data();
+  }
+  return count;
+}
+
+// The splitters read a StringPiece and build each field of type STR straight
+// from the slice it covers, so no temporary string is made per field.
+template<typename STR>
+static inline void AddField(const char* begin, const char* end,
+                            bool trim_whitespace, std::vector<STR>* r)
+{
+  StringPiece field(begin, end - begin);
+  if (trim_whitespace)
+    field = TrimWhitespaceASCII(field, TRIM_ALL);
+  r->push_back(STR(field.data(), field.size()));
+}
+
 template<typename STR>
-static void SplitStringT(const STR& str,
-                         const typename STR::value_type s,
+static void SplitStringT(const StringPiece& str,
+                         char s,
                          bool trim_whitespace,
                          std::vector<STR>* r)
 {
   r->clear();
+  size_t offsets[kDelimiterBatch];
   size_t last = 0;
-  size_t c = str.size();
-  for (size_t i = 0; i <= c; ++i)
+  for (;;)
   {
-    if (i == c || str[i] == s)
+    const size_t count =
+        FindByteOffsets(str, last, s, offsets, kDelimiterBatch);
+    for (size_t i = 0; i < count; ++i)
     {
-      STR tmp(str, last, i - last);
-      if (trim_whitespace)
-        TrimWhitespace(tmp, TRIM_ALL, &tmp);
-      // Avoid converting an empty or all-whitespace source string into a vector
-      // of one empty string.
-      if (i != c || !r->empty() || !tmp.empty())
-        r->push_back(tmp);
-      last = i + 1;
+      AddField(str.data() + last, str.data() + offsets[i], trim_whitespace,
+               r);
+      last = offsets[i] + 1;
     }
+    if (count != kDelimiterBatch)
+      break;
   }
+
+  // Avoid converting an empty or all-whitespace source string into a vector
+  // of one empty string.
+  StringPiece tail(str.data() + last, str.size() - last);
+  if (trim_whitespace)
+    tail = TrimWhitespaceASCII(tail, TRIM_ALL);
+  if (!r->empty() || !tail.empty())
+    r->push_back(STR(tail.data(), tail.size()));
 }
 
 void
-SplitString(const std::string& str,
+SplitString(const StringPiece& str,
             char c,
             std::vector<std::string>* r)
 {
@@ -55,7 +168,7 @@ SplitString(const std::string& str,
 }
 
 bool
-SplitStringIntoKeyValues(const std::string& line,
+SplitStringIntoKeyValues(const StringPiece& line,
                          char key_value_delimiter,
                          std::string* key, std::vector<std::string>* values)
 {
@@ -63,106 +176,406 @@ SplitStringIntoKeyValues(const std::string& line,
   values->clear();
 
   // Find the key string.
-  size_t end_key_pos = line.find_first_of(key_value_delimiter);
-  if (end_key_pos == std::string::npos)
+  size_t end_key_pos = line.find(key_value_delimiter);
+  if (end_key_pos == StringPiece::npos)
   {
     return false;    // no key
   }
-  key->assign(line, 0, end_key_pos);
+  key->assign(line.data(), end_key_pos);
 
   // Find the values string.
-  std::string remains(line, end_key_pos, line.size() - end_key_pos);
-  size_t begin_values_pos = remains.find_first_not_of(key_value_delimiter);
-  if (begin_values_pos == std::string::npos)
+  size_t begin_values_pos = end_key_pos;
+  while (begin_values_pos < line.size() &&
+         line[begin_values_pos] == key_value_delimiter)
+    ++begin_values_pos;
+  if (begin_values_pos == line.size())
   {
     return false;   // no value
   }
-  std::string values_string(remains, begin_values_pos,
-                            remains.size() - begin_values_pos);
 
   // Construct the values vector.
-  values->push_back(values_string);
+  values->push_back(std::string(line.data() + begin_values_pos,
+                                line.size() - begin_values_pos));
   return true;
 }
 
+static inline void ClearPairs(KeyValueMap* pairs)
+{
+  pairs->Clear();
+}
+
+template <typename STR>
+static inline void ClearPairs(std::vector<std::pair<STR, STR> >* pairs)
+{
+  pairs->clear();
+}
+
+static inline void AddPair(const StringPiece& key, const StringPiece& value,
+                           KeyValueMap* pairs)
+{
+  pairs->Insert(key, value);
+}
+
+template <typename STR>
+static inline void AddPair(const StringPiece& key, const StringPiece& value,
+                           std::vector<std::pair<STR, STR> >* pairs)
+{
+  pairs->push_back(std::make_pair(STR(key.data(), key.size()),
+                                  STR(value.data(), value.size())));
+}
+
+// The pairs are read one after the other from |line| and each key and
+// value is added as the slice it is, so the only copies are those the
+// container makes.  Same rules as SplitStringIntoKeyValues() for the key
+// and the value of a pair.
+template <typename PAIRS>
+static bool SplitStringIntoKeyValuePairsT(const StringPiece& line,
+                                          char key_value_delimiter,
+                                          char key_value_pair_delimiter,
+                                          PAIRS* kv_pairs)
+{
+  ClearPairs(kv_pairs);
+
+  bool success = true;
+  for (const StringPiece& pair :
+           StringSplitter(line, key_value_pair_delimiter,
+                          StringSplitter::TRIM_WHITESPACE |
+                          StringSplitter::SKIP_EMPTY))
+  {
+    // Don't stop at a pair without a key or a value, to allow for keys
+    // without associated values; just record that our split failed.
+    const size_t end_key_pos = pair.find(key_value_delimiter);
+    if (end_key_pos == StringPiece::npos)
+    {
+      success = false;
+      AddPair(StringPiece(), StringPiece(), kv_pairs);
+      continue;
+    }
+    size_t begin_value_pos = end_key_pos;
+    while (begin_value_pos < pair.size() &&
+           pair[begin_value_pos] == key_value_delimiter)
+      ++begin_value_pos;
+    if (begin_value_pos == pair.size())
+      success = false;
+    AddPair(pair.substr(0, end_key_pos), pair.substr(begin_value_pos),
+            kv_pairs);
+  }
+  return success;
+}
+
 bool
-SplitStringIntoKeyValuePairs(const std::string& line,
+SplitStringIntoKeyValuePairs(const StringPiece& line,
                              char key_value_delimiter,
                              char key_value_pair_delimiter,
                              std::vector<std::pair<std::string, std::string> >* kv_pairs)
 {
-  kv_pairs->clear();
+  return SplitStringIntoKeyValuePairsT(line, key_value_delimiter,
+                                       key_value_pair_delimiter, kv_pairs);
+}
 
-  std::vector<std::string> pairs;
-  SplitString(line, key_value_pair_delimiter, &pairs);
+bool
+SplitStringPieceIntoKeyValuePairs(
+    const StringPiece& line,
+    char key_value_delimiter,
+    char key_value_pair_delimiter,
+    std::vector<std::pair<StringPiece, StringPiece> >* kv_pairs)
+{
+  return SplitStringIntoKeyValuePairsT(line, key_value_delimiter,
+                                       key_value_pair_delimiter, kv_pairs);
+}
 
-  bool success = true;
-  for (size_t i = 0; i < pairs.size(); ++i)
-  {
-    // Empty pair. SplitStringIntoKeyValues is more strict about an empty pair
-    // line, so continue with the next pair.
-    if (pairs[i].empty())
-      continue;
+bool
+SplitStringPieceIntoKeyValuePairs(const StringPiece& line,
+                                  char key_value_delimiter,
+                                  char key_value_pair_delimiter,
+                                  KeyValueMap* kv_pairs)
+{
+  return SplitStringIntoKeyValuePairsT(line, key_value_delimiter,
+                                       key_value_pair_delimiter, kv_pairs);
+}
+
+// The parameters are found on the raw text, then their keys and values are
+// decoded where they lie: decoding only shrinks them, and never reaches
+// the next parameter.
+template <typename PAIRS>
+static void ParseQueryStringT(std::string* query, PAIRS* params)
+{
+  ClearPairs(params);
+  if (query->empty())
+    return;
 
-    std::string key;
-    std::vector<std::string> value;
-    if (!SplitStringIntoKeyValues(pairs[i],
-                                  key_value_delimiter,
-                                  &key, &value))
+  char* p = &(*query)[0];
+  char* const end = p + query->size();
+  while (p != end)
+  {
+    char* param_end = static_cast<char*>(memchr(p, '&', end - p));
+    if (param_end == NULL)
+      param_end = end;
+    if (param_end != p)
     {
-      // Don't return here, to allow for keys without associated
-      // values; just record that our split failed.
-      success = false;
+      char* key_end = static_cast<char*>(memchr(p, '=', param_end - p));
+      char* value = (key_end == NULL) ? param_end : key_end + 1;
+      if (key_end == NULL)
+        key_end = param_end;
+      const size_t key_length = UnescapePercentInPlace(p, key_end - p, true);
+      const size_t value_length =
+          UnescapePercentInPlace(value, param_end - value, true);
+      AddPair(StringPiece(p, key_length), StringPiece(value, value_length),
+              params);
     }
-    kv_pairs->push_back(make_pair(key, value.empty()? "" : value[0]));
+    p = (param_end == end) ? end : param_end + 1;
+  }
+}
+
+void
+ParseQueryString(std::string* query,
+                 std::vector<std::pair<StringPiece, StringPiece> >* params)
+{
+  ParseQueryStringT(query, params);
+}
+
+void
+ParseQueryString(std::string* query, KeyValueMap* params)
+{
+  ParseQueryStringT(query, params);
+}
+
+KeyValueMap::KeyValueMap()
+    : size_(0),
+      generation_(1)
+{
+}
+
+KeyValueMap::~KeyValueMap()
+{
+}
+
+KeyValueMap::Entry*
+KeyValueMap::Lookup(const StringPiece& key, uint64 hash) const
+{
+  const size_t mask = entries_.size() - 1;
+  for (size_t i = static_cast<size_t>(hash) & mask; ; i = (i + 1) & mask)
+  {
+    const Entry& entry = entries_[i];
+    if (entry.generation != generation_ ||
+        (entry.hash == hash && entry.key == key))
+      return const_cast<Entry*>(&entry);
+  }
+}
+
+bool
+KeyValueMap::Insert(const StringPiece& key, const StringPiece& value)
+{
+  if ((size_ + 1) * 2 > entries_.size())
+    Grow();
+  const uint64 hash = Hash64(key);
+  Entry* entry = Lookup(key, hash);
+  if (entry->generation == generation_)
+    return false;
+  entry->key = key;
+  entry->value = value;
+  entry->hash = hash;
+  entry->generation = generation_;
+  ++size_;
+  return true;
+}
+
+const StringPiece*
+KeyValueMap::Find(const StringPiece& key) const
+{
+  if (size_ == 0)
+    return NULL;
+  const Entry* entry = Lookup(key, Hash64(key));
+  return (entry->generation == generation_) ? &entry->value : NULL;
+}
+
+void
+KeyValueMap::Clear()
+{
+  size_ = 0;
+  if (++generation_ == 0)
+  {
+    // Generation 0 marks the entries never used.
+    for (size_t i = 0; i < entries_.size(); ++i)
+      entries_[i].generation = 0;
+    generation_ = 1;
   }
-  return success;
 }
 
+void
+KeyValueMap::Grow()
+{
+  std::vector<Entry> old;
+  old.swap(entries_);
+  entries_.resize(old.empty() ? 16 : old.size() * 2, Entry());
+  for (size_t i = 0; i < old.size(); ++i)
+  {
+    if (old[i].generation == generation_)
+      *Lookup(old[i].key, old[i].hash) = old[i];
+  }
+}
+
+// The delimiters are found a batch at a time by StringSearcher::FindAll(),
+// and each field is trimmed as a slice of |str| before it is made into a
+// STR.  An empty delimiter leaves |str| whole.
 template <typename STR>
-static void SplitStringUsingSubstrT(const STR& str,
-                                    const STR& s,
+static void SplitStringUsingSubstrT(const StringPiece& str,
+                                    const StringSearcher& s,
                                     std::vector<STR>* r)
 {
   r->clear();
-  typename STR::size_type begin_index = 0;
-  while (true)
+  const size_t delimiter_length = s.search().size();
+  size_t offsets[kDelimiterBatch];
+  size_t last = 0;
+  while (delimiter_length != 0)
   {
-    const typename STR::size_type end_index = str.find(s, begin_index);
-    if (end_index == STR::npos)
+    const size_t count = s.FindAll(str, last, offsets, kDelimiterBatch);
+    for (size_t i = 0; i < count; ++i)
     {
-      const STR term = str.substr(begin_index);
-      STR tmp;
-      TrimWhitespace(term, TRIM_ALL, &tmp);
-      r->push_back(tmp);
-      return;
+      AddField(str.data() + last, str.data() + offsets[i], true, r);
+      last = offsets[i] + delimiter_length;
     }
-    const STR term = str.substr(begin_index, end_index - begin_index);
-    STR tmp;
-    TrimWhitespace(term, TRIM_ALL, &tmp);
-    r->push_back(tmp);
-    begin_index = end_index + s.size();
+    if (count != kDelimiterBatch)
+      break;
   }
+  AddField(str.data() + last, str.end(), true, r);
+}
+
+void
+SplitStringUsingSubstr(const StringPiece& str,
+                       const StringPiece& s,
+                       std::vector<std::string>* r)
+{
+  SplitStringUsingSubstrT(str, StringSearcher(s, true), r);
 }
 
 void
-SplitStringUsingSubstr(const std::string& str,
-                       const std::string& s,
+SplitStringUsingSubstr(const StringPiece& str,
+                       const StringSearcher& s,
                        std::vector<std::string>* r)
 {
   SplitStringUsingSubstrT(str, s, r);
 }
 
 void
-SplitStringDontTrim(const std::string& str,
+SplitStringDontTrim(const StringPiece& str,
                     char c,
                     std::vector<std::string>* r)
 {
   SplitStringT(str, c, false, r);
 }
 
+// Calls |add(begin, end)| for each record of [begin, end) of |str|, where a
+// record ends at a delimiter, or at |end| if the last one has none.
+template <typename ADD>
+static void ForEachRecord(const StringPiece& str, size_t begin, size_t end,
+                          char delimiter, ADD add)
+{
+  const StringPiece slice(str.data(), end);
+  size_t offsets[kDelimiterBatch];
+  for (;;)
+  {
+    const size_t count =
+        FindByteOffsets(slice, begin, delimiter, offsets, kDelimiterBatch);
+    for (size_t i = 0; i < count; ++i)
+    {
+      add(begin, offsets[i]);
+      begin = offsets[i] + 1;
+    }
+    if (count != kDelimiterBatch)
+      break;
+  }
+  if (begin != end)
+    add(begin, end);
+}
+
+// Cuts |str| into the slices of SplitStringParallel(), slice i being
+// [(*cuts)[i], (*cuts)[i + 1]), and returns their number.
+static size_t CutIntoSlices(const StringPiece& str, char delimiter,
+                            size_t num_threads, std::vector<size_t>* cuts)
+{
+  // Below this many bytes per thread, starting threads costs more than it
+  // saves.
+  static const size_t kMinBytesPerThread = 1 << 20;
+
+  if (num_threads == 0)
+    num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  num_threads = std::max<size_t>(
+      std::min(num_threads, str.size() / kMinBytesPerThread), 1);
+
+  cuts->assign(1, 0);
+  for (size_t t = 1; t < num_threads; ++t)
+  {
+    // Searching from the previous cut keeps the whole search linear, even
+    // over a record longer than a slice.
+    const size_t pos = std::max(str.size() / num_threads * t, cuts->back());
+    const void* found = memchr(str.data() + pos, delimiter, str.size() - pos);
+    cuts->push_back(found ?
+                    static_cast<const char*>(found) - str.data() + 1 :
+                    str.size());
+  }
+  cuts->push_back(str.size());
+  return num_threads;
+}
+
+// Runs |split_slice(i)| for each of the |num_slices| slices, on a thread of
+// its own when there are several.
+template <typename SPLIT_SLICE>
+static void SplitSlices(size_t num_slices, SPLIT_SLICE split_slice)
+{
+  if (num_slices == 1)
+  {
+    split_slice(0);
+    return;
+  }
+  // Reserved, so that adding a started thread cannot throw.
+  std::vector<std::thread> threads;
+  threads.reserve(num_slices);
+  const ThreadJoiner joiner(&threads);
+  for (size_t t = 0; t < num_slices; ++t)
+    threads.push_back(std::thread(split_slice, t));
+}
+
+void
+SplitStringParallel(const StringPiece& str,
+                    char delimiter,
+                    std::vector<std::vector<size_t> >* record_ends,
+                    size_t num_threads)
+{
+  std::vector<size_t> cuts;
+  const size_t num_slices = CutIntoSlices(str, delimiter, num_threads, &cuts);
+  // The vectors are kept, with their capacity, when called again.
+  record_ends->resize(num_slices);
+  SplitSlices(num_slices, [&](size_t t) {
+      std::vector<size_t>* ends = &(*record_ends)[t];
+      ends->clear();
+      ForEachRecord(str, cuts[t], cuts[t + 1], delimiter,
+                    [ends](size_t, size_t end) { ends->push_back(end); });
+    });
+}
+
+void
+SplitStringParallel(
+    const StringPiece& str,
+    char delimiter,
+    const std::function<void(const StringPiece& record, size_t slice)>&
+        callback,
+    size_t num_threads)
+{
+  std::vector<size_t> cuts;
+  const size_t num_slices = CutIntoSlices(str, delimiter, num_threads, &cuts);
+  SplitSlices(num_slices, [&](size_t t) {
+      ForEachRecord(str, cuts[t], cuts[t + 1], delimiter,
+                    [&](size_t begin, size_t end) {
+                      callback(StringPiece(str.data() + begin, end - begin),
+                               t);
+                    });
+    });
+}
+
 template<typename STR>
-void SplitStringAlongWhitespaceT(const STR& str, std::vector<STR>* result)
+void SplitStringAlongWhitespaceT(const StringPiece& str,
+                                 std::vector<STR>* result)
 {
   result->clear();
   const size_t length = str.length();
@@ -185,8 +598,8 @@ void SplitStringAlongWhitespaceT(const STR& str, std::vector<STR>* result)
         if (!last_was_ws)
         {
           if (i > 0) {
-            result->push_back(
-                str.substr(last_non_ws_start, i - last_non_ws_start));
+            result->push_back(STR(str.data() + last_non_ws_start,
+                                  i - last_non_ws_start));
           }
           last_was_ws = true;
         }
@@ -203,16 +616,176 @@ void SplitStringAlongWhitespaceT(const STR& str, std::vector<STR>* result)
   }
   if (!last_was_ws)
   {
-    result->push_back(
-        str.substr(last_non_ws_start, length - last_non_ws_start));
+    result->push_back(STR(str.data() + last_non_ws_start,
+                          length - last_non_ws_start));
   }
 }
 
 void
-SplitStringAlongWhitespace(const std::string& str,
+SplitStringAlongWhitespace(const StringPiece& str,
                            std::vector<std::string>* result)
 {
   SplitStringAlongWhitespaceT(str, result);
 }
+
+void
+SplitStringPiece(const StringPiece& str,
+                 char c,
+                 std::vector<StringPiece>* r)
+{
+  SplitStringT(str, c, true, r);
+}
+
+void
+SplitStringPieceDontTrim(const StringPiece& str,
+                         char c,
+                         std::vector<StringPiece>* r)
+{
+  SplitStringT(str, c, false, r);
+}
+
+void
+SplitStringPieceUsingSubstr(const StringPiece& str,
+                            const StringPiece& s,
+                            std::vector<StringPiece>* r)
+{
+  SplitStringUsingSubstrT(str, StringSearcher(s, true), r);
+}
+
+void
+SplitStringPieceUsingSubstr(const StringPiece& str,
+                            const StringSearcher& s,
+                            std::vector<StringPiece>* r)
+{
+  SplitStringUsingSubstrT(str, s, r);
+}
+
+void
+SplitStringPieceAlongWhitespace(const StringPiece& str,
+                                std::vector<StringPiece>* result)
+{
+  SplitStringAlongWhitespaceT(str, result);
+}
+
+// HTML 5 whitespace, as in SplitStringAlongWhitespace().
+static constexpr CharSet kWhitespaceHTML(" \t\n\v\f\r");
+
+StringSplitter::StringSplitter(const StringPiece& str, char delimiter,
+                               int options)
+    : str_(str),
+      kind_(CHAR),
+      delimiter_(delimiter),
+      options_(options)
+{
+}
+
+StringSplitter::StringSplitter(const StringPiece& str,
+                               const StringPiece& delimiter,
+                               int options)
+    : str_(str),
+      kind_(SUBSTRING),
+      delimiter_('\0'),
+      substring_(delimiter),
+      options_(options)
+{
+}
+
+StringSplitter::StringSplitter(const StringPiece& str,
+                               const CharSet& delimiters,
+                               int options)
+    : str_(str),
+      kind_(CHAR_SET),
+      delimiter_('\0'),
+      delimiters_(delimiters),
+      options_(options)
+{
+}
+
+StringSplitter
+StringSplitter::Whitespace(const StringPiece& str)
+{
+  return StringSplitter(str, kWhitespaceHTML, SKIP_EMPTY);
+}
+
+StringSplitter::Iterator
+StringSplitter::begin() const
+{
+  if (str_.empty())
+    return end();
+
+  Iterator iter;
+  iter.splitter_ = this;
+  iter.next_ = str_.data();
+  iter.last_ = false;
+  Next(&iter);
+  // As with SplitString(), a single empty field is no field at all.
+  if (iter.last_ && iter.field_.empty())
+    return end();
+  return iter;
+}
+
+StringSplitter::Iterator
+StringSplitter::end() const
+{
+  Iterator iter;
+  iter.splitter_ = this;
+  iter.next_ = NULL;
+  iter.last_ = false;
+  return iter;
+}
+
+void
+StringSplitter::Next(Iterator* iter) const
+{
+  const char* p = iter->next_;
+  const char* const end = str_.end();
+  while (!iter->last_)
+  {
+    const char* field_end = end;
+    size_t delimiter_length = 1;
+    switch (kind_)
+    {
+      case CHAR:
+        field_end = static_cast<const char*>(
+            memchr(p, delimiter_, end - p));
+        if (field_end == NULL)
+          field_end = end;
+        break;
+      case SUBSTRING:
+        if (!substring_.empty())
+        {
+          const size_t pos = Find(StringPiece(p, end - p), substring_, 0,
+                                  true);
+          if (pos != StringPiece::npos)
+            field_end = p + pos;
+        }
+        delimiter_length = substring_.size();
+        break;
+      case CHAR_SET:
+        field_end = delimiters_.Scan(p, end, true);
+        break;
+    }
+
+    StringPiece field(p, field_end - p);
+    if (options_ & TRIM_WHITESPACE)
+      field = TrimWhitespaceASCII(field, TRIM_ALL);
+    const bool last = (field_end == end);
+    p = last ? end : field_end + delimiter_length;
+    if (!field.empty() || !(options_ & SKIP_EMPTY))
+    {
+      iter->field_ = field;
+      iter->next_ = p;
+      iter->last_ = last;
+      return;
+    }
+    if (last)
+      break;
+  }
+
+  // Past the last field.
+  iter->field_ = StringPiece();
+  iter->next_ = NULL;
+  iter->last_ = false;
+}
  
 }; // namespace util
@@ -15,7 +15,11 @@
 ******************************************************************************/
 #include "util/string_split.h"
 
+#include <stdlib.h>
+
 #include "util/basictypes.h"
+#include "util/cpu.h"
+#include "util/string_util.h"
 
 #include "third_party/gmock/include/gmock/gmock.h"
 #include "third_party/gtest/include/gtest/gtest.h"
@@ -160,6 +164,132 @@ TEST_F(SplitStringIntoKeyValuePairsTest, DelimiterInValue)
   EXPECT_EQ("value2", kv_pairs[1].second);
 }
 
+// The zero-copy forms must give the pairs SplitStringIntoKeyValuePairs
+// gives.
+TEST_F(SplitStringIntoKeyValuePairsTest, StringPieces)
+{
+  static const char* const kLines[] = {
+    "", " ; ", "k1=v1;k2=v2", " k1 = v1 ;; k2==v2 ", "k1;k2=", "=v;k=",
+    "a=1;b=2;a=3",
+  };
+
+  std::vector<std::pair<StringPiece, StringPiece> > pieces;
+  KeyValueMap map;
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(kLines); ++i)
+  {
+    std::vector<std::pair<std::string, std::string> > expect;
+    const bool success =
+        SplitStringIntoKeyValuePairs(kLines[i], '=', ';', &expect);
+    EXPECT_EQ(success, SplitStringPieceIntoKeyValuePairs(kLines[i], '=', ';',
+                                                        &pieces))
+        << "lines:" << i + 1;
+    ASSERT_EQ(expect.size(), pieces.size()) << "lines:" << i + 1;
+    for (size_t j = 0; j < expect.size(); ++j)
+    {
+      EXPECT_EQ(expect[j].first, pieces[j].first) << "lines:" << i + 1;
+      EXPECT_EQ(expect[j].second, pieces[j].second) << "lines:" << i + 1;
+    }
+
+    EXPECT_EQ(success,
+              SplitStringPieceIntoKeyValuePairs(kLines[i], '=', ';', &map))
+        << "lines:" << i + 1;
+    for (size_t j = 0; j < expect.size(); ++j)
+    {
+      // The first value of a key wins.
+      const StringPiece* value = map.Find(expect[j].first);
+      ASSERT_TRUE(value != NULL) << "lines:" << i + 1;
+      for (size_t k = 0; k < j; ++k)
+      {
+        if (expect[k].first == expect[j].first)
+        {
+          EXPECT_EQ(expect[k].second, *value) << "lines:" << i + 1;
+          break;
+        }
+      }
+    }
+  }
+
+  SplitStringPieceIntoKeyValuePairs("a=1;b=2;a=3", '=', ';', &map);
+  EXPECT_EQ(2U, map.size());
+  EXPECT_EQ("1", *map.Find("a"));
+  EXPECT_TRUE(map.Find("c") == NULL);
+}
+
+TEST(KeyValueMapTest, InsertFindClear)
+{
+  std::vector<std::string> keys;
+  for (int i = 0; i < 1000; ++i)
+    keys.push_back("key" + std::to_string(i));
+
+  KeyValueMap map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.Find("key0") == NULL);
+  for (int round = 0; round < 3; ++round)
+  {
+    // Clear() empties the map whatever it held.
+    map.Clear();
+    const size_t count = (round == 1) ? 1000 : 10;
+    for (size_t i = 0; i < count; ++i)
+      EXPECT_TRUE(map.Insert(keys[i], keys[count - 1 - i]));
+    EXPECT_FALSE(map.Insert(keys[0], "again"));
+    EXPECT_EQ(count, map.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+      const StringPiece* value = map.Find(keys[i]);
+      if (i < count)
+      {
+        ASSERT_TRUE(value != NULL) << "round:" << round;
+        EXPECT_EQ(keys[count - 1 - i], *value) << "round:" << round;
+      }
+      else
+      {
+        EXPECT_TRUE(value == NULL) << "round:" << round;
+      }
+    }
+  }
+}
+
+TEST(ParseQueryStringTest, Decode)
+{
+  static const struct
+  {
+    const char* query;
+    const char* params;
+  } cases[] = {
+    { "", "" },
+    { "&&", "" },
+    { "a=1", "[a:1]" },
+    { "a=1&b=&c&=d", "[a:1][b:][c:][:d]" },
+    { "q=x+y%21&n%61me=a%3Db%26c", "[q:x y!][name:a=b&c]" },
+    { "a=b=c&%zz=100%", "[a:b=c][%zz:100%]" },
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    std::string query(cases[i].query);
+    std::vector<std::pair<StringPiece, StringPiece> > params;
+    ParseQueryString(&query, &params);
+    std::string printed;
+    for (size_t j = 0; j < params.size(); ++j)
+    {
+      printed += "[" + params[j].first.as_string() + ":" +
+          params[j].second.as_string() + "]";
+      // In place: the views point into |query|.
+      EXPECT_TRUE(params[j].first.data() >= query.data() &&
+                  params[j].second.end() <= query.data() + query.size())
+          << "cases:" << i + 1;
+    }
+    EXPECT_EQ(cases[i].params, printed) << "cases:" << i + 1;
+  }
+
+  std::string query("id=7&tag=a%20b&id=8");
+  KeyValueMap params;
+  ParseQueryString(&query, &params);
+  EXPECT_EQ(2U, params.size());
+  EXPECT_EQ("7", *params.Find("id"));
+  EXPECT_EQ("a b", *params.Find("tag"));
+}
+
 TEST(SplitStringUsingSubstrTest, EmptyString)
 {
   std::vector<std::string> results;
@@ -210,6 +340,60 @@ TEST(SplitStringUsingSubstrTest, TrailingDelimitersSkipped)
       results, ElementsAre("un", "deux", "trois", "quatre", "", "", ""));
 }
 
+TEST(SplitStringUsingSubstrTest, EmptyDelimiter)
+{
+  std::vector<std::string> results;
+  SplitStringUsingSubstr(" uno dos ", "", &results);
+  EXPECT_THAT(results, ElementsAre("uno dos"));
+}
+
+TEST(SplitStringUsingSubstrTest, StringSearcher)
+{
+  const StringSearcher crlf("\r\n", true);
+  std::vector<std::string> results;
+  std::vector<StringPiece> pieces;
+
+  // The same searcher splits one line after the other.
+  SplitStringUsingSubstr("a: 1\r\nb: 2 \r\n\r\n", crlf, &results);
+  EXPECT_THAT(results, ElementsAre("a: 1", "b: 2", "", ""));
+  SplitStringPieceUsingSubstr("\r\nc\n\r\nd\r", crlf, &pieces);
+  EXPECT_THAT(pieces, ElementsAre("", "c", "d"));
+
+  // Long lines, where the delimiters are found a block at a time.
+  static const char kChars[] = "a |";
+  static const char* const kDelimiters[] = { "|", "||", "|a|", "a| |a" };
+  srand(2014);
+  ForEachCPUFeatureMask([&](int mask) {
+    for (int round = 0; round < 400; ++round)
+    {
+      const std::string delimiter =
+          kDelimiters[round % ARRAYSIZE_UNSAFE(kDelimiters)];
+      const std::string line = RandomString(kChars, 999);
+
+      std::vector<std::string> expect;
+      size_t begin = 0;
+      for (;;)
+      {
+        const size_t end = line.find(delimiter, begin);
+        std::string field;
+        TrimWhitespaceASCII(line.substr(begin, end - begin), TRIM_ALL,
+                            &field);
+        expect.push_back(field);
+        if (end == std::string::npos)
+          break;
+        begin = end + delimiter.size();
+      }
+      SplitStringUsingSubstr(line, StringSearcher(delimiter, true),
+                             &results);
+      EXPECT_EQ(expect, results) << "mask:" << mask << " round:" << round;
+    }
+  });
+
+  SplitStringUsingSubstr("oneANDtwoandthree AnD four",
+                         StringSearcher("and", false), &results);
+  EXPECT_THAT(results, ElementsAre("one", "two", "three", "four"));
+}
+
 TEST(StringSplitTest, StringSplitDontTrim)
 {
   std::vector<std::string> r;
@@ -231,6 +415,274 @@ TEST(StringSplitTest, StringSplitDontTrim)
   EXPECT_EQ(r[1], "b\tcc");
 }
 
+TEST(StringSplitTest, SplitStringSlice)
+{
+  // Only the first line of |buffer| is split.
+  const char buffer[] = " a, b ,c\nd,e";
+  std::vector<std::string> r;
+
+  SplitString(StringPiece(buffer, 8), ',', &r);
+  EXPECT_THAT(r, ElementsAre("a", "b", "c"));
+
+  SplitStringDontTrim(StringPiece(buffer, 8), ',', &r);
+  EXPECT_THAT(r, ElementsAre(" a", " b ", "c"));
+
+  SplitStringAlongWhitespace(StringPiece(buffer, 5), &r);
+  EXPECT_THAT(r, ElementsAre("a,", "b"));
+}
+
+
+// Long lines go through the vectorized delimiter search in batches; the
+// fields must be the same as a byte by byte split gives.
+TEST(StringSplitTest, SplitStringLongLines)
+{
+  static const char kChars[] = " \t,ab";
+
+  srand(2014);
+  ForEachCPUFeatureMask([&](int mask) {
+    for (int round = 0; round < 200; ++round)
+    {
+      const std::string str = RandomString(kChars, 999);
+
+      std::vector<std::string> expect;
+      size_t last = 0;
+      for (size_t i = 0; i <= str.length(); ++i)
+      {
+        if (i == str.length() || str[i] == ',')
+        {
+          expect.push_back(str.substr(last, i - last));
+          last = i + 1;
+        }
+      }
+
+      std::vector<std::string> r;
+      SplitStringDontTrim(str, ',', &r);
+      if (str.empty())
+      {
+        EXPECT_TRUE(r.empty()) << "mask:" << mask;
+      }
+      else
+      {
+        EXPECT_EQ(expect, r) << "mask:" << mask << " round:" << round;
+      }
+
+      for (size_t i = 0; i < expect.size(); ++i)
+        TrimWhitespaceASCII(expect[i], TRIM_ALL, &expect[i]);
+      if (expect.size() == 1 && expect[0].empty())
+        expect.clear();
+      SplitString(str, ',', &r);
+      EXPECT_EQ(expect, r) << "mask:" << mask << " round:" << round;
+    }
+  });
+}
+
+// The StringPiece splitters must give the same fields as the copying ones,
+// pointing into the input.
+TEST(StringSplitTest, SplitStringPieceMatchesSplitString)
+{
+  static const char* const kInputs[] = {
+    "", " ", ",", "a", " a ,b, c ,,", ",,a,,", "\ta\tb \t",
+    "unoDELIMITERDELIMITER dos DELIMITER", "DELIMITER",
+  };
+
+  std::vector<std::string> strings;
+  std::vector<StringPiece> pieces;
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(kInputs); ++i)
+  {
+    const std::string input = kInputs[i];
+    const char* const begin = input.data();
+    const char* const end = begin + input.size();
+
+    for (int splitter = 0; splitter < 4; ++splitter)
+    {
+      switch (splitter)
+      {
+        case 0:
+          SplitString(input, ',', &strings);
+          SplitStringPiece(input, ',', &pieces);
+          break;
+        case 1:
+          SplitStringDontTrim(input, ',', &strings);
+          SplitStringPieceDontTrim(input, ',', &pieces);
+          break;
+        case 2:
+          SplitStringUsingSubstr(input, "DELIMITER", &strings);
+          SplitStringPieceUsingSubstr(input, "DELIMITER", &pieces);
+          break;
+        case 3:
+          SplitStringAlongWhitespace(input, &strings);
+          SplitStringPieceAlongWhitespace(input, &pieces);
+          break;
+      }
+      ASSERT_EQ(strings.size(), pieces.size())
+          << "input:" << i + 1 << " splitter:" << splitter;
+      for (size_t j = 0; j < pieces.size(); ++j)
+      {
+        EXPECT_EQ(strings[j], pieces[j].as_string())
+            << "input:" << i + 1 << " splitter:" << splitter;
+        if (!pieces[j].empty())
+        {
+          EXPECT_TRUE(pieces[j].begin() >= begin && pieces[j].end() <= end);
+        }
+      }
+    }
+  }
+}
+
+TEST(StringSplitTest, SplitStringPieceReusesVector)
+{
+  std::vector<StringPiece> r;
+  SplitStringPiece("a, b, c, d", ',', &r);
+  EXPECT_THAT(r, ElementsAre("a", "b", "c", "d"));
+
+  // A shorter line fits in the same storage.
+  const StringPiece* data = r.data();
+  SplitStringPiece(" e ,f", ',', &r);
+  EXPECT_THAT(r, ElementsAre("e", "f"));
+  EXPECT_EQ(data, r.data());
+}
+
+
+static std::vector<StringPiece> Fields(const StringSplitter& splitter)
+{
+  std::vector<StringPiece> fields;
+  for (const StringPiece& field : splitter)
+    fields.push_back(field);
+  return fields;
+}
+
+// StringSplitter gives the fields of the eager splitters, one at a time.
+TEST(StringSplitTest, StringSplitterMatchesSplitString)
+{
+  static const char* const kInputs[] = {
+    "", " ", ",", ",,", "a", " a ,b, c ,,", ",,a,,", "\ta\tb \t",
+    "a;b, c;;", "unoDELIMITERDELIMITER dos DELIMITER", "DELIMITER",
+    "DELIMITERx", "xDELIMITE",
+  };
+
+  std::vector<StringPiece> expect;
+  std::vector<std::string> tokens;
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(kInputs); ++i)
+  {
+    const StringPiece input = kInputs[i];
+
+    SplitStringPiece(input, ',', &expect);
+    EXPECT_EQ(expect, Fields(StringSplitter(input, ','))) << "input:" << i;
+
+    SplitStringPieceDontTrim(input, ',', &expect);
+    EXPECT_EQ(expect, Fields(StringSplitter(input, ',', 0)))
+        << "input:" << i;
+
+    // SplitStringUsingSubstr() alone keeps a single empty field.
+    SplitStringPieceUsingSubstr(input, "DELIMITER", &expect);
+    if (expect.size() == 1 && expect[0].empty())
+      expect.clear();
+    EXPECT_EQ(expect, Fields(StringSplitter(input, StringPiece("DELIMITER"))))
+        << "input:" << i;
+
+    SplitStringPieceAlongWhitespace(input, &expect);
+    EXPECT_EQ(expect, Fields(StringSplitter::Whitespace(input)))
+        << "input:" << i;
+
+    Tokenize(input, ",;", &tokens);
+    const std::vector<StringPiece> fields =
+        Fields(StringSplitter(input, CharSet(",;"),
+                              StringSplitter::SKIP_EMPTY));
+    EXPECT_EQ(std::vector<StringPiece>(tokens.begin(), tokens.end()), fields)
+        << "input:" << i;
+  }
+}
+
+TEST(StringSplitTest, StringSplitterStopsEarly)
+{
+  const StringSplitter splitter("id, name, , value", ',');
+  StringSplitter::Iterator iter = splitter.begin();
+  ASSERT_TRUE(iter != splitter.end());
+  EXPECT_EQ("id", *iter);
+  EXPECT_EQ(4U, (++iter)->size());
+  EXPECT_EQ("name", *iter++);
+  EXPECT_EQ("", *iter);
+
+  size_t seen = 0;
+  for (const StringPiece& field : splitter)
+  {
+    ++seen;
+    if (field == "name")
+      break;
+  }
+  EXPECT_EQ(2U, seen);
+  EXPECT_EQ(4, std::distance(splitter.begin(), splitter.end()));
+
+  // An empty delimiter never matches.
+  EXPECT_THAT(Fields(StringSplitter(" a,b ", StringPiece(""))),
+              ElementsAre("a,b"));
+}
+
+
+// The records of |str| as SplitStringParallel() sees them, one thread.
+static std::vector<StringPiece> SplitRecords(const StringPiece& str, char c)
+{
+  std::vector<StringPiece> records;
+  SplitStringPieceDontTrim(str, c, &records);
+  if (!records.empty() && records.back().empty())
+    records.pop_back();
+  return records;
+}
+
+TEST(StringSplitTest, SplitStringParallel)
+{
+  // Short lines, a line longer than a slice, and no line break at all.
+  std::string lines;
+  srand(2014);
+  while (lines.size() < (4 << 20))
+  {
+    lines += RandomString("abcdefghijklmnopqrstuvwxyz", 99, 99);
+    lines += '\n';
+  }
+  std::string long_line(3 << 20, 'x');
+  long_line += "\nlast";
+  const std::string inputs[] = {
+    "", "\n", "a", "a\n\nb\n", lines, lines + "tail", long_line,
+    long_line.substr(0, 3 << 20),
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(inputs); ++i)
+  {
+    const StringPiece str(inputs[i]);
+    const std::vector<StringPiece> expect = SplitRecords(str, '\n');
+    for (size_t threads = 0; threads <= 4; ++threads)
+    {
+      std::vector<std::vector<size_t> > record_ends;
+      SplitStringParallel(str, '\n', &record_ends, threads);
+      std::vector<StringPiece> records;
+      size_t begin = 0;
+      for (size_t s = 0; s < record_ends.size(); ++s)
+      {
+        for (size_t r = 0; r < record_ends[s].size(); ++r)
+        {
+          records.push_back(str.substr(begin, record_ends[s][r] - begin));
+          begin = record_ends[s][r] + 1;
+        }
+      }
+      EXPECT_TRUE(expect == records)
+          << "inputs:" << i + 1 << " threads:" << threads;
+
+      // The callbacks of a slice run in order on one thread, so each slice
+      // can collect its records on its own.
+      std::vector<std::vector<StringPiece> > slices(record_ends.size());
+      SplitStringParallel(str, '\n',
+                          [&](const StringPiece& record, size_t slice) {
+                            slices[slice].push_back(record);
+                          },
+                          threads);
+      records.clear();
+      for (size_t s = 0; s < slices.size(); ++s)
+        records.insert(records.end(), slices[s].begin(), slices[s].end());
+      EXPECT_TRUE(expect == records)
+          << "inputs:" << i + 1 << " threads:" << threads;
+    }
+  }
+}
 
 TEST(StringSplitTest, SplitStringAlongWhitespace)
 {
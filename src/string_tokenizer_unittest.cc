@@ -16,6 +16,15 @@
 
 #include "util/string_tokenizer.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "util/basictypes.h"
+#include "util/cpu.h"
+#include "util/string_util.h"
+
 #include "third_party/gtest/include/gtest/gtest.h"
 
 using std::string;
@@ -277,4 +286,40 @@ TEST(StringTokenizerTest, ParseQuotedString_EscapedQuotes2)
   EXPECT_FALSE(t.GetNext());
 }
 
+TEST(StringTokenizerTest, LongInput)
+{
+  static const char kChars[] = ", ;abc";
+
+  srand(2014);
+  ForEachCPUFeatureMask([&](int mask) {
+    for (int round = 0; round < 200; ++round)
+    {
+      const string input = RandomString(kChars, 299);
+
+      std::vector<string> expect;
+      size_t begin = 0;
+      for (size_t i = 0; i <= input.length(); ++i)
+      {
+        if (i == input.length() || strchr(", ;", input[i]))
+        {
+          if (i != begin)
+            expect.push_back(input.substr(begin, i - begin));
+          begin = i + 1;
+        }
+      }
+
+      std::vector<string> tokens;
+      StringTokenizer t(input, ", ;");
+      while (t.GetNext())
+        tokens.push_back(t.token());
+      EXPECT_EQ(expect, tokens) << "mask:" << mask << " round:" << round;
+
+      std::vector<string> words;
+      EXPECT_EQ(expect.size(), Tokenize(input, CharSet(", ;"), &words))
+          << "mask:" << mask;
+      EXPECT_EQ(expect, words) << "mask:" << mask << " round:" << round;
+    }
+  });
+}
+
 }; // namespace util
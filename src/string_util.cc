@@ -18,11 +18,23 @@
 
 #include <algorithm>
 #include <cstring>
+#include <thread>
+#include <utility>
 
+#include "src/thread_joiner.h"
+#include "util/basictypes.h"
+#include "util/cpu.h"
 #include "util/icu_utf.h"
+#include "util/ip_address.h"
 #include "util/string_number_conversions.h"
 #include "util/string_split.h"
 
+#if defined(HAVE_TARGET_ATTRIBUTE)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace util
 {
 
@@ -74,35 +86,61 @@ const char kWhitespaceASCII[] = {
 // --------------------- Update Begin -------------------------
 // ------------------------------------------------------------
 
-template<typename STR>
-bool ReplaceCharsT(const STR& input,
-                   const typename STR::value_type replace_chars[],
-                   const STR& replace_with,
-                   STR* output)
+bool
+ReplaceChars(const std::string& input,
+             const char replace_chars[],
+             const std::string& replace_with,
+             std::string* output)
 {
-  bool removed = false;
-  size_t replace_length = replace_with.length();
+  if (output == &input)
+    return ReplaceChars(output, replace_chars, replace_with);
+  if (replace_with.empty())
+    return RemoveChars(input, replace_chars, output);
 
-  *output = input;
+  const CharSet set((StringPiece(replace_chars)));
+  const char* begin = input.data();
+  const char* end = begin + input.length();
 
-  size_t found = output->find_first_of(replace_chars);
-  while (found != STR::npos)
+  const char* first = set.Scan(begin, end, true);
+  if (first == end)
   {
-    removed = true;
-    output->replace(found, 1, replace_with);
-    found = output->find_first_of(replace_chars, found + replace_length);
+    *output = input;
+    return false;
   }
 
-  return removed;
-}
+  if (replace_with.length() == 1)
+  {
+    // Same length in and out: rewrite a copy in place.
+    const size_t first_pos = first - begin;
+    *output = input;
+    char* out = &(*output)[0];
+    set.Replace(out + first_pos, out + output->length(), replace_with[0]);
+    return true;
+  }
 
-bool
-ReplaceChars(const std::string& input,
-             const char replace_chars[],
-             const std::string& replace_with,
-             std::string* output)
-{
-  return ReplaceCharsT(input, replace_chars, replace_with, output);
+  // Count the matches so that the result is allocated exactly once, then
+  // stream the untouched runs and the replacements into it.
+  size_t matches = 0;
+  for (const char* p = first; p != end; p = set.Scan(p + 1, end, true))
+    ++matches;
+
+  std::string result;
+  result.resize(input.length() - matches +
+                matches * replace_with.length());
+  char* out = &result[0];
+  const char* run = begin;
+  for (const char* p = first; p != end; p = set.Scan(p + 1, end, true))
+  {
+    memcpy(out, run, p - run);
+    out += p - run;
+    memcpy(out, replace_with.data(), replace_with.length());
+    out += replace_with.length();
+    run = p + 1;
+  }
+  memcpy(out, run, end - run);
+
+  output->swap(result);
+  return true;
 }
 
 bool
@@ -114,12 +152,109 @@ ReplaceChars(const std::string &input,
   return ReplaceChars(input, replace.c_str(), replace_with, output);
 }
 
+bool
+ReplaceChars(std::string* str,
+             const char replace_chars[],
+             const StringPiece& replace_with)
+{
+  if (replace_with.empty())
+    return RemoveChars(str, replace_chars);
+
+  const CharSet set((StringPiece(replace_chars)));
+  const size_t length = str->length();
+  const char* begin = str->data();
+  const char* end = begin + length;
+  const char* first = set.Scan(begin, end, true);
+  if (first == end)
+    return false;
+
+  const size_t first_pos = first - begin;
+  if (replace_with.length() == 1)
+  {
+    char* p = &(*str)[0];
+    set.Replace(p + first_pos, p + length, replace_with[0]);
+    return true;
+  }
+
+  size_t matches = 0;
+  for (const char* p = first; p != end; p = set.Scan(p + 1, end, true))
+    ++matches;
+
+  // Grow |str| and fill it from the back: the runs only move towards the
+  // end, and a run is always read before the replacements after it
+  // overwrite it.
+  const size_t new_length = length + matches * (replace_with.length() - 1);
+  str->resize(new_length);
+  char* data = &(*str)[0];
+  char* out = data + new_length;
+  const char* run_end = data + length;
+  for (const char* p = data + length; matches != 0; --matches)
+  {
+    p = set.ReverseScan(data + first_pos, p, true) - 1;
+    const size_t run = run_end - (p + 1);
+    out -= run;
+    memmove(out, p + 1, run);
+    out -= replace_with.length();
+    memcpy(out, replace_with.data(), replace_with.length());
+    run_end = p;
+  }
+  return true;
+}
+
+bool
+ReplaceChars(std::string&& input,
+             const char replace_chars[],
+             const std::string& replace_with,
+             std::string* output)
+{
+  if (output != &input)
+    *output = std::move(input);
+  return ReplaceChars(output, replace_chars, replace_with);
+}
+
+// Writes the bytes of [p, end) not found in |set| to |out| and returns the end
+// of what was written.  |out| may be |p|: the output never gets ahead of the
+// input.
+static char* RemoveBytesInto(const char* p, const char* end,
+                             const CharSet& set, char* out)
+{
+  while (p != end)
+  {
+    const char* run_end = set.Scan(p, end, true);
+    if (out != p)
+      memmove(out, p, run_end - p);
+    out += run_end - p;
+    p = set.Scan(run_end, end, false);
+  }
+  return out;
+}
+
 bool
 RemoveChars(const std::string& input,
             const char remove_chars[],
             std::string* output)
 {
-  return ReplaceChars(input, remove_chars, std::string(), output);
+  if (output == &input)
+    return RemoveChars(output, remove_chars);
+
+  const CharSet set((StringPiece(remove_chars)));
+  const char* begin = input.data();
+  const char* end = begin + input.length();
+
+  const char* first = set.Scan(begin, end, true);
+  if (first == end)
+  {
+    *output = input;
+    return false;
+  }
+
+  std::string result;
+  result.resize(input.length());
+  char* out = &result[0];
+  result.resize(RemoveBytesInto(begin, end, set, out) - out);
+
+  output->swap(result);
+  return true;
 }
 
 bool
@@ -127,408 +262,2412 @@ RemoveChars(const std::string& input,
             const std::string &remove,
             std::string* output)
 {
-  return ReplaceChars(input, remove, std::string(), output);
+  return RemoveChars(input, remove.c_str(), output);
+}
+
+bool
+RemoveChars(std::string&& input,
+            const char remove_chars[],
+            std::string* output)
+{
+  if (output != &input)
+    *output = std::move(input);
+  return RemoveChars(output, remove_chars);
+}
+
+bool
+RemoveChars(std::string* str, const char remove_chars[])
+{
+  const CharSet set((StringPiece(remove_chars)));
+  char* begin = &(*str)[0];
+  char* end = begin + str->length();
+
+  const char* first = set.Scan(begin, end, true);
+  if (first == end)
+    return false;
+
+  char* out = begin + (first - begin);
+  str->resize(RemoveBytesInto(first, end, set, out) - begin);
+  return true;
+}
+
+bool
+RemoveChars(std::string* str, const std::string &remove)
+{
+  return RemoveChars(str, remove.c_str());
+}
+
+// Finds the range of |input| left after trimming |trim_chars| from
+// |positions|.
+static void FindTrimmedRangeWithSet(const StringPiece& input,
+                                    const CharSet& trim_chars,
+                                    TrimPositions positions,
+                                    const char** first,
+                                    const char** last)
+{
+  *first = input.begin();
+  *last = input.end();
+  if (positions & TRIM_LEADING)
+    *first = trim_chars.Scan(*first, *last, false);
+  if (positions & TRIM_TRAILING)
+    *last = trim_chars.ReverseScan(*first, *last, false);
+}
+
+// Stores [first, last) of |input| in |output|, in place when |output| is
+// |input|.
+static void AssignTrimmed(const std::string& input, const char* first,
+                          const char* last, std::string* output)
+{
+  if (output == &input)
+  {
+    const size_t first_pos = first - input.data();
+    output->resize(last - input.data());
+    output->erase(0, first_pos);
+  }
+  else
+  {
+    output->assign(first, last - first);
+  }
+}
+
+static void AssignTrimmed(const StringPiece&, const char* first,
+                          const char* last, StringPiece* output)
+{
+  output->set(first, last - first);
 }
 
-template<typename STR>
-TrimPositions TrimStringT(const STR& input,
-                          const typename STR::value_type trim_chars[],
-                          TrimPositions positions,
-                          STR* output)
+// The core of the std::string and StringPiece forms of TrimString().
+template <typename STR>
+static TrimPositions TrimStringT(const STR& input,
+                                 const CharSet& trim_chars,
+                                 TrimPositions positions,
+                                 STR* output)
 {
   // Find the edges of leading/trailing whitespace as desired.
-  const typename STR::size_type last_char = input.length() - 1;
-  const typename STR::size_type first_good_char = (positions & TRIM_LEADING) ?
-      input.find_first_not_of(trim_chars) : 0;
-  const typename STR::size_type last_good_char = (positions & TRIM_TRAILING) ?
-      input.find_last_not_of(trim_chars) : last_char;
+  const char* first;
+  const char* last;
+  FindTrimmedRangeWithSet(input, trim_chars, positions, &first, &last);
 
   // When the string was all whitespace, report that we stripped off whitespace
   // from whichever position the caller was interested in.  For empty input, we
-  // stripped no whitespace, but we still need to clear |output|.
-  if (input.empty() ||
-      (first_good_char == STR::npos) || (last_good_char == STR::npos))
+  // stripped no whitespace, but we still need to clear |output|; a
+  // StringPiece is left pointing into |input|.
+  if (first == last)
   {
     bool input_was_empty = input.empty();  // in case output == &input
-    output->clear();
+    AssignTrimmed(input, first, last, output);
     return input_was_empty ? TRIM_NONE : positions;
   }
 
-  // Trim the whitespace.
-  *output =
-      input.substr(first_good_char, last_good_char - first_good_char + 1);
-
   // Return where we trimmed from.
-  return static_cast<TrimPositions>(
-      ((first_good_char == 0) ? TRIM_NONE : TRIM_LEADING) |
-      ((last_good_char == last_char) ? TRIM_NONE : TRIM_TRAILING));
+  const TrimPositions trimmed = static_cast<TrimPositions>(
+      ((first == input.data()) ? TRIM_NONE : TRIM_LEADING) |
+      ((last == input.data() + input.length()) ? TRIM_NONE : TRIM_TRAILING));
+
+  // Trim the whitespace.
+  if (trimmed != TRIM_NONE || output != &input)
+    AssignTrimmed(input, first, last, output);
+  return trimmed;
 }
 
 bool
 TrimString(const std::string& input,
            const char trim_chars[],
            std::string* output)
+{
+  return TrimStringT(input, CharSet(StringPiece(trim_chars)), TRIM_ALL,
+                     output) != TRIM_NONE;
+}
+
+bool
+TrimString(const std::string& input,
+           const CharSet& trim_chars,
+           std::string* output)
 {
   return TrimStringT(input, trim_chars, TRIM_ALL, output) != TRIM_NONE;
 }
 
-TrimPositions
-TrimWhitespaceASCII(const std::string& input,
-                    TrimPositions positions,
-                    std::string* output)
+bool
+TrimString(std::string&& input,
+           const CharSet& trim_chars,
+           std::string* output)
 {
-  return TrimStringT(input, kWhitespaceASCII, positions, output);
+  if (output != &input)
+    *output = std::move(input);
+  return TrimString(output, trim_chars);
 }
 
-// This function is only for backward-compatibility.
-// To be removed when all callers are updated.
-TrimPositions
-TrimWhitespace(const std::string& input,
-               TrimPositions positions,
-               std::string* output)
+bool
+TrimString(std::string* str, const char trim_chars[])
+{
+  return TrimString(str, CharSet(StringPiece(trim_chars)));
+}
+
+bool
+TrimString(std::string* str, const CharSet& trim_chars)
 {
-  return TrimWhitespaceASCII(input, positions, output);
+  return TrimStringT(*str, trim_chars, TRIM_ALL, str) != TRIM_NONE;
 }
 
+StringPiece
+TrimString(const StringPiece& input,
+           const CharSet& trim_chars,
+           TrimPositions positions)
+{
+  StringPiece output;
+  TrimStringT(input, trim_chars, positions, &output);
+  return output;
+}
 
-template<typename STR>
-STR CollapseWhitespaceT(const STR& text,
-                        bool trim_sequences_with_line_breaks)
+// Matches the chars of kWhitespaceASCII: 0x09 to 0x0D and the space.
+static inline bool IsWhitespaceASCIIByte(unsigned char c)
 {
-  STR result;
-  result.resize(text.size());
+  return c == ' ' || static_cast<unsigned char>(c - 0x09) <= 0x0D - 0x09;
+}
 
-  // Set flags to pretend we're already in a trimmed whitespace sequence, so we
-  // will trim any leading whitespace.
-  bool in_whitespace = true;
-  bool already_trimmed = true;
+#if defined(__SSE2__)
+// Returns a bit per byte of the 16 bytes at |p|, set for whitespace.
+static inline unsigned int WhitespaceMaskSSE2(const char* p)
+{
+  const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  const __m128i shifted = _mm_sub_epi8(chunk, _mm_set1_epi8(0x09));
+  const __m128i is_control = _mm_cmpeq_epi8(
+      _mm_min_epu8(shifted, _mm_set1_epi8(0x0D - 0x09)), shifted);
+  const __m128i is_space = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+  return _mm_movemask_epi8(_mm_or_si128(is_control, is_space));
+}
+#endif
+
+#if defined(HAVE_TARGET_ATTRIBUTE)
+TARGET_AVX2
+static inline unsigned int WhitespaceMaskAVX2(const char* p)
+{
+  const __m256i chunk =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  const __m256i shifted = _mm256_sub_epi8(chunk, _mm256_set1_epi8(0x09));
+  const __m256i is_control = _mm256_cmpeq_epi8(
+      _mm256_min_epu8(shifted, _mm256_set1_epi8(0x0D - 0x09)), shifted);
+  const __m256i is_space = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' '));
+  return _mm256_movemask_epi8(_mm256_or_si256(is_control, is_space));
+}
 
-  int chars_written = 0;
-  for (typename STR::const_iterator i(text.begin()); i != text.end(); ++i)
+// Skips the 32 byte blocks at the front (back) of [p, end) in which every
+// byte's whitespace-ness differs from |whitespace|.
+TARGET_AVX2
+static const char* ScanWhitespaceASCIIAVX2(const char* p, const char* end,
+                                           bool whitespace)
+{
+  const unsigned int flip = whitespace ? 0 : 0xFFFFFFFFu;
+  for (; end - p >= 32; p += 32)
   {
-    if (IsWhitespace(*i))
-    {
-      if (!in_whitespace)
-      {
-        // Reduce all whitespace sequences to a single space.
-        in_whitespace = true;
-        result[chars_written++] = L' ';
-      }
-      if (trim_sequences_with_line_breaks && !already_trimmed &&
-          ((*i == '\n') || (*i == '\r')))
-      {
-        // Whitespace sequences containing CR or LF are eliminated entirely.
-        already_trimmed = true;
-        --chars_written;
-      }
-    }
-    else
-    {
-      // Non-whitespace chracters are copied straight across.
-      in_whitespace = false;
-      already_trimmed = false;
-      result[chars_written++] = *i;
-    }
+    const unsigned int mask = WhitespaceMaskAVX2(p) ^ flip;
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
   }
+  return p;
+}
 
-  if (in_whitespace && !already_trimmed)
+TARGET_AVX2
+static const char* ReverseScanWhitespaceASCIIAVX2(const char* begin,
+                                                  const char* end,
+                                                  bool whitespace)
+{
+  const unsigned int flip = whitespace ? 0 : 0xFFFFFFFFu;
+  for (; end - begin >= 32; end -= 32)
   {
-    // Any trailing whitespace is eliminated.
-    --chars_written;
+    const unsigned int mask = WhitespaceMaskAVX2(end - 32) ^ flip;
+    if (mask != 0)
+      return end - __builtin_clz(mask);
   }
+  return end;
+}
+#endif
 
-  result.resize(chars_written);
-  return result;
+// Returns the first byte of [p, end) that is whitespace if |whitespace| is
+// true, or that is not whitespace otherwise; |end| if there is none.
+static const char* ScanWhitespaceASCII(const char* p, const char* end,
+                                       bool whitespace)
+{
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasAVX2())
+  {
+    p = ScanWhitespaceASCIIAVX2(p, end, whitespace);
+    if (end - p >= 32)
+      return p;
+  }
+#endif
+#if defined(__SSE2__)
+  const unsigned int flip = whitespace ? 0 : 0xFFFFu;
+  for (; end - p >= 16; p += 16)
+  {
+    const unsigned int mask = WhitespaceMaskSSE2(p) ^ flip;
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+#endif
+  for (; p != end; ++p)
+  {
+    if (IsWhitespaceASCIIByte(*p) == whitespace)
+      return p;
+  }
+  return end;
 }
 
-std::string
-CollapseWhitespaceASCII(const std::string& text,
-                        bool trim_sequences_with_line_breaks)
+// Same as above, scanning backwards: returns one past the last byte of
+// [begin, end) with the requested whitespace-ness, or |begin|.
+static const char* ReverseScanWhitespaceASCII(const char* begin,
+                                              const char* end,
+                                              bool whitespace)
 {
-  return CollapseWhitespaceT(text, trim_sequences_with_line_breaks);
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasAVX2())
+  {
+    const char* found = ReverseScanWhitespaceASCIIAVX2(begin, end, whitespace);
+    if (found - begin >= 32)
+      return found;
+    end = found;
+  }
+#endif
+#if defined(__SSE2__)
+  const unsigned int flip = whitespace ? 0 : 0xFFFFu;
+  for (; end - begin >= 16; end -= 16)
+  {
+    const unsigned int mask = WhitespaceMaskSSE2(end - 16) ^ flip;
+    if (mask != 0)
+      return end - (__builtin_clz(mask) - 16);
+  }
+#endif
+  for (; end != begin; --end)
+  {
+    if (IsWhitespaceASCIIByte(end[-1]) == whitespace)
+      return end;
+  }
+  return begin;
 }
 
-bool
-FormatHexString(std::string &_input)
+// The whitespace of kWhitespaceWide outside ASCII is U+0085 and U+00A0 (lead
+// byte 0xC2), U+1680 and U+180E (0xE1), U+2000 to U+205F (0xE2) and U+3000
+// (0xE3).  Any other byte of a UTF-8 sequence cannot start one of them.
+static inline bool MayStartWhitespaceUTF8(unsigned char c)
 {
-  std::string temp_input = _input;
-  ReplaceChars(temp_input, " ", "", &temp_input);
+  return c == 0xC2 || (c >= 0xE1 && c <= 0xE3);
+}
 
-  if (0 != temp_input.length() % 2)
+// Returns the length of the UTF-8 whitespace character starting at |p|, or 0
+// if there is none.  |p| points to a non-ASCII byte.
+static int WhitespaceLengthUTF8(const char* p, const char* end)
+{
+  if (!MayStartWhitespaceUTF8(static_cast<unsigned char>(*p)))
+    return 0;
+  const uint8* s = reinterpret_cast<const uint8*>(p);
+  int32 length = 0;
+  base_icu::UChar32 c;
+  CBU8_NEXT(s, length, end - p, c);
+  return (c > 0 && IsWhitespace(static_cast<wchar_t>(c))) ? length : 0;
+}
+
+#if defined(HAVE_TARGET_ATTRIBUTE)
+// Skips the 32 byte blocks at the front of [p, end) that hold neither ASCII
+// whitespace nor non-ASCII bytes.
+TARGET_AVX2
+static const char* ScanWhitespaceOrNonASCIIAVX2(const char* p, const char* end)
+{
+  for (; end - p >= 32; p += 32)
   {
-    // e.g. @_input = "i"
-    return false;
+    const unsigned int mask = WhitespaceMaskAVX2(p) |
+        _mm256_movemask_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return p;
+}
+#endif
+
+// Returns the first byte of [p, end) that is ASCII whitespace or non-ASCII,
+// or |end|.
+static const char* ScanWhitespaceOrNonASCII(const char* p, const char* end)
+{
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasAVX2())
+  {
+    p = ScanWhitespaceOrNonASCIIAVX2(p, end);
+    if (end - p >= 32)
+      return p;
+  }
+#endif
+#if defined(__SSE2__)
+  for (; end - p >= 16; p += 16)
+  {
+    const unsigned int mask = WhitespaceMaskSSE2(p) |
+        _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+#endif
+  for (; p != end; ++p)
+  {
+    if (IsWhitespaceASCIIByte(*p) || (*p & 0x80))
+      return p;
+  }
+  return end;
+}
+
+// The scans below work on ASCII whitespace only, or, with |utf8|, on all of
+// kWhitespaceWide in UTF-8.  The UTF-8 versions run the ASCII scans and only
+// decode where those stop on a non-ASCII byte, so ASCII spans keep their
+// speed.
+
+// Returns the first non-whitespace character of [p, end), or |end|.
+static const char* SkipWhitespace(const char* p, const char* end, bool utf8)
+{
+  p = ScanWhitespaceASCII(p, end, false);
+  while (utf8 && p != end && (*p & 0x80))
+  {
+    const int length = WhitespaceLengthUTF8(p, end);
+    if (length == 0)
+      break;
+    p = ScanWhitespaceASCII(p + length, end, false);
+  }
+  return p;
+}
+
+// Returns the first whitespace character of [p, end), or |end|.
+static const char* FindWhitespace(const char* p, const char* end, bool utf8)
+{
+  if (!utf8)
+    return ScanWhitespaceASCII(p, end, true);
+
+  p = ScanWhitespaceOrNonASCII(p, end);
+  while (p != end && (*p & 0x80))
+  {
+    if (WhitespaceLengthUTF8(p, end) != 0)
+      break;
+    // Non-ASCII text is stepped through here rather than restarting the
+    // block scan for every byte.
+    ++p;
+    if (p != end && !(*p & 0x80))
+      p = ScanWhitespaceOrNonASCII(p, end);
+  }
+  return p;
+}
+
+// Returns one past the last non-whitespace character of [begin, end), or
+// |begin|.
+static const char* ReverseSkipWhitespace(const char* begin,
+                                         const char* end,
+                                         bool utf8)
+{
+  end = ReverseScanWhitespaceASCII(begin, end, false);
+  while (utf8 && end != begin && (end[-1] & 0x80))
+  {
+    // Back up to the lead byte of the last character.
+    const char* lead = end - 1;
+    while (lead != begin && end - lead < 3 &&
+           (static_cast<unsigned char>(*lead) & 0xC0) == 0x80)
+      --lead;
+    if (WhitespaceLengthUTF8(lead, end) != end - lead)
+      break;
+    end = ReverseScanWhitespaceASCII(begin, lead, false);
+  }
+  return end;
+}
+
+// Finds the range of |input| left after trimming |positions|.  Returns false
+// if |input| is empty or whitespace only.
+static bool FindTrimmedRange(const StringPiece& input,
+                             TrimPositions positions,
+                             bool utf8,
+                             const char** first,
+                             const char** last)
+{
+  *first = input.begin();
+  *last = input.end();
+  if (positions & TRIM_LEADING)
+  {
+    *first = SkipWhitespace(*first, *last, utf8);
+    if (*first == *last)
+      return false;
+  }
+  if (positions & TRIM_TRAILING)
+  {
+    *last = ReverseSkipWhitespace(*first, *last, utf8);
+    if (*first == *last)
+      return false;
+  }
+  return !input.empty();
+}
+
+static TrimPositions TrimmedPositions(const StringPiece& input,
+                                      const char* first,
+                                      const char* last)
+{
+  return static_cast<TrimPositions>(
+      ((first == input.begin()) ? TRIM_NONE : TRIM_LEADING) |
+      ((last == input.end()) ? TRIM_NONE : TRIM_TRAILING));
+}
+
+static TrimPositions DoTrimWhitespace(const std::string& input,
+                                      TrimPositions positions,
+                                      bool utf8,
+                                      std::string* output)
+{
+  const char* first;
+  const char* last;
+  if (!FindTrimmedRange(input, positions, utf8, &first, &last))
+  {
+    // When the string was all whitespace, report that we stripped off
+    // whitespace from whichever position the caller was interested in.  For
+    // empty input, we stripped no whitespace, but we still need to clear
+    // |output|.
+    bool input_was_empty = input.empty();  // in case output == &input
+    output->clear();
+    return input_was_empty ? TRIM_NONE : positions;
+  }
+
+  const TrimPositions trimmed = TrimmedPositions(input, first, last);
+  if (output == &input)
+  {
+    // Shrink the string in place rather than copying it.
+    if (trimmed != TRIM_NONE)
+    {
+      const size_t first_pos = first - input.data();
+      output->resize(last - input.data());
+      output->erase(0, first_pos);
+    }
   }
   else
   {
-    const std::string::const_iterator it =
-        std::find_if_not(temp_input.begin(), temp_input.end(), IsHexDigit<char>);
+    output->assign(first, last - first);
+  }
+  return trimmed;
+}
+
+static StringPiece DoTrimWhitespace(const StringPiece& input,
+                                    TrimPositions positions,
+                                    bool utf8)
+{
+  const char* first;
+  const char* last;
+  if (!FindTrimmedRange(input, positions, utf8, &first, &last))
+    return StringPiece();
+  return StringPiece(first, last - first);
+}
+
+TrimPositions
+TrimWhitespaceASCII(const std::string& input,
+                    TrimPositions positions,
+                    std::string* output)
+{
+  return DoTrimWhitespace(input, positions, false, output);
+}
+
+TrimPositions
+TrimWhitespaceASCII(std::string&& input,
+                    TrimPositions positions,
+                    std::string* output)
+{
+  if (output != &input)
+    *output = std::move(input);
+  return DoTrimWhitespace(*output, positions, false, output);
+}
+
+TrimPositions
+TrimWhitespaceASCII(std::string* str, TrimPositions positions)
+{
+  return DoTrimWhitespace(*str, positions, false, str);
+}
+
+StringPiece
+TrimWhitespaceASCII(const StringPiece& input, TrimPositions positions)
+{
+  return DoTrimWhitespace(input, positions, false);
+}
+
+TrimPositions
+TrimWhitespace(const std::string& input,
+               TrimPositions positions,
+               std::string* output)
+{
+  return DoTrimWhitespace(input, positions, true, output);
+}
+
+TrimPositions
+TrimWhitespace(std::string&& input,
+               TrimPositions positions,
+               std::string* output)
+{
+  if (output != &input)
+    *output = std::move(input);
+  return DoTrimWhitespace(*output, positions, true, output);
+}
+
+TrimPositions
+TrimWhitespace(std::string* str, TrimPositions positions)
+{
+  return DoTrimWhitespace(*str, positions, true, str);
+}
+
+StringPiece
+TrimWhitespace(const StringPiece& input, TrimPositions positions)
+{
+  return DoTrimWhitespace(input, positions, true);
+}
+
+// Writes the collapsed form of [p, end) to |out| and returns the end of what
+// was written.  |out| may be |p|: the output never gets ahead of the input.
+static char* CollapseWhitespaceInto(const char* p, const char* end,
+                                    char* out,
+                                    bool trim_sequences_with_line_breaks,
+                                    bool utf8)
+{
+  // Leading whitespace is trimmed.
+  p = SkipWhitespace(p, end, utf8);
+  while (p != end)
+  {
+    // Non-whitespace chracters are copied straight across.
+    const char* run_end = FindWhitespace(p, end, utf8);
+    if (out != p)
+      memmove(out, p, run_end - p);
+    out += run_end - p;
+
+    // Any trailing whitespace is eliminated.
+    p = SkipWhitespace(run_end, end, utf8);
+    if (p == end)
+      break;
+
+    // Reduce all other whitespace sequences to a single space, except that
+    // sequences containing CR or LF may be eliminated entirely.
+    bool has_line_break = false;
+    if (trim_sequences_with_line_breaks)
+    {
+      for (const char* ws = run_end; ws != p && !has_line_break; ++ws)
+        has_line_break = (*ws == '\n' || *ws == '\r');
+    }
+    if (!has_line_break)
+      *out++ = ' ';
+  }
+  return out;
+}
+
+static std::string DoCollapseWhitespace(const std::string& text,
+                                        bool trim_sequences_with_line_breaks,
+                                        bool utf8)
+{
+  std::string result;
+  result.resize(text.size());
+  if (text.empty())
+    return result;
+
+  char* out = &result[0];
+  result.resize(CollapseWhitespaceInto(text.data(),
+                                       text.data() + text.size(),
+                                       out,
+                                       trim_sequences_with_line_breaks,
+                                       utf8) - out);
+  return result;
+}
+
+static void DoCollapseWhitespace(std::string* text,
+                                 bool trim_sequences_with_line_breaks,
+                                 bool utf8)
+{
+  if (text->empty())
+    return;
+
+  char* begin = &(*text)[0];
+  text->resize(CollapseWhitespaceInto(begin, begin + text->size(), begin,
+                                      trim_sequences_with_line_breaks,
+                                      utf8) - begin);
+}
+
+std::string
+CollapseWhitespaceASCII(const std::string& text,
+                        bool trim_sequences_with_line_breaks)
+{
+  return DoCollapseWhitespace(text, trim_sequences_with_line_breaks, false);
+}
+
+std::string
+CollapseWhitespaceASCII(std::string&& text,
+                        bool trim_sequences_with_line_breaks)
+{
+  DoCollapseWhitespace(&text, trim_sequences_with_line_breaks, false);
+  return std::move(text);
+}
+
+void
+CollapseWhitespaceASCII(std::string* text,
+                        bool trim_sequences_with_line_breaks)
+{
+  DoCollapseWhitespace(text, trim_sequences_with_line_breaks, false);
+}
+
+std::string
+CollapseWhitespace(const std::string& text,
+                   bool trim_sequences_with_line_breaks)
+{
+  return DoCollapseWhitespace(text, trim_sequences_with_line_breaks, true);
+}
+
+std::string
+CollapseWhitespace(std::string&& text,
+                   bool trim_sequences_with_line_breaks)
+{
+  DoCollapseWhitespace(&text, trim_sequences_with_line_breaks, true);
+  return std::move(text);
+}
+
+void
+CollapseWhitespace(std::string* text,
+                   bool trim_sequences_with_line_breaks)
+{
+  DoCollapseWhitespace(text, trim_sequences_with_line_breaks, true);
+}
+
+// Flips the 0x20 bit of every byte in [first, first + 25]: with 'A' this
+// lower-cases ASCII letters, with 'a' it upper-cases them.
+static inline char FlipCaseASCII(char c, char first)
+{
+  return (static_cast<unsigned char>(c - first) < 26) ? (c ^ 0x20) : c;
+}
+
+#if defined(__SSE2__)
+// Adding 128 - |first| maps the 26 letters to the bottom of the signed byte
+// range, so a single signed compare finds them.
+static inline __m128i FlipCaseSSE2(__m128i chunk, char first)
+{
+  const __m128i shifted =
+      _mm_add_epi8(chunk, _mm_set1_epi8(static_cast<char>(128 - first)));
+  const __m128i is_letter = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+  return _mm_xor_si128(chunk, _mm_and_si128(is_letter, _mm_set1_epi8(0x20)));
+}
+#endif
+
+#if defined(HAVE_TARGET_ATTRIBUTE)
+TARGET_AVX2
+static inline __m256i FlipCaseAVX2(__m256i chunk, char first)
+{
+  const __m256i shifted = _mm256_add_epi8(
+      chunk, _mm256_set1_epi8(static_cast<char>(128 - first)));
+  const __m256i is_letter =
+      _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+  return _mm256_xor_si256(chunk,
+                          _mm256_and_si256(is_letter, _mm256_set1_epi8(0x20)));
+}
+
+TARGET_AVX2
+static char* ConvertCaseASCIIAVX2(char* p, char* end, char first)
+{
+  for (; end - p >= 32; p += 32)
+  {
+    __m256i* chunk = reinterpret_cast<__m256i*>(p);
+    _mm256_storeu_si256(chunk, FlipCaseAVX2(_mm256_loadu_si256(chunk), first));
+  }
+  return p;
+}
+
+// Returns the number of leading bytes compared equal; stops at the first
+// 32 byte block that differs.
+TARGET_AVX2
+static size_t EqualsCaseFoldedASCIIAVX2(const char* a, const char* b,
+                                        size_t length, bool fold_b)
+{
+  size_t i = 0;
+  for (; length - i >= 32; i += 32)
+  {
+    const __m256i lower_a = FlipCaseAVX2(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)), 'A');
+    __m256i lower_b =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    if (fold_b)
+      lower_b = FlipCaseAVX2(lower_b, 'A');
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(lower_a, lower_b)) != -1)
+      break;
+  }
+  return i;
+}
+#endif
+
+static void ConvertCaseASCII(char* p, char* end, char first)
+{
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasAVX2())
+    p = ConvertCaseASCIIAVX2(p, end, first);
+#endif
+#if defined(__SSE2__)
+  for (; end - p >= 16; p += 16)
+  {
+    __m128i* chunk = reinterpret_cast<__m128i*>(p);
+    _mm_storeu_si128(chunk, FlipCaseSSE2(_mm_loadu_si128(chunk), first));
+  }
+#endif
+  for (; p != end; ++p)
+    *p = FlipCaseASCII(*p, first);
+}
+
+// Returns true if the |length| bytes at |a| and |b| are equal once ASCII
+// letters are lower-cased.  When |fold_b| is false, |b| is expected to be
+// lower case already and is compared as is.
+static bool EqualsCaseFoldedASCII(const char* a, const char* b,
+                                  size_t length, bool fold_b)
+{
+  size_t i = 0;
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasAVX2())
+  {
+    i = EqualsCaseFoldedASCIIAVX2(a, b, length, fold_b);
+    if (length - i >= 32)
+      return false;
+  }
+#endif
+#if defined(__SSE2__)
+  for (; length - i >= 16; i += 16)
+  {
+    const __m128i lower_a = FlipCaseSSE2(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)), 'A');
+    __m128i lower_b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    if (fold_b)
+      lower_b = FlipCaseSSE2(lower_b, 'A');
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(lower_a, lower_b)) != 0xFFFF)
+      return false;
+  }
+#endif
+  for (; i < length; ++i)
+  {
+    const char lower_b = fold_b ? FlipCaseASCII(b[i], 'A') : b[i];
+    if (FlipCaseASCII(a[i], 'A') != lower_b)
+      return false;
+  }
+  return true;
+}
+
+void
+StringToLowerASCII(std::string* s)
+{
+  if (!s->empty())
+    ConvertCaseASCII(&(*s)[0], &(*s)[0] + s->size(), 'A');
+}
+
+std::string
+StringToLowerASCII(const std::string& s)
+{
+  std::string output(s);
+  StringToLowerASCII(&output);
+  return output;
+}
+
+std::string
+StringToLowerASCII(std::string&& s)
+{
+  StringToLowerASCII(&s);
+  return std::move(s);
+}
+
+void
+StringToUpperASCII(std::string* s)
+{
+  if (!s->empty())
+    ConvertCaseASCII(&(*s)[0], &(*s)[0] + s->size(), 'a');
+}
+
+std::string
+StringToUpperASCII(const std::string& s)
+{
+  std::string output(s);
+  StringToUpperASCII(&output);
+  return output;
+}
+
+std::string
+StringToUpperASCII(std::string&& s)
+{
+  StringToUpperASCII(&s);
+  return std::move(s);
+}
+
+bool
+FormatHexString(std::string &_input)
+{
+  std::string temp_input = _input;
+  ReplaceChars(temp_input, " ", "", &temp_input);
+
+  if (0 != temp_input.length() % 2)
+  {
+    // e.g. @_input = "i"
+    return false;
+  }
+  else
+  {
+    const std::string::const_iterator it =
+        std::find_if_not(temp_input.begin(), temp_input.end(), IsHexDigit<char>);
+
+    if (temp_input.end() != it)
+    {
+      // e.g. @_input="i love dog"
+      return false;
+    }
+    else
+    {
+      std::string::iterator it = temp_input.begin() + 2;
+      while (it < temp_input.end())
+      {
+        it = temp_input.insert(it, ' ');
+        it += 3;
+      }
+      _input = temp_input;
+      return true;
+    }
+  }
+}
+
+// Reverses the order of the |Step|-byte elements of [p, end).
+template <size_t Step>
+static void ReverseElements(char* p, char* end)
+{
+  char element[Step];
+  for (end -= Step; p < end; p += Step, end -= Step)
+  {
+    memcpy(element, p, Step);
+    memcpy(p, end, Step);
+    memcpy(end, element, Step);
+  }
+}
+
+static void ReverseElements(char* p, char* end, size_t step)
+{
+  for (end -= step; p < end; p += step, end -= step)
+    std::swap_ranges(p, p + step, end);
+}
+
+#if defined(HAVE_TARGET_ATTRIBUTE)
+// PSHUFB masks reversing the order of the 1, 2, 4 or 8-byte elements of a 16
+// byte block.
+static const uint8 kReverseMasks[4][16] = {
+  { 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 },
+  { 14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1 },
+  { 12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3 },
+  { 8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7 },
+};
+
+// The block kernels swap the 16 (32) byte blocks at both ends of [*p, *end),
+// reversing the elements within them, until less than two blocks are left
+// in the middle.
+TARGET_SSE42
+static void ReverseElementsSSE42(char** p, char** end,
+                                 const uint8* mask_bytes)
+{
+  const __m128i mask =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask_bytes));
+  char* front = *p;
+  char* back = *end;
+  for (; back - front >= 32; front += 16, back -= 16)
+  {
+    __m128i* front_block = reinterpret_cast<__m128i*>(front);
+    __m128i* back_block = reinterpret_cast<__m128i*>(back - 16);
+    const __m128i a = _mm_loadu_si128(front_block);
+    const __m128i b = _mm_loadu_si128(back_block);
+    _mm_storeu_si128(front_block, _mm_shuffle_epi8(b, mask));
+    _mm_storeu_si128(back_block, _mm_shuffle_epi8(a, mask));
+  }
+  *p = front;
+  *end = back;
+}
+
+TARGET_AVX2
+static void ReverseElementsAVX2(char** p, char** end,
+                                const uint8* mask_bytes)
+{
+  // VPSHUFB works within 128-bit lanes, VPERMQ then swaps the lanes.
+  const __m256i mask = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask_bytes)));
+  char* front = *p;
+  char* back = *end;
+  for (; back - front >= 64; front += 32, back -= 32)
+  {
+    __m256i* front_block = reinterpret_cast<__m256i*>(front);
+    __m256i* back_block = reinterpret_cast<__m256i*>(back - 32);
+    const __m256i a = _mm256_loadu_si256(front_block);
+    const __m256i b = _mm256_loadu_si256(back_block);
+    _mm256_storeu_si256(
+        front_block,
+        _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, mask), 0x4E));
+    _mm256_storeu_si256(
+        back_block,
+        _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, mask), 0x4E));
+  }
+  *p = front;
+  *end = back;
+}
+#endif
+
+void
+Reverse(char* data, size_t length, size_t step)
+{
+  if (step == 0 || step >= length)
+    return;
+
+  char* p = data;
+  char* end = data + length - length % step;
+  char* const full_end = end;
+
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  // 16 is a multiple of the step, so whole blocks swap whole elements, and
+  // the middle part left is made of whole elements too.
+  const int mask = step == 1 ? 0 : step == 2 ? 1 : step == 4 ? 2 :
+      step == 8 ? 3 : -1;
+  if (mask >= 0)
+  {
+    if (CPUHasAVX2())
+      ReverseElementsAVX2(&p, &end, kReverseMasks[mask]);
+    if (CPUHasSSE42())
+      ReverseElementsSSE42(&p, &end, kReverseMasks[mask]);
+  }
+#endif
+
+  switch (step)
+  {
+    case 1:
+      std::reverse(p, end);
+      break;
+    case 2:
+      ReverseElements<2>(p, end);
+      break;
+    case 4:
+      ReverseElements<4>(p, end);
+      break;
+    case 8:
+      ReverseElements<8>(p, end);
+      break;
+    default:
+      ReverseElements(p, end, step);
+      break;
+  }
+
+  // The last, partial element goes first.
+  if (full_end != data + length)
+    std::rotate(data, full_end, data + length);
+}
+
+void
+Reverse(std::string* str, size_t step)
+{
+  if (!str->empty())
+    Reverse(&(*str)[0], str->length(), step);
+}
+
+void
+Reverse(const std::string& _input, std::string *_output, const size_t _step)
+{
+  if (_output != &_input)
+    *_output = _input;
+  Reverse(_output, _step);
+}
+
+void
+Reverse(std::string&& _input, std::string *_output, const size_t _step)
+{
+  if (_output != &_input)
+    *_output = std::move(_input);
+  Reverse(_output, _step);
+}
+
+static const char kUpperHexDigits[] = "0123456789ABCDEF";
+
+// Parses the "XX XX XX XX" form of an IPv4 address, or the 16 byte one of an
+// IPv6 address, with one space between bytes.  Returns the number of bytes,
+// or 0.
+static size_t ParseHexIp(const StringPiece& text, uint8 bytes[16])
+{
+  const char* p = text.data();
+  const char* const end = p + text.size();
+  size_t count = 0;
+  while (p != end)
+  {
+    if (count != 0 && *p++ != ' ')
+      return 0;
+    if (count == IPAddress::kIPv6AddressSize || end - p < 2 ||
+        !IsHexDigit(p[0]) || !IsHexDigit(p[1]))
+      return 0;
+    bytes[count++] = static_cast<uint8>(HexDigitToInt(p[0]) * 16 +
+                                        HexDigitToInt(p[1]));
+    p += 2;
+  }
+  return (count == IPAddress::kIPv4AddressSize ||
+          count == IPAddress::kIPv6AddressSize) ? count : 0;
+}
+
+bool
+IpToHexString(const StringPiece& _ip, std::string *_hex_string)
+{
+  IPAddress address;
+  if (!address.AssignFromIPLiteral(TrimWhitespaceASCII(_ip, TRIM_ALL)))
+    return false;
+
+  // "C0 A8 04 0C"
+  _hex_string->resize(address.size() * 3 - 1);
+  char* out = &(*_hex_string)[0];
+  for (size_t i = 0; i < address.size(); ++i)
+  {
+    if (i != 0)
+      *out++ = ' ';
+    *out++ = kUpperHexDigits[address.bytes()[i] >> 4];
+    *out++ = kUpperHexDigits[address.bytes()[i] & 0x0F];
+  }
+  return true;
+}
+
+bool
+HexStringToIp(const StringPiece& _hex_string, std::string *_ip)
+{
+  uint8 bytes[IPAddress::kIPv6AddressSize];
+  const size_t size =
+      ParseHexIp(TrimWhitespaceASCII(_hex_string, TRIM_ALL), bytes);
+  if (size == 0)
+    return false;
+  // Formatted on the stack, so |_ip| keeps its buffer.
+  char text[IPAddress::kMaxIPv6StringLength];
+  _ip->assign(text, IPAddress(bytes, size).ToChars(text));
+  return true;
+}
+
+// The escaped form of every byte for one codec: the bytes of |special| are
+// written as the |length[c]| first chars of |text[c]|.
+struct EscapeTable
+{
+  static const size_t kMaxLength = 8;
+
+  CharSet special;
+  unsigned char length[256];
+  char text[256][kMaxLength];
+
+  void Set(unsigned char c, const char* escape, size_t escape_length)
+  {
+    special.Add(static_cast<char>(c));
+    length[c] = static_cast<unsigned char>(escape_length);
+    memcpy(text[c], escape, escape_length);
+  }
+};
+
+// Returns the first byte of [p, end) that is in |set|, or |end|.  Escapes
+// tend to come in clusters, so the next few bytes are tested one by one
+// before the rest is handed over to the SIMD scan.
+static inline const char* FindSpecial(const CharSet& set,
+                                      const char* p, const char* end)
+{
+  const char* const stop = end - p > 8 ? p + 8 : end;
+  for (; p != stop; ++p)
+  {
+    if (set.Contains(*p))
+      return p;
+  }
+  return p == end ? end : set.Scan(p, end, true);
+}
+
+// Appends |input| to |output| with every special byte of |table| replaced by
+// its escape.  A first pass over |input| sizes |output| exactly, the second
+// one fills it.  Both passes test the next few bytes one by one and hand
+// longer runs over to CharSet::Scan(), so text with little to escape costs
+// about two SIMD scans and a memcpy.
+static void EscapeWith(const StringPiece& input, const EscapeTable& table,
+                       std::string* output)
+{
+  const char* p = input.data();
+  const char* const end = p + input.size();
+
+  size_t length = input.size();
+  for (const char* s = FindSpecial(table.special, p, end); s != end;
+       s = FindSpecial(table.special, s + 1, end))
+  {
+    length += table.length[static_cast<unsigned char>(*s)] - 1;
+  }
+  if (length == 0)
+    return;
+
+  // Escapes are copied as whole kMaxLength entries, hence the slack.
+  const size_t old_size = output->size();
+  output->resize(old_size + length + EscapeTable::kMaxLength);
+  char* out = &(*output)[old_size];
+  for (;;)
+  {
+    // Bytes are copied one at a time while the escapes come close together.
+    const char* const stop = end - p > 8 ? p + 8 : end;
+    while (p != stop && !table.special.Contains(*p))
+      *out++ = *p++;
+    if (p == stop)
+    {
+      const char* s = p == end ? end : table.special.Scan(p, end, true);
+      memcpy(out, p, s - p);
+      out += s - p;
+      p = s;
+    }
+    if (p == end)
+      break;
+    const unsigned char c = *p++;
+    memcpy(out, table.text[c], EscapeTable::kMaxLength);
+    out += table.length[c];
+  }
+  output->resize(old_size + length);
+}
+
+// Runs |decode| over |input| into the tail of |output|, which is grown by
+// input.size() first: none of the decoders makes the text longer.  |decode|
+// returns the end of what it wrote, or NULL if |input| is malformed.
+template <typename Decoder>
+static bool UnescapeWith(const StringPiece& input, Decoder decode,
+                         std::string* output)
+{
+  // The data of an empty StringPiece may be NULL, which the decoders pass
+  // on to memchr() and memmove().
+  if (input.empty())
+    return true;
+  const size_t old_size = output->size();
+  output->resize(old_size + input.size());
+  char* begin = &(*output)[old_size];
+  const char* out = decode(input.data(), input.data() + input.size(), begin);
+  if (!out)
+  {
+    output->resize(old_size);
+    return false;
+  }
+  output->resize(old_size + (out - begin));
+  return true;
+}
+
+// Returns the first backslash of [p, end), or |end|.
+static inline const char* FindBackslash(const char* p, const char* end)
+{
+  const void* s = memchr(p, '\\', end - p);
+  return s ? static_cast<const char*>(s) : end;
+}
+
+static inline bool IsOctalDigit(char c)
+{
+  return c >= '0' && c <= '7';
+}
+
+// Returns the escape letter of |c| shared by C and JSON, or '\0'.
+static inline char ShortEscape(unsigned char c)
+{
+  switch (c)
+  {
+    case '\b': return 'b';
+    case '\f': return 'f';
+    case '\n': return 'n';
+    case '\r': return 'r';
+    case '\t': return 't';
+    case '"':  return '"';
+    case '\\': return '\\';
+  }
+  return '\0';
+}
+
+static EscapeTable MakeCEscapeTable()
+{
+  EscapeTable table = EscapeTable();
+  for (int i = 0; i < 256; ++i)
+  {
+    const unsigned char c = static_cast<unsigned char>(i);
+    // Only the escapes every C dialect reads the same way get a letter.
+    const char letter = (c == '\b' || c == '\f') ? '\0' :
+        (c == '\'' ? '\'' : ShortEscape(c));
+    if (letter)
+    {
+      const char escape[] = { '\\', letter };
+      table.Set(c, escape, sizeof(escape));
+    }
+    else if (c < 0x20 || c >= 0x7F)
+    {
+      const char escape[] = {
+        '\\',
+        static_cast<char>('0' + (c >> 6)),
+        static_cast<char>('0' + ((c >> 3) & 7)),
+        static_cast<char>('0' + (c & 7)),
+      };
+      table.Set(c, escape, sizeof(escape));
+    }
+  }
+  return table;
+}
+
+static char* UnescapeCInto(const char* p, const char* end, char* out)
+{
+  for (;;)
+  {
+    const char* s = FindBackslash(p, end);
+    // |out| never runs ahead of |p|, so memmove() lets callers decode in
+    // place.
+    memmove(out, p, s - p);
+    out += s - p;
+    if (s == end)
+      return out;
+    if (++s == end)
+      return NULL;
+
+    const char c = *s++;
+    switch (c)
+    {
+      case 'a': *out++ = '\a'; break;
+      case 'b': *out++ = '\b'; break;
+      case 'f': *out++ = '\f'; break;
+      case 'n': *out++ = '\n'; break;
+      case 'r': *out++ = '\r'; break;
+      case 't': *out++ = '\t'; break;
+      case 'v': *out++ = '\v'; break;
+      case '\\':
+      case '\'':
+      case '"':
+      case '?':
+        *out++ = c;
+        break;
+      case 'x':
+      {
+        if (s == end || !IsHexDigit(*s))
+          return NULL;
+        int value = HexDigitToInt(*s++);
+        if (s != end && IsHexDigit(*s))
+          value = value * 16 + HexDigitToInt(*s++);
+        *out++ = static_cast<char>(value);
+        break;
+      }
+      default:
+      {
+        if (!IsOctalDigit(c))
+          return NULL;
+        int value = c - '0';
+        for (int i = 1; i < 3 && s != end && IsOctalDigit(*s); ++i)
+          value = value * 8 + (*s++ - '0');
+        if (value > 0xFF)
+          return NULL;
+        *out++ = static_cast<char>(value);
+        break;
+      }
+    }
+    p = s;
+  }
+}
+
+void
+EscapeC(const StringPiece& input, std::string* output)
+{
+  static const EscapeTable table = MakeCEscapeTable();
+  EscapeWith(input, table, output);
+}
+
+bool
+UnescapeC(const StringPiece& input, std::string* output)
+{
+  return UnescapeWith(input, UnescapeCInto, output);
+}
+
+static EscapeTable MakeJSONEscapeTable()
+{
+  EscapeTable table = EscapeTable();
+  for (int i = 0; i < 256; ++i)
+  {
+    const unsigned char c = static_cast<unsigned char>(i);
+    const char letter = ShortEscape(c);
+    if (letter)
+    {
+      const char escape[] = { '\\', letter };
+      table.Set(c, escape, sizeof(escape));
+    }
+    else if (c < 0x20)
+    {
+      const char escape[] = {
+        '\\', 'u', '0', '0',
+        kUpperHexDigits[c >> 4], kUpperHexDigits[c & 0x0F]
+      };
+      table.Set(c, escape, sizeof(escape));
+    }
+  }
+  return table;
+}
+
+// Reads the four hex digits of a \u escape at |p|.
+static bool ReadHex4(const char* p, const char* end, uint32* value)
+{
+  if (end - p < 4)
+    return false;
+  uint32 result = 0;
+  for (int i = 0; i < 4; ++i)
+  {
+    if (!IsHexDigit(p[i]))
+      return false;
+    result = result * 16 + HexDigitToInt(p[i]);
+  }
+  *value = result;
+  return true;
+}
+
+static char* UnescapeJSONStringInto(const char* p, const char* end, char* out)
+{
+  for (;;)
+  {
+    const char* s = FindBackslash(p, end);
+    memmove(out, p, s - p);
+    out += s - p;
+    if (s == end)
+      return out;
+    if (++s == end)
+      return NULL;
+
+    const char c = *s++;
+    switch (c)
+    {
+      case 'b': *out++ = '\b'; break;
+      case 'f': *out++ = '\f'; break;
+      case 'n': *out++ = '\n'; break;
+      case 'r': *out++ = '\r'; break;
+      case 't': *out++ = '\t'; break;
+      case '"':
+      case '\\':
+      case '/':
+        *out++ = c;
+        break;
+      case 'u':
+      {
+        uint32 code_point;
+        if (!ReadHex4(s, end, &code_point))
+          return NULL;
+        s += 4;
+        if (CBU16_IS_TRAIL(code_point))
+          return NULL;
+        if (CBU16_IS_LEAD(code_point))
+        {
+          uint32 trail;
+          if (end - s < 6 || s[0] != '\\' || s[1] != 'u' ||
+              !ReadHex4(s + 2, end, &trail) || !CBU16_IS_TRAIL(trail))
+            return NULL;
+          s += 6;
+          code_point = CBU16_GET_SUPPLEMENTARY(code_point, trail);
+        }
+        // The escape is at least as long as the UTF-8 it stands for.
+        uint8* bytes = reinterpret_cast<uint8*>(out);
+        int length = 0;
+        CBU8_APPEND_UNSAFE(bytes, length, code_point);
+        out += length;
+        break;
+      }
+      default:
+        return NULL;
+    }
+    p = s;
+  }
+}
+
+void
+EscapeJSONString(const StringPiece& input, std::string* output)
+{
+  static const EscapeTable table = MakeJSONEscapeTable();
+  EscapeWith(input, table, output);
+}
+
+bool
+UnescapeJSONString(const StringPiece& input, std::string* output)
+{
+  return UnescapeWith(input, UnescapeJSONStringInto, output);
+}
+
+static EscapeTable MakePercentEscapeTable(bool space_as_plus)
+{
+  EscapeTable table = EscapeTable();
+  for (int i = 0; i < 256; ++i)
+  {
+    const unsigned char c = static_cast<unsigned char>(i);
+    if (IsAsciiAlpha(c) || IsAsciiDigit(c) ||
+        c == '-' || c == '.' || c == '_' || c == '~')
+      continue;
+    if (space_as_plus && c == ' ')
+    {
+      table.Set(c, "+", 1);
+      continue;
+    }
+    const char escape[] = {
+      '%', kUpperHexDigits[c >> 4], kUpperHexDigits[c & 0x0F]
+    };
+    table.Set(c, escape, sizeof(escape));
+  }
+  return table;
+}
+
+static char* UnescapePercentInto(const char* p, const char* end, char* out,
+                                 bool plus_as_space)
+{
+  static constexpr CharSet kPercent("%");
+  static constexpr CharSet kPercentOrPlus("%+");
+  const CharSet& special = plus_as_space ? kPercentOrPlus : kPercent;
+  for (;;)
+  {
+    const char* s = FindSpecial(special, p, end);
+    memmove(out, p, s - p);
+    out += s - p;
+    if (s == end)
+      return out;
+
+    if (*s == '+')
+    {
+      *out++ = ' ';
+      p = s + 1;
+    }
+    else if (end - s >= 3 && IsHexDigit(s[1]) && IsHexDigit(s[2]))
+    {
+      *out++ = static_cast<char>(HexDigitToInt(s[1]) * 16 +
+                                 HexDigitToInt(s[2]));
+      p = s + 3;
+    }
+    else
+    {
+      *out++ = '%';
+      p = s + 1;
+    }
+  }
+}
+
+void
+EscapePercent(const StringPiece& input, std::string* output,
+              bool space_as_plus)
+{
+  static const EscapeTable table = MakePercentEscapeTable(false);
+  static const EscapeTable plus_table = MakePercentEscapeTable(true);
+  EscapeWith(input, space_as_plus ? plus_table : table, output);
+}
+
+void
+UnescapePercent(const StringPiece& input, std::string* output,
+                bool plus_as_space)
+{
+  UnescapeWith(input,
+               [plus_as_space](const char* p, const char* end, char* out) {
+                 return UnescapePercentInto(p, end, out, plus_as_space);
+               },
+               output);
+}
+
+size_t
+UnescapePercentInPlace(char* data, size_t length, bool plus_as_space)
+{
+  if (length == 0)
+    return 0;
+  return UnescapePercentInto(data, data + length, data, plus_as_space) - data;
+}
+
+const size_t MultiReplacer::kNoPattern;
+
+MultiReplacer::MultiReplacer(
+    const std::vector<std::pair<std::string, std::string> >& replacements)
+    : num_classes_(1)
+{
+  memset(byte_classes_, 0, sizeof(byte_classes_));
+  for (size_t i = 0; i < replacements.size(); ++i)
+  {
+    const std::string& needle = replacements[i].first;
+    for (size_t j = 0; j < needle.length(); ++j)
+    {
+      const unsigned char c = static_cast<unsigned char>(needle[j]);
+      if (byte_classes_[c] == 0)
+        byte_classes_[c] = static_cast<unsigned char>(num_classes_++);
+    }
+  }
+  // 256 distinct bytes plus the shared class do not fit in a byte; in that
+  // case every byte appears in a needle and class 0 is simply never used.
+  if (num_classes_ > 256)
+  {
+    for (int c = 0; c < 256; ++c)
+      byte_classes_[c] = static_cast<unsigned char>(c);
+    num_classes_ = 256;
+  }
+
+  // Build the trie.  Missing edges are marked with kNone and filled in below.
+  const unsigned int kNone = static_cast<unsigned int>(-1);
+  transitions_.assign(num_classes_, kNone);
+  depth_.assign(1, 0);
+  match_.assign(1, kNoPattern);
+
+  for (size_t i = 0; i < replacements.size(); ++i)
+  {
+    const std::string& needle = replacements[i].first;
+    if (needle.empty())
+      continue;
+
+    size_t state = 0;
+    for (size_t j = 0; j < needle.length(); ++j)
+    {
+      const size_t edge = state * num_classes_ +
+          byte_classes_[static_cast<unsigned char>(needle[j])];
+      if (transitions_[edge] == kNone)
+      {
+        transitions_[edge] = static_cast<unsigned int>(depth_.size());
+        transitions_.resize(transitions_.size() + num_classes_, kNone);
+        depth_.push_back(depth_[state] + 1);
+        match_.push_back(kNoPattern);
+      }
+      state = transitions_[edge];
+    }
+    if (match_[state] == kNoPattern)
+    {
+      match_[state] = patterns_.size();
+      patterns_.push_back(replacements[i]);
+    }
+  }
+
+  // Breadth-first over the trie: compute the failure links and turn the trie
+  // into a complete DFA by borrowing the missing edges from the failure state.
+  std::vector<unsigned int> fail(depth_.size(), 0);
+  std::vector<unsigned int> queue;
+  queue.reserve(depth_.size());
+  for (size_t c = 0; c < num_classes_; ++c)
+  {
+    unsigned int& next = transitions_[c];
+    if (next == kNone)
+      next = 0;
+    else
+      queue.push_back(next);
+  }
+  for (size_t head = 0; head < queue.size(); ++head)
+  {
+    const unsigned int state = queue[head];
+    const unsigned int state_fail = fail[state];
+    if (match_[state] == kNoPattern)
+      match_[state] = match_[state_fail];
+
+    for (size_t c = 0; c < num_classes_; ++c)
+    {
+      unsigned int& next = transitions_[state * num_classes_ + c];
+      const unsigned int fail_next = transitions_[state_fail * num_classes_ + c];
+      if (next == kNone)
+      {
+        next = fail_next;
+      }
+      else
+      {
+        fail[next] = fail_next;
+        queue.push_back(next);
+      }
+    }
+  }
+}
+
+bool
+MultiReplacer::FindNext(const char* data, size_t length, size_t pos,
+                        bool at_end, Match* match, size_t* safe_end) const
+{
+  bool found = false;
+  size_t state = 0;
+  for (size_t i = pos; i < length; ++i)
+  {
+    state = NextState(state, static_cast<unsigned char>(data[i]));
+
+    // The longest needle ending here is also the one starting first.
+    const size_t pattern = match_[state];
+    if (pattern != kNoPattern)
+    {
+      const size_t end = i + 1;
+      const size_t begin = end - patterns_[pattern].first.length();
+      if (!found || begin < match->begin ||
+          (begin == match->begin && end > match->end))
+      {
+        match->begin = begin;
+        match->end = end;
+        match->pattern = pattern;
+        found = true;
+      }
+    }
+
+    // Any match still to come starts where the current state's text starts;
+    // once that is past the best match, nothing can beat it any more.
+    if (found && i + 1 - depth_[state] > match->begin)
+      return true;
+  }
+
+  if (found && at_end)
+    return true;
+  *safe_end = at_end ? length : length - depth_[state];
+  return false;
+}
+
+size_t
+MultiReplacer::ReplaceInto(const char* data, size_t length, bool at_end,
+                           std::string* output, size_t* consumed) const
+{
+  size_t replaced = 0;
+  size_t pos = 0;
+  Match match;
+  size_t safe_end = 0;
+  while (FindNext(data, length, pos, at_end, &match, &safe_end))
+  {
+    output->append(data + pos, match.begin - pos);
+    output->append(patterns_[match.pattern].second);
+    pos = match.end;
+    ++replaced;
+  }
+  output->append(data + pos, safe_end - pos);
+  *consumed = safe_end;
+  return replaced;
+}
+
+size_t
+MultiReplacer::Replace(const std::string& input, std::string* output) const
+{
+  std::string result;
+  result.reserve(input.length());
+  size_t consumed = 0;
+  const size_t replaced =
+      ReplaceInto(input.data(), input.length(), true, &result, &consumed);
+  output->swap(result);
+  return replaced;
+}
+
+MultiReplacer::Stream::Stream(const MultiReplacer* replacer)
+    : replacer_(replacer)
+{
+}
+
+size_t
+MultiReplacer::Stream::Append(const char* data, size_t length,
+                              std::string* output)
+{
+  size_t consumed = 0;
+  size_t replaced = 0;
+  if (pending_.empty())
+  {
+    // Common case: scan the caller's chunk directly and keep only its tail.
+    replaced = replacer_->ReplaceInto(data, length, false, output, &consumed);
+    pending_.assign(data + consumed, length - consumed);
+  }
+  else
+  {
+    pending_.append(data, length);
+    replaced = replacer_->ReplaceInto(pending_.data(), pending_.length(),
+                                      false, output, &consumed);
+    pending_.erase(0, consumed);
+  }
+  return replaced;
+}
+
+size_t
+MultiReplacer::Stream::Append(const std::string& data, std::string* output)
+{
+  return Append(data.data(), data.length(), output);
+}
+
+size_t
+MultiReplacer::Stream::Finish(std::string* output)
+{
+  size_t consumed = 0;
+  const size_t replaced = replacer_->ReplaceInto(
+      pending_.data(), pending_.length(), true, output, &consumed);
+  pending_.clear();
+  return replaced;
+}
+
+  
+// ------------------------------------------------------------
+// --------------------- Update End -------------------------
+// ------------------------------------------------------------
+
+  
+// ------------------------------------------------------------
+// --------------------- Select Begin -------------------------
+// ------------------------------------------------------------
+
+
+bool
+ContainsOnlyWhitespaceASCII(const StringPiece& str)
+{
+  for (StringPiece::const_iterator i(str.begin()); i != str.end(); ++i)
+  {
+    if (!IsAsciiWhitespace(*i))
+      return false;
+  }
+  return true;
+}
+
+bool
+ContainsOnlyChars(const StringPiece& input,
+                  const StringPiece& characters)
+{
+  return ContainsOnlyChars(input, CharSet(characters));
+}
+
+bool
+ContainsOnlyChars(const StringPiece& input, const CharSet& characters)
+{
+  return characters.FindFirstNotOf(input) == StringPiece::npos;
+}
+
+static inline bool DoLowerCaseEqualsASCII(const char* a_begin,
+                                          const char* a_end,
+                                          const char* b)
+{
+  // |b| must end exactly where |a| does; strnlen() does not read past that.
+  const size_t length = a_end - a_begin;
+  if (strnlen(b, length + 1) != length)
+    return false;
+  return EqualsCaseFoldedASCII(a_begin, b, length, false);
+}
+
+// Front-ends for LowerCaseEqualsASCII.
+bool
+LowerCaseEqualsASCII(const StringPiece& a, const char* b)
+{
+  return DoLowerCaseEqualsASCII(a.data(), a.data() + a.size(), b);
+}
+
+bool
+LowerCaseEqualsASCII(std::string::const_iterator a_begin,
+                     std::string::const_iterator a_end,
+                     const char* b)
+{
+  if (a_begin == a_end)
+    return *b == 0;
+  return DoLowerCaseEqualsASCII(&*a_begin, &*a_begin + (a_end - a_begin), b);
+}
+
+// TODO(port): Resolve wchar_t/iterator issues that require OS_ANDROID here.
+bool
+LowerCaseEqualsASCII(const char* a_begin,
+                     const char* a_end,
+                     const char* b)
+{
+  return DoLowerCaseEqualsASCII(a_begin, a_end, b);
+}
+
+bool
+EqualsCaseInsensitiveASCII(const StringPiece& a, const StringPiece& b)
+{
+  if (a.length() != b.length())
+    return false;
+  return EqualsCaseFoldedASCII(a.data(), b.data(), a.length(), true);
+}
+
+bool
+StartsWithASCII(const StringPiece& str,
+                const StringPiece& search,
+                bool case_sensitive)
+{
+  if (case_sensitive)
+    return str.starts_with(search);
+  if (search.length() > str.length())
+    return false;
+  return EqualsCaseFoldedASCII(str.data(), search.data(), search.length(),
+                               true);
+}
+
+// Compares |length| chars of |a| and |b| ignoring case.
+template <typename Char>
+static inline bool EqualsIgnoringCase(const Char* a, const Char* b,
+                                      size_t length)
+{
+  return std::equal(a, a + length, b, CaseInsensitiveCompare<Char>());
+}
+
+static inline bool EqualsIgnoringCase(const char* a, const char* b,
+                                      size_t length)
+{
+  return EqualsCaseFoldedASCII(a, b, length, true);
+}
+
+template <typename STR>
+bool EndsWithT(const STR& str, const STR& search, bool case_sensitive)
+{
+  typename STR::size_type str_length = str.length();
+  typename STR::size_type search_length = search.length();
+  if (search_length > str_length)
+    return false;
+  if (case_sensitive)
+  {
+    return std::equal(search.begin(), search.end(),
+                      str.begin() + (str_length - search_length));
+  }
+  else
+  {
+    return EqualsIgnoringCase(str.data() + (str_length - search_length),
+                              search.data(), search_length);
+  }
+}
+
+bool
+EndsWith(const StringPiece& str,
+         const StringPiece& search,
+         bool case_sensitive)
+{
+  return EndsWithT(str, search, case_sensitive);
+}
+
+// Substring search.  Candidates are found by comparing the first and the last
+// byte of |search| against a whole block of positions at once; only the few
+// positions where both match are compared in full.  With |fold|, letters are
+// compared with their 0x20 bit set, which matches both cases.
+typedef StringSearcher::Filter SearchFilter;
+
+static void InitSearchFilter(char c, bool fold, char* value, char* mask)
+{
+  *mask = (fold && IsAsciiAlpha(c)) ? 0x20 : 0;
+  *value = c | *mask;
+}
+
+StringSearcher::Filter::Filter(const char* search, size_t search_length,
+                               bool fold, bool fold_search)
+    : fold(fold),
+      fold_search(fold_search)
+{
+  InitSearchFilter(search[0], fold, &first_value, &first_mask);
+  InitSearchFilter(search[search_length - 1], fold, &last_value, &last_mask);
+}
+
+static inline bool SearchMatchesAt(const char* text, const char* search,
+                                   size_t search_length,
+                                   const SearchFilter& filter)
+{
+  return filter.fold ?
+      EqualsCaseFoldedASCII(text, search, search_length, filter.fold_search) :
+      memcmp(text, search, search_length) == 0;
+}
+
+#if defined(HAVE_TARGET_ATTRIBUTE)
+// Bit i is set when position i of the 32-byte block at |text| passes the
+// first/last byte filter.
+TARGET_AVX2
+static inline uint32 CandidatesAVX2(const char* text, size_t search_length,
+                                    __m256i first_value, __m256i first_mask,
+                                    __m256i last_value, __m256i last_mask)
+{
+  const __m256i first = _mm256_or_si256(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text)),
+      first_mask);
+  const __m256i last = _mm256_or_si256(
+      _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(text + search_length - 1)),
+      last_mask);
+  return static_cast<uint32>(_mm256_movemask_epi8(
+      _mm256_and_si256(_mm256_cmpeq_epi8(first, first_value),
+                       _mm256_cmpeq_epi8(last, last_value))));
+}
 
-    if (temp_input.end() != it)
+// Calls |found(i)| for each position i from |*pos| on where |search| starts,
+// left to right, skipping the ones that overlap the match before, which ends
+// at |*next|.  Returns true once |found| returns false; otherwise |*pos| is
+// where the caller has to carry on with smaller blocks.
+template <typename FOUND>
+TARGET_AVX2
+static bool ForEachFilteredAVX2(const char* text, size_t length,
+                                const char* search, size_t search_length,
+                                const SearchFilter& filter, size_t* pos,
+                                size_t* next, FOUND& found)
+{
+  const __m256i first_value = _mm256_set1_epi8(filter.first_value);
+  const __m256i first_mask = _mm256_set1_epi8(filter.first_mask);
+  const __m256i last_value = _mm256_set1_epi8(filter.last_value);
+  const __m256i last_mask = _mm256_set1_epi8(filter.last_mask);
+
+  // Two blocks per iteration; candidates are rare, so the common case is a
+  // single test of both masks.
+  size_t i = *pos;
+  for (; i + search_length - 1 + 64 <= length; i += 64)
+  {
+    const uint64 mask =
+        CandidatesAVX2(text + i, search_length, first_value, first_mask,
+                       last_value, last_mask) |
+        (static_cast<uint64>(
+            CandidatesAVX2(text + i + 32, search_length, first_value,
+                           first_mask, last_value, last_mask)) << 32);
+    for (uint64 m = mask; m != 0; m &= m - 1)
     {
-      // e.g. @_input="i love dog"
-      return false;
+      const size_t candidate = i + __builtin_ctzll(m);
+      if (candidate >= *next &&
+          SearchMatchesAt(text + candidate, search, search_length, filter))
+      {
+        *next = candidate + search_length;
+        if (!found(candidate))
+          return true;
+      }
     }
-    else
+  }
+  for (; i + search_length - 1 + 32 <= length; i += 32)
+  {
+    for (uint32 m = CandidatesAVX2(text + i, search_length, first_value,
+                                   first_mask, last_value, last_mask);
+         m != 0; m &= m - 1)
     {
-      std::string::iterator it = temp_input.begin() + 2;
-      while (it < temp_input.end())
+      const size_t candidate = i + __builtin_ctz(m);
+      if (candidate >= *next &&
+          SearchMatchesAt(text + candidate, search, search_length, filter))
       {
-        it = temp_input.insert(it, ' ');
-        it += 3;
+        *next = candidate + search_length;
+        if (!found(candidate))
+          return true;
       }
-      _input = temp_input;
-      return true;
     }
   }
+  *pos = i;
+  return false;
 }
-
-void
-Reverse(std::string _input, std::string *_output, const size_t _step)
+#endif
+
+// Calls |found(i)| for each non-overlapping match of |search| in |text| from
+// |pos| on, left to right, until it returns false.
+template <typename FOUND>
+static void ForEachFiltered(const char* text, size_t length,
+                            const char* search, size_t search_length,
+                            size_t pos, const SearchFilter& filter,
+                            FOUND found)
 {
-  if (_step < _input.length())
+  size_t next = pos;
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasAVX2() &&
+      ForEachFilteredAVX2(text, length, search, search_length, filter, &pos,
+                          &next, found))
+    return;
+#endif
+#if defined(__SSE2__)
+  const __m128i first_value = _mm_set1_epi8(filter.first_value);
+  const __m128i first_mask = _mm_set1_epi8(filter.first_mask);
+  const __m128i last_value = _mm_set1_epi8(filter.last_value);
+  const __m128i last_mask = _mm_set1_epi8(filter.last_mask);
+  for (; pos + search_length - 1 + 16 <= length; pos += 16)
   {
-    const int last_pos = _input.length() - _input.length()%_step;
-    const std::string last = _input.substr(last_pos);
-    _input = _input.substr(0, last_pos);
-    for (int i = 0; i < _input.length() / 2; i += _step)
+    const __m128i first = _mm_or_si128(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos)),
+        first_mask);
+    const __m128i last = _mm_or_si128(
+        _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(text + pos + search_length - 1)),
+        last_mask);
+    unsigned int mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(first, first_value),
+                      _mm_cmpeq_epi8(last, last_value)));
+    for (; mask != 0; mask &= mask - 1)
     {
-      const std::string temp = _input.substr(i, _step);
-      _input.replace(i , _step,
-                     _input.substr(_input.length() - (i + _step), _step));
-      _input.replace(_input.length() - (i + _step), _step,
-                     temp);
+      const size_t candidate = pos + __builtin_ctz(mask);
+      if (candidate >= next &&
+          SearchMatchesAt(text + candidate, search, search_length, filter))
+      {
+        next = candidate + search_length;
+        if (!found(candidate))
+          return;
+      }
     }
-    _input = last + _input;
   }
-  *_output = _input;
-}
-
-bool
-IpToHexString(const std::string &_ip, std::string *_hex_string)
-{
-  if (IsIp(_ip))
+#endif
+  for (pos = std::max(pos, next); pos + search_length <= length; ++pos)
   {
-    // @_ip = XXX.XXX.XXX.XXX
-    std::vector<std::string> ip_vec;
-    SplitStringUsingSubstr(_ip, ".", &ip_vec);
-
-    *_hex_string = "";
-    for (int i = 0; i < 4; ++i)
+    if ((text[pos] | filter.first_mask) == filter.first_value &&
+        (text[pos + search_length - 1] | filter.last_mask) ==
+        filter.last_value &&
+        SearchMatchesAt(text + pos, search, search_length, filter))
     {
-      unsigned int temp_uint = 0;
-      if (!StringToUint(ip_vec[i], &temp_uint))
-        return false;
-      std::string temp_str = "";
-      UintToHexString(temp_uint, &temp_str);
-      *_hex_string += temp_str;
+      if (!found(pos))
+        return;
+      pos += search_length - 1;
     }
-    FormatHexString(*_hex_string);
-    
-    return true;
   }
-  return false;
 }
 
-bool
-HexStringToIp(std::string _hex_string, std::string *_ip)
+static size_t FindFiltered(const char* text, size_t length,
+                           const char* search, size_t search_length,
+                           size_t pos, const SearchFilter& filter)
 {
-  if (IsIp(_hex_string))
-  {
-    ReplaceChars(_hex_string, " ","", &_hex_string);
+  size_t result = StringPiece::npos;
+  ForEachFiltered(text, length, search, search_length, pos, filter,
+                  [&result](size_t i) {
+                    result = i;
+                    return false;
+                  });
+  return result;
+}
 
-    *_ip = "";
-    for (int i = 0; i < _hex_string.length() - 1; i += 2)
-    {
-      unsigned int temp_uint = 0;
-      if (!HexStringToInt(_hex_string.substr(i, 2), (int*)&temp_uint))
-        return false;
-      *_ip += ToString(temp_uint) + ".";
-    }
-    *_ip = (*_ip).substr(0, (*_ip).length() - 1);
-    
-    return true;
-  }
+static size_t DoFind(const StringPiece& text, const StringPiece& search,
+                     size_t pos, bool case_sensitive)
+{
+  if (pos > text.length() || search.length() > text.length() - pos)
+    return StringPiece::npos;
+  if (search.empty())
+    return pos;
+  if (case_sensitive && search.length() == 1)
+    return text.find(search[0], pos);
+  return FindFiltered(text.data(), text.length(), search.data(),
+                      search.length(), pos,
+                      SearchFilter(search.data(), search.length(),
+                                   !case_sensitive, true));
+}
 
-  return false;
+size_t
+Find(const StringPiece& text,
+     const StringPiece& search,
+     size_t pos,
+     bool case_sensitive)
+{
+  return DoFind(text, search, pos, case_sensitive);
 }
 
+bool
+Contains(const StringPiece& text,
+         const StringPiece& search,
+         bool case_sensitive)
+{
+  return DoFind(text, search, 0, case_sensitive) != StringPiece::npos;
+}
 
-  
-// ------------------------------------------------------------
-// --------------------- Update End -------------------------
-// ------------------------------------------------------------
+size_t
+FindAll(const StringPiece& text,
+        const StringPiece& search,
+        bool case_sensitive,
+        std::vector<size_t>* positions)
+{
+  positions->clear();
+  if (search.empty())
+    return 0;
+
+  ForEachFiltered(text.data(), text.length(), search.data(), search.length(),
+                  0, SearchFilter(search.data(), search.length(),
+                                  !case_sensitive, true),
+                  [positions](size_t i) {
+                    positions->push_back(i);
+                    return true;
+                  });
+  return positions->size();
+}
 
-  
-// ------------------------------------------------------------
-// --------------------- Select Begin -------------------------
-// ------------------------------------------------------------
+StringSearcher::StringSearcher(const StringPiece& search, bool case_sensitive)
+    : search_(search.as_string()),
+      case_sensitive_(case_sensitive)
+{
+  if (!case_sensitive_)
+    StringToLowerASCII(&search_);
+  if (!search_.empty())
+    filter_ = Filter(search_.data(), search_.size(), !case_sensitive_, false);
+}
 
+size_t
+StringSearcher::Find(const StringPiece& text, size_t pos) const
+{
+  if (pos > text.length() || search_.length() > text.length() - pos)
+    return StringPiece::npos;
+  if (search_.empty())
+    return pos;
+  if (case_sensitive_ && search_.length() == 1)
+    return text.find(search_[0], pos);
+  // |search_| is lower-cased already, so only the text is folded.
+  return FindFiltered(text.data(), text.length(), search_.data(),
+                      search_.length(), pos, filter_);
+}
 
 bool
-ContainsOnlyWhitespaceASCII(const std::string& str)
+StringSearcher::Contains(const StringPiece& text) const
 {
-  for (std::string::const_iterator i(str.begin()); i != str.end(); ++i)
-  {
-    if (!IsAsciiWhitespace(*i))
-      return false;
-  }
-  return true;
+  return Find(text, 0) != StringPiece::npos;
 }
 
-template<typename STR>
-static bool ContainsOnlyCharsT(const STR& input, const STR& characters)
+size_t
+StringSearcher::FindAll(const StringPiece& text,
+                        std::vector<size_t>* positions) const
 {
-  for (typename STR::const_iterator iter = input.begin();
-       iter != input.end(); ++iter)
-  {
-    if (characters.find(*iter) == STR::npos)
-      return false;
-  }
-  return true;
+  positions->clear();
+  if (search_.empty())
+    return 0;
+
+  ForEachFiltered(text.data(), text.length(), search_.data(),
+                  search_.length(), 0, filter_,
+                  [positions](size_t i) {
+                    positions->push_back(i);
+                    return true;
+                  });
+  return positions->size();
 }
 
-bool
-ContainsOnlyChars(const std::string& input,
-                  const std::string& characters)
+size_t
+StringSearcher::FindAll(const StringPiece& text,
+                        size_t pos,
+                        size_t* offsets,
+                        size_t max_count) const
 {
-  return ContainsOnlyCharsT(input, characters);
+  if (search_.empty() || max_count == 0 || pos > text.length())
+    return 0;
+
+  size_t count = 0;
+  ForEachFiltered(text.data(), text.length(), search_.data(),
+                  search_.length(), pos, filter_,
+                  [offsets, max_count, &count](size_t i) {
+                    offsets[count++] = i;
+                    return count != max_count;
+                  });
+  return count;
 }
 
-template<typename Iter>
-static inline bool DoLowerCaseEqualsASCII(Iter a_begin,
-                                          Iter a_end,
-                                          const char* b)
+// Myers' bit-parallel edit distance, in the blocked form of Hyyro: the
+// pattern is cut into blocks of 64 rows, and each column of the distance
+// matrix D is computed as bit vectors of the vertical deltas
+// D[i][j] - D[i - 1][j], set in Pv where they are +1 and in Mv where they
+// are -1.
+class EditDistancePattern
 {
-  for (Iter it = a_begin; it != a_end; ++it, ++b)
+ public:
+  explicit EditDistancePattern(const StringPiece& pattern)
+      : length_(pattern.length()),
+        blocks_((pattern.length() + 63) / 64),
+        peq_(256 * blocks_, 0)
   {
-    if (!*b || ToLowerASCII(*it) != *b)
-      return false;
+    // Bit i of peq_[c * blocks_ + b] is set when row 64 * b + i of the
+    // pattern is c.
+    for (size_t i = 0; i < length_; ++i)
+    {
+      const unsigned char c = static_cast<unsigned char>(pattern[i]);
+      peq_[c * blocks_ + i / 64] |= GG_UINT64_C(1) << (i % 64);
+    }
   }
-  return *b == 0;
-}
 
-// Front-ends for LowerCaseEqualsASCII.
-bool
-LowerCaseEqualsASCII(const std::string& a, const char* b)
+  // Returns the distance from |text|, or |max_distance| + 1 if it is larger.
+  size_t Distance(const StringPiece& text, size_t max_distance) const;
+
+ private:
+  // Computes the next column of one block.  |hin| is the horizontal delta
+  // D[i][j] - D[i][j - 1] entering at the top of the block; returns the one
+  // leaving at the row of |out_bit|.
+  static inline int AdvanceBlock(uint64 eq, int hin, uint64 out_bit,
+                                 uint64* pv, uint64* mv)
+  {
+    const uint64 xv = eq | *mv;
+    if (hin < 0)
+      eq |= 1;
+    const uint64 xh = (((eq & *pv) + *pv) ^ *pv) | eq;
+    uint64 ph = *mv | ~(xh | *pv);
+    uint64 mh = *pv & xh;
+    const int hout = (ph & out_bit) ? 1 : ((mh & out_bit) ? -1 : 0);
+    ph <<= 1;
+    mh <<= 1;
+    if (hin < 0)
+      mh |= 1;
+    else if (hin > 0)
+      ph |= 1;
+    *pv = mh | ~(xv | ph);
+    *mv = ph & xv;
+    return hout;
+  }
+
+  size_t length_;
+  size_t blocks_;
+  std::vector<uint64> peq_;
+};
+
+size_t
+EditDistancePattern::Distance(const StringPiece& text,
+                              size_t max_distance) const
 {
-  return DoLowerCaseEqualsASCII(a.begin(), a.end(), b);
+  const size_t n = text.length();
+  const size_t length_difference = (n > length_) ? n - length_ : length_ - n;
+  if (length_difference > max_distance)
+    return max_distance + 1;
+  if (length_ == 0)
+    return n;
+
+  // D[0][j] = j, so +1 enters the top block at every column.  The score is
+  // D[length_][j], followed through the last row of the last block.
+  const uint64 last_row = GG_UINT64_C(1) << ((length_ - 1) % 64);
+  const uint64 block_end = GG_UINT64_C(1) << 63;
+  size_t score = length_;
+
+  uint64 single_pv = ~GG_UINT64_C(0);
+  uint64 single_mv = 0;
+  std::vector<uint64> pv;
+  std::vector<uint64> mv;
+  if (blocks_ > 1)
+  {
+    pv.assign(blocks_, ~GG_UINT64_C(0));
+    mv.assign(blocks_, 0);
+  }
+
+  for (size_t j = 0; j < n; ++j)
+  {
+    const uint64* eq =
+        &peq_[static_cast<unsigned char>(text[j]) * blocks_];
+    int hout;
+    if (blocks_ == 1)
+    {
+      hout = AdvanceBlock(eq[0], 1, last_row, &single_pv, &single_mv);
+    }
+    else
+    {
+      hout = 1;
+      for (size_t b = 0; b + 1 < blocks_; ++b)
+        hout = AdvanceBlock(eq[b], hout, block_end, &pv[b], &mv[b]);
+      hout = AdvanceBlock(eq[blocks_ - 1], hout, last_row,
+                          &pv[blocks_ - 1], &mv[blocks_ - 1]);
+    }
+    score += hout;
+
+    // Each of the remaining columns can lower the score by one at most.
+    const size_t remaining = n - j - 1;
+    if (score > remaining && score - remaining > max_distance)
+      return max_distance + 1;
+  }
+  return (score <= max_distance) ? score : max_distance + 1;
 }
 
-bool
-LowerCaseEqualsASCII(std::string::const_iterator a_begin,
-                     std::string::const_iterator a_end,
-                     const char* b)
+size_t
+EditDistance(const StringPiece& a, const StringPiece& b)
 {
-  return DoLowerCaseEqualsASCII(a_begin, a_end, b);
+  return BoundedEditDistance(a, b, static_cast<size_t>(-1) - 1);
 }
 
-// TODO(port): Resolve wchar_t/iterator issues that require OS_ANDROID here.
-bool
-LowerCaseEqualsASCII(const char* a_begin,
-                     const char* a_end,
-                     const char* b)
+size_t
+BoundedEditDistance(const StringPiece& a,
+                    const StringPiece& b,
+                    size_t max_distance)
 {
-  return DoLowerCaseEqualsASCII(a_begin, a_end, b);
+  // The shorter string is the pattern: fewer blocks per column.
+  if (a.length() < b.length())
+    return EditDistancePattern(a).Distance(b, max_distance);
+  return EditDistancePattern(b).Distance(a, max_distance);
 }
 
-bool
-StartsWithASCII(const std::string& str,
-                const std::string& search,
-                bool case_sensitive)
+static void FindWithinEditDistanceRange(
+    const EditDistancePattern* pattern,
+    const std::vector<std::string>* candidates,
+    size_t begin,
+    size_t end,
+    size_t max_distance,
+    std::vector<size_t>* matches)
 {
-  if (case_sensitive)
-    return str.compare(0, search.length(), search) == 0;
-  else
-    return strncasecmp(str.c_str(), search.c_str(), search.length()) == 0;
+  for (size_t i = begin; i < end; ++i)
+  {
+    if (pattern->Distance((*candidates)[i], max_distance) <= max_distance)
+      matches->push_back(i);
+  }
 }
 
-template <typename STR>
-bool EndsWithT(const STR& str, const STR& search, bool case_sensitive)
+size_t
+FindWithinEditDistance(const StringPiece& query,
+                       const std::vector<std::string>& candidates,
+                       size_t max_distance,
+                       std::vector<size_t>* matches,
+                       size_t num_threads)
 {
-  typename STR::size_type str_length = str.length();
-  typename STR::size_type search_length = search.length();
-  if (search_length > str_length)
-    return false;
-  if (case_sensitive)
+  // Below this many candidates per thread, starting threads costs more than
+  // it saves.
+  static const size_t kMinCandidatesPerThread = 1024;
+
+  matches->clear();
+  const EditDistancePattern pattern(query);
+
+  if (num_threads == 0)
+    num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  num_threads = std::min(num_threads,
+                         candidates.size() / kMinCandidatesPerThread);
+  if (num_threads <= 1)
   {
-    return str.compare(str_length - search_length, search_length, search) == 0;
+    FindWithinEditDistanceRange(&pattern, &candidates, 0, candidates.size(),
+                                max_distance, matches);
+    return matches->size();
   }
-  else
+
+  // Contiguous slices, so that concatenating the results keeps them sorted.
+  std::vector<std::vector<size_t> > slice_matches(num_threads);
+  // Reserved, so that adding a started thread cannot throw.
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
   {
-    return std::equal(search.begin(), search.end(),
-                      str.begin() + (str_length - search_length),
-                      CaseInsensitiveCompare<typename STR::value_type>());
+    const ThreadJoiner joiner(&threads);
+    const size_t slice = (candidates.size() + num_threads - 1) / num_threads;
+    for (size_t t = 0; t < num_threads; ++t)
+    {
+      const size_t begin = std::min(t * slice, candidates.size());
+      const size_t end = std::min(begin + slice, candidates.size());
+      threads.push_back(std::thread(FindWithinEditDistanceRange, &pattern,
+                                    &candidates, begin, end, max_distance,
+                                    &slice_matches[t]));
+    }
   }
+  for (size_t t = 0; t < num_threads; ++t)
+  {
+    matches->insert(matches->end(), slice_matches[t].begin(),
+                    slice_matches[t].end());
+  }
+  return matches->size();
 }
 
-bool
-EndsWith(const std::string& str,
-         const std::string& search,
-         bool case_sensitive)
-{
-  return EndsWithT(str, search, case_sensitive);
-}
-
-template<typename STR>
-static size_t TokenizeT(const STR& str,
-                        const STR& delimiters,
+// The core of Tokenize(), for tokens of type STR.
+template <typename STR>
+static size_t TokenizeT(const StringPiece& str,
+                        const CharSet& delimiters,
                         std::vector<STR>* tokens)
 {
   tokens->clear();
 
-  typename STR::size_type start = str.find_first_not_of(delimiters);
-  while (start != STR::npos)
+  // The delimiters are looked up in batches; a token is any non-empty run
+  // between two of them.
+  static const size_t kBatch = 128;
+  size_t offsets[kBatch];
+  size_t start = 0;
+  for (;;)
   {
-    typename STR::size_type end = str.find_first_of(delimiters, start + 1);
-    if (end == STR::npos)
-    {
-      tokens->push_back(str.substr(start));
-      break;
-    }
-    else
+    const size_t count = delimiters.FindAllOf(str, start, offsets, kBatch);
+    for (size_t i = 0; i < count; ++i)
     {
-      tokens->push_back(str.substr(start, end - start));
-      start = str.find_first_not_of(delimiters, end + 1);
+      if (offsets[i] != start)
+        tokens->push_back(STR(str.data() + start, offsets[i] - start));
+      start = offsets[i] + 1;
     }
+    if (count != kBatch)
+      break;
   }
+  if (start < str.length())
+    tokens->push_back(STR(str.data() + start, str.length() - start));
 
   return tokens->size();
 }
 
 size_t
-Tokenize(const std::string& str,
-         const std::string& delimiters,
+Tokenize(const StringPiece& str,
+         const CharSet& delimiters,
          std::vector<std::string>* tokens)
 {
   return TokenizeT(str, delimiters, tokens);
 }
 
+size_t
+Tokenize(const StringPiece& str,
+         const StringPiece& delimiters,
+         std::vector<std::string>* tokens)
+{
+  return Tokenize(str, CharSet(delimiters), tokens);
+}
 
-template<typename STR>
-static STR JoinStringT(const std::vector<STR>& parts,
-                       typename STR::value_type sep)
+size_t
+Tokenize(const StringPiece& str,
+         const CharSet& delimiters,
+         std::vector<StringPiece>* tokens)
 {
-  if (parts.empty())
-    return STR();
+  return TokenizeT(str, delimiters, tokens);
+}
 
-  STR result(parts[0]);
-  typename std::vector<STR>::const_iterator iter = parts.begin();
-  ++iter;
+size_t
+Tokenize(const StringPiece& str,
+         const StringPiece& delimiters,
+         std::vector<StringPiece>* tokens)
+{
+  return TokenizeT(str, CharSet(delimiters), tokens);
+}
 
-  for (; iter != parts.end(); ++iter)
-  {
-    result += sep;
-    result += *iter;
-  }
 
-  return result;
+std::string
+JoinString(const std::vector<std::string>& parts, char sep)
+{
+  return JoinString(parts.begin(), parts.end(), StringPiece(&sep, 1));
 }
 
 std::string
-JoinString(const std::vector<std::string>& parts, char sep)
+JoinString(const std::vector<std::string>& parts,
+           const StringPiece& separator)
+{
+  return JoinString(parts.begin(), parts.end(), separator);
+}
+
+std::string
+JoinString(const std::vector<StringPiece>& parts,
+           const StringPiece& separator)
 {
-  return JoinStringT(parts, sep);
+  return JoinString(parts.begin(), parts.end(), separator);
 }
 
 
@@ -672,39 +2811,338 @@ static bool MatchPatternT(const CHAR* eval, const CHAR* eval_end,
   return false;
 }
 
+struct NextCharASCII
+{
+  base_icu::UChar32 operator()(const char** p, const char* /* end */)
+  {
+    return static_cast<unsigned char>(*(*p)++);
+  }
+};
+
+// Byte classes for the UTF-8 decoder below: for every lead byte, the number of
+// bytes in the sequence and the range the second byte must fall into so that
+// overlong forms, surrogates and code points above 0x10FFFF are rejected up
+// front (see Table 3-7 of the Unicode standard).  A length of 0 marks a byte
+// that can not start a well-formed sequence.
+struct UTF8LeadByte
+{
+  unsigned char length;
+  unsigned char second_min;
+  unsigned char second_max;
+};
+
+struct UTF8LeadByteTable
+{
+  UTF8LeadByteTable()
+  {
+    for (int c = 0; c < 256; ++c)
+    {
+      UTF8LeadByte& entry = entries[c];
+      entry.length = 0;
+      entry.second_min = 0x80;
+      entry.second_max = 0xBF;
+
+      if (c < 0x80)
+        entry.length = 1;
+      else if (c >= 0xC2 && c <= 0xDF)
+        entry.length = 2;
+      else if (c >= 0xE0 && c <= 0xEF)
+        entry.length = 3;
+      else if (c >= 0xF0 && c <= 0xF4)
+        entry.length = 4;
+
+      if (c == 0xE0)
+        entry.second_min = 0xA0;
+      else if (c == 0xED)
+        entry.second_max = 0x9F;
+      else if (c == 0xF0)
+        entry.second_min = 0x90;
+      else if (c == 0xF4)
+        entry.second_max = 0x8F;
+    }
+  }
+
+  UTF8LeadByte entries[256];
+};
+
+static const UTF8LeadByte* GetUTF8LeadByteTable()
+{
+  static const UTF8LeadByteTable table;
+  return table.entries;
+}
+
 struct NextCharUTF8
 {
+  NextCharUTF8() : table_(GetUTF8LeadByteTable()) {}
+
   base_icu::UChar32 operator()(const char** p, const char* end)
   {
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(*p);
+    const UTF8LeadByte& lead = table_[s[0]];
+    const ptrdiff_t length = lead.length;
+
+    // Decode well-formed sequences straight from the table; anything
+    // malformed or truncated goes through CBU8_NEXT so that error handling
+    // (how many bytes an invalid sequence swallows) stays identical.
+    if (length != 0 && length <= end - *p &&
+        (length == 1 || (s[1] >= lead.second_min && s[1] <= lead.second_max)))
+    {
+      base_icu::UChar32 c;
+      switch (length)
+      {
+        case 1:
+          *p += 1;
+          return s[0];
+        case 2:
+          *p += 2;
+          return ((s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+        case 3:
+          if ((s[2] & 0xC0) != 0x80)
+            break;
+          *p += 3;
+          return ((s[0] & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+        case 4:
+          if ((s[2] & 0xC0) != 0x80 || (s[3] & 0xC0) != 0x80)
+            break;
+          c = ((s[0] & 0x07) << 18) | ((s[1] & 0x3F) << 12) |
+              ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+          *p += 4;
+          return c;
+      }
+    }
+
     base_icu::UChar32 c;
     int offset = 0;
     CBU8_NEXT(*p, offset, end - *p, c);
     *p += offset;
     return c;
   }
+
+ private:
+  const UTF8LeadByte* table_;
 };
 
+template<typename Char>
+static inline bool DoIsStringASCII(const Char* characters, size_t length)
+{
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(characters);
+  const unsigned char* end = p + length;
+  unsigned char all_bits = 0;
+
+#if defined(__SSE2__)
+  __m128i all_chunks = _mm_setzero_si128();
+  for (; end - p >= 16; p += 16)
+  {
+    all_chunks = _mm_or_si128(
+        all_chunks, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+  }
+  if (_mm_movemask_epi8(all_chunks) != 0)
+    return false;
+#endif
+
+  for (; p != end; ++p)
+    all_bits |= *p;
+  return (all_bits & 0x80) == 0;
+}
+
+bool
+IsStringASCII(const StringPiece& str)
+{
+  return DoIsStringASCII(str.data(), str.length());
+}
+
 bool
-MatchPattern(const std::string& eval,
-             const std::string& pattern)
+MatchPattern(const StringPiece& eval,
+             const StringPiece& pattern)
 {
+  // Pure ASCII input can be matched byte by byte; only fall back to decoding
+  // when either side contains a multi-byte UTF-8 sequence.
+  if (IsStringASCII(eval) && IsStringASCII(pattern))
+  {
+    return MatchPatternT(eval.data(), eval.data() + eval.size(),
+                         pattern.data(), pattern.data() + pattern.size(),
+                         0, NextCharASCII());
+  }
   return MatchPatternT(eval.data(), eval.data() + eval.size(),
                        pattern.data(), pattern.data() + pattern.size(),
                        0, NextCharUTF8());
 }
 
 bool
-IsIp(const std::string &_ip)
+IsIp(const StringPiece& _ip)
 {
+  IPAddress address;
+  return address.AssignFromIPLiteral(TrimWhitespaceASCII(_ip, TRIM_ALL));
+}
+
+// Parses "XX:XX:XX:XX:XX:XX" one char at a time.
+static bool ParseMacAddressScalar(const char* p, uint64* mac)
+{
+  const char separator = p[2];
+  if (separator != ':' && separator != '-' && separator != ' ')
+    return false;
+  uint64 result = 0;
+  for (int i = 0; i < 6; ++i, p += 3)
+  {
+    if (!IsHexDigit(p[0]) || !IsHexDigit(p[1]) ||
+        (i != 5 && p[2] != separator))
+      return false;
+    result = (result << 8) | (HexDigitToInt(p[0]) << 4) | HexDigitToInt(p[1]);
+  }
+  *mac = result;
   return true;
 }
 
-bool
-IsMac(const std::string &_mac)
+#if defined(HAVE_TARGET_ATTRIBUTE)
+// Parses the 17 chars at |p| with two overlapping 16-byte loads: |head| holds
+// chars 0 to 15, |tail| chars 1 to 16.  Every char is checked at once, then
+// PSHUFB lines the 12 digit values up in pairs and PMADDUBSW combines each
+// pair into a byte.
+TARGET_SSE42
+static inline bool ParseMacAddressSSE42(const char* p, uint64* mac)
 {
+  const __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  const __m128i tail =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+
+  const char separator = p[2];
+  if (separator != ':' && separator != '-' && separator != ' ')
+    return false;
+  const __m128i lower = _mm_or_si128(head, _mm_set1_epi8(0x20));
+  const __m128i is_digit = _mm_and_si128(
+      _mm_cmpgt_epi8(head, _mm_set1_epi8('0' - 1)),
+      _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), head));
+  const __m128i is_letter = _mm_and_si128(
+      _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+      _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), lower));
+  const unsigned int hex =
+      _mm_movemask_epi8(_mm_or_si128(is_digit, is_letter));
+  const unsigned int separators = _mm_movemask_epi8(
+      _mm_cmpeq_epi8(head, _mm_set1_epi8(separator)));
+  // Chars 0 to 15: digits everywhere but at 2, 5, 8, 11 and 14.
+  const unsigned int kSeparatorBits = 0x4924;
+  if ((hex | kSeparatorBits) != 0xFFFF ||
+      (separators & kSeparatorBits) != kSeparatorBits || !IsHexDigit(p[16]))
+    return false;
+
+  // The value of a digit is its low nibble, plus 9 for a letter.
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i low_nibbles = _mm_set1_epi8(0x0F);
+  const __m128i head_values = _mm_add_epi8(
+      _mm_and_si128(head, low_nibbles),
+      _mm_and_si128(_mm_cmpgt_epi8(head, _mm_set1_epi8('9')), nine));
+  const __m128i tail_values = _mm_add_epi8(
+      _mm_and_si128(tail, low_nibbles),
+      _mm_and_si128(_mm_cmpgt_epi8(tail, _mm_set1_epi8('9')), nine));
+  const __m128i pairs = _mm_or_si128(
+      _mm_shuffle_epi8(head_values,
+                       _mm_setr_epi8(0, 1, 3, 4, 6, 7, 9, 10, 12, 13, 15,
+                                     -1, -1, -1, -1, -1)),
+      _mm_shuffle_epi8(tail_values,
+                       _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                     -1, 15, -1, -1, -1, -1)));
+  const __m128i bytes = _mm_packus_epi16(
+      _mm_maddubs_epi16(pairs, _mm_set1_epi16(0x0110)), _mm_setzero_si128());
+  // The bytes come out in memory order, the first one lowest.  They are
+  // stored rather than moved with MOVQ, which only exists on x86_64.
+  uint64 value;
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(&value), bytes);
+  *mac = __builtin_bswap64(value) >> 16;
   return true;
 }
 
+TARGET_SSE42
+static size_t ParseMacAddressBatchSSE42(const StringPiece* texts,
+                                        size_t count, uint64* macs,
+                                        bool* valid)
+{
+  size_t parsed = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    macs[i] = 0;
+    valid[i] = texts[i].size() == kMacAddressStringLength &&
+        ParseMacAddressSSE42(texts[i].data(), &macs[i]);
+    parsed += valid[i];
+  }
+  return parsed;
+}
+#endif
+
+bool
+ParseMacAddress(const StringPiece& text, uint64* mac)
+{
+  if (text.size() != kMacAddressStringLength)
+    return false;
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasSSE42())
+    return ParseMacAddressSSE42(text.data(), mac);
+#endif
+  return ParseMacAddressScalar(text.data(), mac);
+}
+
+size_t
+ParseMacAddressBatch(const StringPiece* texts, size_t count, uint64* macs,
+                     bool* valid)
+{
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  if (CPUHasSSE42())
+    return ParseMacAddressBatchSSE42(texts, count, macs, valid);
+#endif
+  size_t parsed = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    macs[i] = 0;
+    valid[i] = texts[i].size() == kMacAddressStringLength &&
+        ParseMacAddressScalar(texts[i].data(), &macs[i]);
+    parsed += valid[i];
+  }
+  return parsed;
+}
+
+void
+FormatMacAddress(uint64 mac, char separator, bool upper_case, char* out)
+{
+  const char* digits = upper_case ? "0123456789ABCDEF" : "0123456789abcdef";
+  for (int i = 0; i < 6; ++i, out += 3)
+  {
+    const unsigned int byte = (mac >> (40 - 8 * i)) & 0xFF;
+    out[0] = digits[byte >> 4];
+    out[1] = digits[byte & 0x0F];
+    if (i != 5)
+      out[2] = separator;
+  }
+}
+
+std::string
+FormatMacAddress(uint64 mac, char separator, bool upper_case)
+{
+  char buffer[kMacAddressStringLength];
+  FormatMacAddress(mac, separator, upper_case, buffer);
+  return std::string(buffer, sizeof(buffer));
+}
+
+void
+FormatMacAddressBatch(const uint64* macs, size_t count, char separator,
+                      bool upper_case, char delimiter, std::string* output)
+{
+  const size_t old_size = output->size();
+  output->resize(old_size + count * (kMacAddressStringLength + 1));
+  char* out = &(*output)[old_size];
+  for (size_t i = 0; i < count; ++i)
+  {
+    FormatMacAddress(macs[i], separator, upper_case, out);
+    out[kMacAddressStringLength] = delimiter;
+    out += kMacAddressStringLength + 1;
+  }
+}
+
+bool
+IsMac(const StringPiece& _mac)
+{
+  uint64 mac;
+  return ParseMacAddress(TrimWhitespaceASCII(_mac, TRIM_ALL), &mac);
+}
+
 bool
 IsPort(const std::string &_port)
 {
@@ -17,6 +17,7 @@
 #include "util/string_util.h"
 
 #include "util/basictypes.h"
+#include "util/cpu.h"
 
 #include "third_party/gtest/include/gtest/gtest.h"
 
@@ -82,6 +83,54 @@ TEST(StringUtilTest, ReplaceChars)
                                &output);
     EXPECT_EQ(cases[i].result, result);
     EXPECT_EQ(cases[i].output, output);
+
+    std::string in_place = cases[i].input;
+    EXPECT_EQ(cases[i].result, ReplaceChars(&in_place,
+                                            cases[i].replace_chars,
+                                            cases[i].replace_with))
+        << "cases:" << i + 1;
+    EXPECT_EQ(cases[i].output, in_place) << "cases:" << i + 1;
+  }
+}
+
+TEST(StringUtilTest, ReplaceCharsLongInput)
+{
+  // Long enough to go through the vectorized path, with sets both small and
+  // large enough to need the lookup table.
+  static const char* kReplaceChars[] = { "a", "ab", "abcd", "abcde", "\x80\xff" };
+  static const char* kReplaceWith[] = { "", "_", "<>" };
+
+  std::string input;
+  for (int i = 0; i < 100; ++i)
+    input += static_cast<char>("abcdefgh\x80\xff"[i % 10]);
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(kReplaceChars); ++i)
+  {
+    for (size_t j = 0; j < ARRAYSIZE_UNSAFE(kReplaceWith); ++j)
+    {
+      std::string expect;
+      for (size_t k = 0; k < input.length(); ++k)
+      {
+        if (strchr(kReplaceChars[i], input[k]))
+          expect += kReplaceWith[j];
+        else
+          expect += input[k];
+      }
+
+      std::string output;
+      EXPECT_TRUE(ReplaceChars(input, kReplaceChars[i], kReplaceWith[j],
+                               &output));
+      EXPECT_EQ(expect, output) << "cases:" << i << "," << j;
+
+      output = input;
+      EXPECT_TRUE(ReplaceChars(output, kReplaceChars[i], kReplaceWith[j],
+                               &output));
+      EXPECT_EQ(expect, output) << "cases:" << i << "," << j;
+
+      output = input;
+      EXPECT_TRUE(ReplaceChars(&output, kReplaceChars[i], kReplaceWith[j]));
+      EXPECT_EQ(expect, output) << "cases:" << i << "," << j;
+    }
   }
 }
 
@@ -108,6 +157,106 @@ TEST(StringUtilTest, RemoveChars)
   EXPECT_EQ("ilovedog", output);
 }
 
+TEST(StringUtilTest, RemoveCharsInPlace)
+{
+  std::string input = "A-+bc/d!*";
+  EXPECT_TRUE(RemoveChars(&input, "-/+*"));
+  EXPECT_EQ("Abcd!", input);
+
+  EXPECT_FALSE(RemoveChars(&input, "-/+*"));
+  EXPECT_EQ("Abcd!", input);
+
+  EXPECT_TRUE(RemoveChars(&input, std::string("Abcd!")));
+  EXPECT_EQ("", input);
+
+  EXPECT_FALSE(RemoveChars(&input, "-"));
+  EXPECT_EQ("", input);
+}
+
+// The rvalue overloads hand the caller's buffer on instead of copying it.
+// The inputs are too long for the short string optimization.
+TEST(StringUtilTest, RvalueOverloadsReuseBuffer)
+{
+  std::string output;
+  std::string input = "  some text that is long enough  ";
+  const char* data = input.data();
+  EXPECT_EQ(TRIM_ALL, TrimWhitespaceASCII(std::move(input), TRIM_ALL,
+                                          &output));
+  EXPECT_EQ("some text that is long enough", output);
+  EXPECT_EQ(data, output.data());
+
+  input = "\xc2\xa0 some text that is long enough\xe3\x80\x80";
+  data = input.data();
+  EXPECT_EQ(TRIM_ALL, TrimWhitespace(std::move(input), TRIM_ALL, &output));
+  EXPECT_EQ("some text that is long enough", output);
+  EXPECT_EQ(data, output.data());
+
+  input = "xxsome text that is long enoughxx";
+  data = input.data();
+  EXPECT_TRUE(TrimString(std::move(input), CharSet("x"), &output));
+  EXPECT_EQ("some text that is long enough", output);
+  EXPECT_EQ(data, output.data());
+
+  input = "some-text-that-is-long-enough";
+  data = input.data();
+  EXPECT_TRUE(RemoveChars(std::move(input), "-", &output));
+  EXPECT_EQ("sometextthatislongenough", output);
+  EXPECT_EQ(data, output.data());
+
+  input = "some-text-that-is-long-enough";
+  data = input.data();
+  EXPECT_TRUE(ReplaceChars(std::move(input), "-", " ", &output));
+  EXPECT_EQ("some text that is long enough", output);
+  EXPECT_EQ(data, output.data());
+
+  input = "some text that is long enough";
+  data = input.data();
+  Reverse(std::move(input), &output, 1);
+  EXPECT_EQ("hguone gnol si taht txet emos", output);
+  EXPECT_EQ(data, output.data());
+
+  input = "Some  Text\tThat Is Long Enough";
+  data = input.data();
+  output = StringToLowerASCII(std::move(input));
+  EXPECT_EQ("some  text\tthat is long enough", output);
+  EXPECT_EQ(data, output.data());
+
+  input = output;
+  data = input.data();
+  output = StringToUpperASCII(std::move(input));
+  EXPECT_EQ("SOME  TEXT\tTHAT IS LONG ENOUGH", output);
+  EXPECT_EQ(data, output.data());
+
+  input = output;
+  data = input.data();
+  output = CollapseWhitespaceASCII(std::move(input), false);
+  EXPECT_EQ("SOME TEXT THAT IS LONG ENOUGH", output);
+  EXPECT_EQ(data, output.data());
+
+  input = "SOME  TEXT\xc2\xa0THAT IS LONG ENOUGH";
+  data = input.data();
+  output = CollapseWhitespace(std::move(input), false);
+  EXPECT_EQ("SOME TEXT THAT IS LONG ENOUGH", output);
+  EXPECT_EQ(data, output.data());
+
+  // Moving a string into itself leaves it in place.
+  output = "  some text that is long enough  ";
+  TrimWhitespaceASCII(std::move(output), TRIM_ALL, &output);
+  EXPECT_EQ("some text that is long enough", output);
+}
+
+TEST(StringUtilTest, TrimStringInPlace)
+{
+  std::string str = "abcab";
+  EXPECT_TRUE(TrimString(&str, "ab"));
+  EXPECT_EQ("c", str);
+  EXPECT_FALSE(TrimString(&str, "ab"));
+  EXPECT_EQ("c", str);
+  EXPECT_TRUE(TrimString(&str, CharSet("c")));
+  EXPECT_EQ("", str);
+  EXPECT_FALSE(TrimString(&str, CharSet("c")));
+}
+
 static const struct trim_case_ascii
 {
   const char* input;
@@ -138,6 +287,116 @@ TEST(StringUtilTest, TrimWhitespace)
   }
 }
 
+TEST(StringUtilTest, TrimWhitespaceASCIIInPlaceAndPiece)
+{
+  for (size_t i = 0; i < arraysize(trim_cases_ascii); ++i)
+  {
+    const trim_case_ascii& value = trim_cases_ascii[i];
+
+    std::string in_place = value.input;
+    EXPECT_EQ(value.return_value,
+              TrimWhitespaceASCII(&in_place, value.positions));
+    EXPECT_EQ(value.output, in_place);
+
+    const std::string input = value.input;
+    const StringPiece piece = TrimWhitespaceASCII(input, value.positions);
+    EXPECT_EQ(value.output, piece.as_string());
+    if (!piece.empty())
+    {
+      EXPECT_GE(piece.data(), input.data());
+      EXPECT_LE(piece.data() + piece.size(), input.data() + input.size());
+    }
+  }
+
+  // Nothing to trim: the string keeps its buffer.
+  std::string untouched = "Google Video";
+  const char* data = untouched.data();
+  EXPECT_EQ(TRIM_NONE, TrimWhitespaceASCII(&untouched, TRIM_ALL));
+  EXPECT_EQ(data, untouched.data());
+}
+
+// Plain implementations of trimming and collapsing to check the vectorized
+// ones against.
+static bool IsTestWhitespace(char c)
+{
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static std::string ReferenceTrim(const std::string& input,
+                                 TrimPositions positions)
+{
+  size_t first = 0;
+  size_t last = input.length();
+  if (positions & TRIM_LEADING)
+  {
+    while (first < last && IsTestWhitespace(input[first]))
+      ++first;
+  }
+  if (positions & TRIM_TRAILING)
+  {
+    while (last > first && IsTestWhitespace(input[last - 1]))
+      --last;
+  }
+  return input.substr(first, last - first);
+}
+
+static std::string ReferenceCollapse(const std::string& input, bool trim)
+{
+  std::string result;
+  size_t i = 0;
+  while (i < input.length())
+  {
+    if (!IsTestWhitespace(input[i]))
+    {
+      result += input[i++];
+      continue;
+    }
+    bool line_break = false;
+    size_t j = i;
+    for (; j < input.length() && IsTestWhitespace(input[j]); ++j)
+      line_break = line_break || input[j] == '\n' || input[j] == '\r';
+    if (i != 0 && j != input.length() && !(trim && line_break))
+      result += ' ';
+    i = j;
+  }
+  return result;
+}
+
+TEST(StringUtilTest, WhitespaceVectorizedPaths)
+{
+  static const char kAlphabet[] = " \t\n\v\f\r\x0e\x1f!a\xa0\x85";
+
+  srand(2014);
+  ForEachCPUFeatureMask([&](int mask) {
+    for (int round = 0; round < 500; ++round)
+    {
+      // Mostly long runs of one kind so that whole blocks get skipped.
+      const std::string input = RandomString(kAlphabet, 149, 40);
+
+      for (int positions = TRIM_NONE; positions <= TRIM_ALL; ++positions)
+      {
+        const TrimPositions trim = static_cast<TrimPositions>(positions);
+        const std::string expect = ReferenceTrim(input, trim);
+        std::string output;
+        TrimWhitespaceASCII(input, trim, &output);
+        EXPECT_EQ(expect, output) << "mask:" << mask;
+        EXPECT_EQ(expect, TrimWhitespaceASCII(StringPiece(input), trim)
+                  .as_string()) << "mask:" << mask;
+      }
+
+      for (int trim = 0; trim < 2; ++trim)
+      {
+        const std::string expect = ReferenceCollapse(input, trim != 0);
+        EXPECT_EQ(expect, CollapseWhitespaceASCII(input, trim != 0))
+            << "mask:" << mask;
+        std::string in_place = input;
+        CollapseWhitespaceASCII(&in_place, trim != 0);
+        EXPECT_EQ(expect, in_place) << "mask:" << mask;
+      }
+    }
+  });
+}
+
 static const struct collapse_case_ascii
 {
   const char* input;
@@ -170,9 +429,134 @@ TEST(StringUtilTest, CollapseWhitespaceASCII)
   {
     const collapse_case_ascii& value = collapse_cases_ascii[i];
     EXPECT_EQ(value.output, CollapseWhitespaceASCII(value.input, value.trim));
+
+    std::string in_place = value.input;
+    CollapseWhitespaceASCII(&in_place, value.trim);
+    EXPECT_EQ(value.output, in_place);
   }
 }
 
+static const struct whitespace_case_utf8
+{
+  const char* input;
+  const char* trimmed;
+  const char* collapsed;
+} whitespace_cases_utf8[] = {
+  // NBSP, ideographic space, NEL and en quad around ASCII and CJK text.
+  {"\xc2\xa0" "Google\xe3\x80\x80Video\xc2\xa0", "Google\xe3\x80\x80Video",
+   "Google Video"},
+  {"\xe3\x80\x80 \xe4\xb8\xad\xe6\x96\x87 \xc2\x85", "\xe4\xb8\xad\xe6\x96\x87",
+   "\xe4\xb8\xad\xe6\x96\x87"},
+  {"a\xe2\x80\x80\t\xe2\x80\x80" "b", "a\xe2\x80\x80\t\xe2\x80\x80" "b", "a b"},
+  {"\xc2\xa0\xe3\x80\x80", "", ""},
+  // Lookalikes that are not whitespace: U+00A9, U+200B, U+3001.
+  {"\xc2\xa9 a \xe2\x80\x8b", "\xc2\xa9 a \xe2\x80\x8b",
+   "\xc2\xa9 a \xe2\x80\x8b"},
+  {"\xe3\x80\x81 \xe3\x80\x81", "\xe3\x80\x81 \xe3\x80\x81",
+   "\xe3\x80\x81 \xe3\x80\x81"},
+  // Truncated and stray bytes are kept as they are.
+  {"\xc2 a \xa0", "\xc2 a \xa0", "\xc2 a \xa0"},
+  {" \xe3\x80", "\xe3\x80", "\xe3\x80"},
+};
+
+TEST(StringUtilTest, WhitespaceUTF8)
+{
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(whitespace_cases_utf8); ++i)
+  {
+    const whitespace_case_utf8& value = whitespace_cases_utf8[i];
+    std::string output;
+    TrimWhitespace(value.input, TRIM_ALL, &output);
+    EXPECT_EQ(value.trimmed, output) << "cases:" << i + 1;
+    EXPECT_EQ(value.trimmed,
+              TrimWhitespace(StringPiece(value.input), TRIM_ALL).as_string())
+        << "cases:" << i + 1;
+    std::string in_place = value.input;
+    TrimWhitespace(&in_place, TRIM_ALL);
+    EXPECT_EQ(value.trimmed, in_place) << "cases:" << i + 1;
+
+    EXPECT_EQ(value.collapsed, CollapseWhitespace(value.input, false))
+        << "cases:" << i + 1;
+    in_place = value.input;
+    CollapseWhitespace(&in_place, false);
+    EXPECT_EQ(value.collapsed, in_place) << "cases:" << i + 1;
+  }
+
+  // The ASCII versions leave non-ASCII whitespace alone.
+  EXPECT_EQ("\xc2\xa0" "a",
+            TrimWhitespaceASCII(StringPiece(" \xc2\xa0" "a "), TRIM_ALL)
+            .as_string());
+  EXPECT_EQ("a", TrimWhitespace(StringPiece(" \xc2\xa0" "a "), TRIM_ALL)
+            .as_string());
+  EXPECT_EQ("a b", CollapseWhitespace("a\xe2\x80\xa8\r b", false));
+  EXPECT_EQ("ab", CollapseWhitespace("a\xe2\x80\xa8\r b", true));
+}
+
+TEST(StringUtilTest, WhitespaceUTF8VectorizedPaths)
+{
+  // Inputs are made of these characters, so the expected result can be built
+  // one character at a time.
+  static const struct
+  {
+    const char* utf8;
+    bool whitespace;
+  } kAlphabet[] = {
+    {" ", true},
+    {"\n", true},
+    {"\xc2\xa0", true},
+    {"\xc2\x85", true},
+    {"\xe1\x9a\x80", true},
+    {"\xe2\x80\x8a", true},
+    {"\xe3\x80\x80", true},
+    {"a", false},
+    {"\xc2\xa9", false},
+    {"\xe2\x80\x8b", false},
+    {"\xe4\xb8\xad", false},
+    {"\xf0\x9f\x98\x80", false},
+  };
+
+  srand(2014);
+  ForEachCPUFeatureMask([&](int mask) {
+    for (int round = 0; round < 500; ++round)
+    {
+      std::vector<size_t> chars;
+      const size_t length = rand() % 80;
+      while (chars.size() < length)
+        chars.insert(chars.end(), 1 + rand() % 20,
+                     rand() % ARRAYSIZE_UNSAFE(kAlphabet));
+
+      std::string input;
+      std::string collapsed;
+      size_t first = 0;
+      size_t last = chars.size();
+      bool in_whitespace = false;
+      for (size_t i = 0; i < chars.size(); ++i)
+      {
+        input += kAlphabet[chars[i]].utf8;
+        if (kAlphabet[chars[i]].whitespace)
+        {
+          in_whitespace = true;
+          continue;
+        }
+        if (in_whitespace && !collapsed.empty())
+          collapsed += ' ';
+        in_whitespace = false;
+        collapsed += kAlphabet[chars[i]].utf8;
+      }
+      while (first < last && kAlphabet[chars[first]].whitespace)
+        ++first;
+      while (last > first && kAlphabet[chars[last - 1]].whitespace)
+        --last;
+      std::string trimmed;
+      for (size_t i = first; i < last; ++i)
+        trimmed += kAlphabet[chars[i]].utf8;
+
+      EXPECT_EQ(trimmed, TrimWhitespace(StringPiece(input), TRIM_ALL)
+                .as_string()) << "mask:" << mask;
+      EXPECT_EQ(collapsed, CollapseWhitespace(input, false)) << "mask:" << mask;
+    }
+  });
+}
+
 TEST(StringUtilTest, StringToLowerASCII)
 {
   static struct test_data
@@ -213,6 +597,49 @@ TEST(StringUtilTest, StringToUpperASCII)
   }
 }
 
+TEST(StringUtilTest, CaseConversionVectorizedPaths)
+{
+  // Every byte value, at every offset of blocks of every size.
+  std::string all_bytes;
+  for (int i = 0; i < 256 * 2; ++i)
+    all_bytes += static_cast<char>(i);
+
+  ForEachCPUFeatureMask([&](int mask) {
+    for (size_t length = 0; length < 100; ++length)
+    {
+      const std::string input = all_bytes.substr(length * 3 % 256, length);
+      std::string lower = input;
+      std::string upper = input;
+      for (size_t i = 0; i < input.length(); ++i)
+      {
+        lower[i] = ToLowerASCII(input[i]);
+        upper[i] = ToUpperASCII(input[i]);
+      }
+      EXPECT_EQ(lower, StringToLowerASCII(input))
+          << "mask:" << mask << " length:" << length;
+      EXPECT_EQ(upper, StringToUpperASCII(input))
+          << "mask:" << mask << " length:" << length;
+
+      EXPECT_TRUE(EqualsCaseInsensitiveASCII(input, upper)) << "mask:" << mask;
+      EXPECT_TRUE(LowerCaseEqualsASCII(input, lower.c_str()) ||
+                  lower.find('\0') != std::string::npos) << "mask:" << mask;
+      if (length > 0)
+      {
+        // A difference in the last byte must not be missed.
+        std::string changed = upper;
+        changed[length - 1] ^= 0x01;
+        EXPECT_FALSE(EqualsCaseInsensitiveASCII(input, changed))
+            << "mask:" << mask << " length:" << length;
+        EXPECT_TRUE(EndsWith(input, upper.substr(1), false)) << "mask:" << mask;
+        EXPECT_EQ(length == 1, EndsWith(input, changed.substr(1), false))
+            << "mask:" << mask;
+        EXPECT_TRUE(StartsWithASCII(input, upper.substr(0, length - 1), false))
+            << "mask:" << mask;
+      }
+    }
+  });
+}
+
 TEST(StringUtilTest, FormatHexString)
 {
   static struct
@@ -254,7 +681,13 @@ TEST(StringUtilTest, Reverse)
     {"00 00", "", 2, "0 000"},
     {"AAABBBC", "", 3, "CBBBAAA"},
     {"AAABBBCC", "", 3, "CCBBBAAA"},
-    {"AAABBBCCC", "", 3, "CCCBBBAAA"}
+    {"AAABBBCCC", "", 3, "CCCBBBAAA"},
+    {"11223344", "", 2, "44332211"},
+    {"abc", "", 1, "cba"},
+    {"abc", "", 3, "abc"},
+    {"abc", "", 4, "abc"},
+    {"abc", "", 0, "abc"},
+    {"", "", 2, ""},
   };
 
   for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
@@ -262,9 +695,41 @@ TEST(StringUtilTest, Reverse)
     Reverse(cases[i].input, &cases[i].output, cases[i].step);
     EXPECT_EQ(cases[i].expect, cases[i].output)
         << "cases:" << i + 1;
+
+    std::string in_place = cases[i].input;
+    Reverse(in_place, &in_place, cases[i].step);
+    EXPECT_EQ(cases[i].expect, in_place) << "cases:" << i + 1;
   }
 }
 
+TEST(StringUtilTest, ReverseMatchesGroupSwap)
+{
+  srand(40);
+  ForEachCPUFeatureMask([&](int mask) {
+    for (size_t step = 1; step <= 9; ++step)
+    {
+      for (size_t length = 0; length < 150; length += 1 + rand() % 7)
+      {
+        std::string input;
+        for (size_t i = 0; i < length; ++i)
+          input += static_cast<char>('a' + rand() % 26);
+
+        // The groups, the partial one first, in reverse order.
+        std::string expect = input.substr(length - length % step);
+        for (size_t i = length - length % step; i >= step; i -= step)
+          expect += input.substr(i - step, step);
+        if (step >= length)
+          expect = input;
+
+        std::string output = input;
+        Reverse(&output, step);
+        EXPECT_EQ(expect, output)
+            << "mask:" << mask << " step:" << step << " length:" << length;
+      }
+    }
+  });
+}
+
 TEST(StringUtilTest, IpToHexString)
 {
   static struct
@@ -277,6 +742,9 @@ TEST(StringUtilTest, IpToHexString)
     {"111.111.111.111", "", "6F 6F 6F 6F", true},
     {"192.168.4.12 ", "", "C0 A8 04 0C", true},
     {"10.0.0.12 ", "", "0A 00 00 0C", true},
+    {"::1", "", "00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 01", true},
+    {"10.0.0.256", "", "", false},
+    {"dog", "", "", false},
   };
 
   for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
@@ -300,6 +768,13 @@ TEST(StringUtilTest, HexStringToIp)
     {"6F 6F 6F 6F", "", "111.111.111.111", true},
     {"C0 A8 04 0C", "", "192.168.4.12", true},
     {"0A 00 00 0C", "", "10.0.0.12", true},
+    {"0A00000C", "", "", false},
+    {"0A  00 00 0C", "", "", false},
+    {"20 01 0D B8 00 00 00 00 00 00 00 00 00 00 00 01", "", "2001:db8::1",
+     true},
+    {"0A 00 00", "", "", false},
+    {"0A 00 00 0", "", "", false},
+    {"0A 00 00 0G", "", "", false},
   };
 
   for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
@@ -310,6 +785,500 @@ TEST(StringUtilTest, HexStringToIp)
   }
 }
 
+TEST(StringUtilTest, IsIp)
+{
+  static const struct
+  {
+    const char* input;
+    bool result;
+  } cases[] = {
+    {"192.168.4.12", true},
+    {" 192.168.4.12\n", true},
+    {"C0 A8 04 0C", false},
+    {"2001:db8::1", true},
+    {"::ffff:192.168.4.12", true},
+    {"", false},
+    {"192.168.4", false},
+    {"192.168.4.12.1", false},
+    {"300.168.4.12", false},
+    {"C0 A8 04", false},
+    {"2001:db8::1::", false},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    EXPECT_EQ(cases[i].result, IsIp(cases[i].input)) << "cases:" << i + 1;
+  }
+  EXPECT_FALSE(IsIp("12345678"));
+  EXPECT_FALSE(IsIp("deadbeef"));
+}
+
+TEST(StringUtilTest, ParseMacAddress)
+{
+  static const struct
+  {
+    const char* input;
+    bool result;
+    uint64 expect;
+  } cases[] = {
+    {"11:22:33:44:55:66", true, 0x112233445566ULL},
+    {"11-22-33-44-55-66", true, 0x112233445566ULL},
+    {"11 22 33 44 55 66", true, 0x112233445566ULL},
+    {"aB:cD:eF:01:9a:F0", true, 0xABCDEF019AF0ULL},
+    {"00:00:00:00:00:00", true, 0},
+    {"ff:ff:ff:ff:ff:ff", true, 0xFFFFFFFFFFFFULL},
+    {":11:22:33:44:55:66", false, 0},
+    {"112233445566", false, 0},
+    {"11:22-33:44:55:66", false, 0},
+    {"11:22:33:44:55-66", false, 0},
+    {"11.22.33.44.55.66", false, 0},
+    {"11:22:33:44:55:6g", false, 0},
+    {"g1:22:33:44:55:66", false, 0},
+    {"11:22:33:44:55:66 ", false, 0},
+    {"11:22:3:44:55:666", false, 0},
+    {"", false, 0},
+  };
+
+  ForEachCPUFeatureMask([&](int mask) {
+    for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+    {
+      uint64 mac = 0;
+      EXPECT_EQ(cases[i].result, ParseMacAddress(cases[i].input, &mac))
+          << "mask:" << mask << " cases:" << i + 1;
+      if (cases[i].result)
+      {
+        EXPECT_EQ(cases[i].expect, mac)
+            << "mask:" << mask << " cases:" << i + 1;
+      }
+    }
+  });
+}
+
+TEST(StringUtilTest, FormatMacAddress)
+{
+  EXPECT_EQ("11:22:33:44:55:66", FormatMacAddress(0x112233445566ULL));
+  EXPECT_EQ("ab-cd-ef-01-9a-f0",
+            FormatMacAddress(0xABCDEF019AF0ULL, '-', false));
+  EXPECT_EQ("00 00 00 00 00 0A", FormatMacAddress(10, ' ', true));
+
+  // Random round trips through every separator and case.
+  static const char kSeparators[] = ":- ";
+  srand(41);
+  ForEachCPUFeatureMask([&](int mask) {
+    for (int i = 0; i < 1000; ++i)
+    {
+      const uint64 mac = ((static_cast<uint64>(rand()) << 32) ^
+                          (static_cast<uint64>(rand()) << 16) ^ rand()) &
+          0xFFFFFFFFFFFFULL;
+      const std::string text =
+          FormatMacAddress(mac, kSeparators[i % 3], i % 2 == 0);
+      uint64 parsed = 0;
+      EXPECT_TRUE(ParseMacAddress(text, &parsed))
+          << "mask:" << mask << " " << text;
+      EXPECT_EQ(mac, parsed) << "mask:" << mask << " " << text;
+    }
+  });
+}
+
+TEST(StringUtilTest, MacAddressBatch)
+{
+  const StringPiece texts[] = {
+    "11:22:33:44:55:66", "bad", "aa-bb-cc-dd-ee-ff", "11:22:33:44:55:6",
+  };
+  uint64 macs[ARRAYSIZE_UNSAFE(texts)];
+  bool valid[ARRAYSIZE_UNSAFE(texts)];
+  EXPECT_EQ(2U, ParseMacAddressBatch(texts, ARRAYSIZE_UNSAFE(texts), macs,
+                                     valid));
+  EXPECT_TRUE(valid[0]);
+  EXPECT_FALSE(valid[1]);
+  EXPECT_TRUE(valid[2]);
+  EXPECT_FALSE(valid[3]);
+  EXPECT_EQ(0x112233445566ULL, macs[0]);
+  EXPECT_EQ(0U, macs[1]);
+  EXPECT_EQ(0xAABBCCDDEEFFULL, macs[2]);
+  EXPECT_EQ(0U, macs[3]);
+
+  std::string output = "macs:";
+  FormatMacAddressBatch(macs, ARRAYSIZE_UNSAFE(macs), '-', false, '\n',
+                        &output);
+  EXPECT_EQ("macs:11-22-33-44-55-66\n00-00-00-00-00-00\n"
+            "aa-bb-cc-dd-ee-ff\n00-00-00-00-00-00\n", output);
+}
+
+TEST(StringUtilTest, IsMac)
+{
+  static const struct
+  {
+    const char* input;
+    bool result;
+  } cases[] = {
+    {"11:22:33:44:55:66", true},
+    {" 11-22-33-44-55-66\n", true},
+    {"11 22 33 44 55 66", true},
+    {":11:22:33:44:55:66", false},
+    {"112233445566", false},
+    {"c", false},
+    {"(", false},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    EXPECT_EQ(cases[i].result, IsMac(cases[i].input)) << "cases:" << i + 1;
+  }
+}
+
+TEST(StringUtilTest, MultiReplacer)
+{
+  std::vector<std::pair<std::string, std::string> > pairs;
+  pairs.push_back(std::make_pair("he", "1"));
+  pairs.push_back(std::make_pair("she", "2"));
+  pairs.push_back(std::make_pair("his", "3"));
+  pairs.push_back(std::make_pair("hers", "4"));
+  pairs.push_back(std::make_pair("", "empty"));
+  pairs.push_back(std::make_pair("he", "duplicate"));
+  MultiReplacer replacer(pairs);
+
+  static struct
+  {
+    const char* input;
+    const char* expect;
+    size_t replaced;
+  } cases [] = {
+    {"", "", 0},
+    {"xyz", "xyz", 0},
+    {"he", "1", 1},
+    {"ushers", "u2rs", 1},
+    {"hers", "4", 1},
+    {"herhis", "1r3", 2},
+    {"hishe", "31", 2},
+    {"shhe hers", "sh1 4", 2},
+    {"h", "h", 0},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    std::string output = "garbage";
+    EXPECT_EQ(cases[i].replaced, replacer.Replace(cases[i].input, &output))
+        << "cases:" << i + 1;
+    EXPECT_EQ(cases[i].expect, output) << "cases:" << i + 1;
+  }
+
+  std::string in_place = "she said hers";
+  EXPECT_EQ(2U, replacer.Replace(in_place, &in_place));
+  EXPECT_EQ("2 said 4", in_place);
+}
+
+TEST(StringUtilTest, MultiReplacerLeftmostLongest)
+{
+  std::vector<std::pair<std::string, std::string> > pairs;
+  pairs.push_back(std::make_pair("abcd", "[abcd]"));
+  pairs.push_back(std::make_pair("bc", "[bc]"));
+  pairs.push_back(std::make_pair("ab", "[ab]"));
+  pairs.push_back(std::make_pair("c", "[c]"));
+  MultiReplacer replacer(pairs);
+
+  std::string output;
+  replacer.Replace("abcd", &output);
+  EXPECT_EQ("[abcd]", output);
+  replacer.Replace("abcx", &output);
+  EXPECT_EQ("[ab][c]x", output);
+  replacer.Replace("xbcd", &output);
+  EXPECT_EQ("x[bc]d", output);
+  replacer.Replace("abcabcd", &output);
+  EXPECT_EQ("[ab][c][abcd]", output);
+}
+
+TEST(StringUtilTest, MultiReplacerStream)
+{
+  std::vector<std::pair<std::string, std::string> > pairs;
+  pairs.push_back(std::make_pair("secret", "******"));
+  pairs.push_back(std::make_pair("token=", "token=<hidden>"));
+  pairs.push_back(std::make_pair("sec", "S"));
+  MultiReplacer replacer(pairs);
+
+  const std::string input =
+      "a secret and a token=abc, sec, secre, secret!token=";
+  std::string expect;
+  const size_t replaced = replacer.Replace(input, &expect);
+  EXPECT_EQ("a ****** and a token=<hidden>abc, S, Sre, ******!token=<hidden>",
+            expect);
+
+  // Every chunk size must give the same output as the one shot rewrite.
+  for (size_t chunk = 1; chunk <= input.length(); ++chunk)
+  {
+    MultiReplacer::Stream stream(&replacer);
+    std::string output;
+    size_t stream_replaced = 0;
+    for (size_t pos = 0; pos < input.length(); pos += chunk)
+      stream_replaced += stream.Append(input.substr(pos, chunk), &output);
+    stream_replaced += stream.Finish(&output);
+    EXPECT_EQ(expect, output) << "chunk:" << chunk;
+    EXPECT_EQ(replaced, stream_replaced) << "chunk:" << chunk;
+  }
+}
+
+TEST(StringUtilTest, EscapeC)
+{
+  static const struct
+  {
+    const char* input;
+    const char* output;
+  } cases[] = {
+    {"", ""},
+    {"plain text", "plain text"},
+    {"a\nb\tc\r", "a\\nb\\tc\\r"},
+    {"say \"hi\" it's \\", "say \\\"hi\\\" it\\'s \\\\"},
+    {"\x01\x7f", "\\001\\177"},
+    {"caf\xc3\xa9", "caf\\303\\251"},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    std::string output("prefix:");
+    EscapeC(cases[i].input, &output);
+    EXPECT_EQ(std::string("prefix:") + cases[i].output, output)
+        << "cases:" << i + 1;
+  }
+
+  // Octal escapes are always three digits long.
+  std::string output;
+  EscapeC(StringPiece("\0" "1", 2), &output);
+  EXPECT_EQ("\\0001", output);
+
+  // An empty StringPiece has no data.
+  output = "prefix:";
+  EscapeC(StringPiece(), &output);
+  EXPECT_EQ("prefix:", output);
+}
+
+TEST(StringUtilTest, UnescapeC)
+{
+  static const struct
+  {
+    const char* input;
+    const char* output;
+    bool success;
+  } cases[] = {
+    {"", "", true},
+    {"plain text", "plain text", true},
+    {"a\\nb\\tc\\r", "a\nb\tc\r", true},
+    {"\\a\\b\\f\\v\\?\\'\\\"\\\\", "\a\b\f\v?'\"\\", true},
+    {"\\101\\60\\7z", "A0\az", true},
+    {"\\1011", "A1", true},
+    {"\\x41\\x4a\\x7g", "AJ\ag", true},
+    {"\\377", "\xff", true},
+    {"\\400", "", false},
+    {"\\x", "", false},
+    {"\\xg", "", false},
+    {"\\q", "", false},
+    {"trailing\\", "", false},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    std::string output("prefix:");
+    EXPECT_EQ(cases[i].success, UnescapeC(cases[i].input, &output))
+        << "cases:" << i + 1;
+    if (cases[i].success)
+    {
+      EXPECT_EQ(std::string("prefix:") + cases[i].output, output)
+          << "cases:" << i + 1;
+    }
+    else
+    {
+      EXPECT_EQ("prefix:", output) << "cases:" << i + 1;
+    }
+  }
+
+  std::string output;
+  EXPECT_TRUE(UnescapeC("a\\000b", &output));
+  EXPECT_EQ(std::string("a\0b", 3), output);
+
+  // An empty StringPiece has no data.
+  output = "prefix:";
+  EXPECT_TRUE(UnescapeC(StringPiece(), &output));
+  EXPECT_EQ("prefix:", output);
+}
+
+TEST(StringUtilTest, EscapeJSONString)
+{
+  static const struct
+  {
+    const char* input;
+    const char* output;
+  } cases[] = {
+    {"", ""},
+    {"plain text", "plain text"},
+    {"\"quoted\" back\\slash /", "\\\"quoted\\\" back\\\\slash /"},
+    {"\b\f\n\r\t", "\\b\\f\\n\\r\\t"},
+    {"\x01\x1f\x7f", "\\u0001\\u001F\x7f"},
+    {"caf\xc3\xa9 \xe2\x82\xac", "caf\xc3\xa9 \xe2\x82\xac"},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    std::string output("prefix:");
+    EscapeJSONString(cases[i].input, &output);
+    EXPECT_EQ(std::string("prefix:") + cases[i].output, output)
+        << "cases:" << i + 1;
+  }
+
+  // An empty StringPiece has no data.
+  std::string output("prefix:");
+  EscapeJSONString(StringPiece(), &output);
+  EXPECT_EQ("prefix:", output);
+}
+
+TEST(StringUtilTest, UnescapeJSONString)
+{
+  static const struct
+  {
+    const char* input;
+    const char* output;
+    bool success;
+  } cases[] = {
+    {"", "", true},
+    {"plain text", "plain text", true},
+    {"\\\"\\\\\\/\\b\\f\\n\\r\\t", "\"\\/\b\f\n\r\t", true},
+    {"\\u0041\\u00e9\\u20AC", "A\xc3\xa9\xe2\x82\xac", true},
+    {"\\ud83d\\ude00!", "\xf0\x9f\x98\x80!", true},
+    {"\\ud83d", "", false},
+    {"\\ud83d\\u0041", "", false},
+    {"\\ude00", "", false},
+    {"\\u12", "", false},
+    {"\\u12g4", "", false},
+    {"\\a", "", false},
+    {"trailing\\", "", false},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    std::string output("prefix:");
+    EXPECT_EQ(cases[i].success, UnescapeJSONString(cases[i].input, &output))
+        << "cases:" << i + 1;
+    if (cases[i].success)
+    {
+      EXPECT_EQ(std::string("prefix:") + cases[i].output, output)
+          << "cases:" << i + 1;
+    }
+    else
+    {
+      EXPECT_EQ("prefix:", output) << "cases:" << i + 1;
+    }
+  }
+
+  // An empty StringPiece has no data.
+  std::string output("prefix:");
+  EXPECT_TRUE(UnescapeJSONString(StringPiece(), &output));
+  EXPECT_EQ("prefix:", output);
+}
+
+TEST(StringUtilTest, EscapePercent)
+{
+  static const struct
+  {
+    const char* input;
+    bool space_as_plus;
+    const char* output;
+  } cases[] = {
+    {"", false, ""},
+    {"AZaz09-._~", false, "AZaz09-._~"},
+    {"a b&c=d/e", false, "a%20b%26c%3Dd%2Fe"},
+    {"a b+c", true, "a+b%2Bc"},
+    {"caf\xc3\xa9", false, "caf%C3%A9"},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    std::string output("prefix:");
+    EscapePercent(cases[i].input, &output, cases[i].space_as_plus);
+    EXPECT_EQ(std::string("prefix:") + cases[i].output, output)
+        << "cases:" << i + 1;
+  }
+
+  // An empty StringPiece has no data.
+  std::string output("prefix:");
+  EscapePercent(StringPiece(), &output, false);
+  EXPECT_EQ("prefix:", output);
+}
+
+TEST(StringUtilTest, UnescapePercent)
+{
+  static const struct
+  {
+    const char* input;
+    bool plus_as_space;
+    const char* output;
+  } cases[] = {
+    {"", false, ""},
+    {"plain", false, "plain"},
+    {"a%20b%26c%3dd", false, "a b&c=d"},
+    {"a+b%2B", false, "a+b+"},
+    {"a+b%2B", true, "a b+"},
+    {"caf%C3%A9", false, "caf\xc3\xa9"},
+    // Invalid sequences are kept.
+    {"100%", false, "100%"},
+    {"%4", false, "%4"},
+    {"%zz%%41", false, "%zz%A"},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    std::string output("prefix:");
+    UnescapePercent(cases[i].input, &output, cases[i].plus_as_space);
+    EXPECT_EQ(std::string("prefix:") + cases[i].output, output)
+        << "cases:" << i + 1;
+
+    std::string in_place(cases[i].input);
+    in_place.resize(UnescapePercentInPlace(&in_place[0], in_place.size(),
+                                           cases[i].plus_as_space));
+    EXPECT_EQ(cases[i].output, in_place) << "cases:" << i + 1;
+  }
+
+  // An empty StringPiece has no data.
+  std::string output("prefix:");
+  UnescapePercent(StringPiece(), &output, false);
+  EXPECT_EQ("prefix:", output);
+  EXPECT_EQ(0u, UnescapePercentInPlace(NULL, 0, false));
+}
+
+TEST(StringUtilTest, EscapeRoundTrip)
+{
+  // Mostly plain text, so that the long unescaped runs are exercised: seven
+  // letters in eight, and any byte value otherwise.
+  std::string alphabet;
+  for (int c = 0; c < 256; ++c)
+    alphabet += static_cast<char>(c);
+  for (int i = 0; i < 64; ++i)
+    alphabet += "abcdefghijklmnopqrstuvwxyz";
+
+  srand(37);
+  ForEachCPUFeatureMask([&](int mask) {
+    for (int round = 0; round < 200; ++round)
+    {
+      const std::string input = RandomString(alphabet, 299);
+
+      std::string escaped;
+      std::string unescaped;
+      EscapeC(input, &escaped);
+      EXPECT_TRUE(UnescapeC(escaped, &unescaped)) << "mask:" << mask;
+      EXPECT_EQ(input, unescaped) << "mask:" << mask;
+
+      escaped.clear();
+      unescaped.clear();
+      EscapeJSONString(input, &escaped);
+      EXPECT_TRUE(UnescapeJSONString(escaped, &unescaped)) << "mask:" << mask;
+      EXPECT_EQ(input, unescaped) << "mask:" << mask;
+
+      escaped.clear();
+      unescaped.clear();
+      EscapePercent(input, &escaped, round % 2 == 0);
+      UnescapePercent(escaped, &unescaped, round % 2 == 0);
+      EXPECT_EQ(input, unescaped) << "mask:" << mask;
+    }
+  });
+}
+
 // ------------------------------------------------------------
 // --------------------- Update End -------------------------
 // ------------------------------------------------------------
@@ -439,6 +1408,24 @@ TEST(StringUtilTest, ContainsOnlyWhitespaceASCII)
   }  
 }
 
+TEST(StringUtilTest, IsStringASCII)
+{
+  EXPECT_TRUE(IsStringASCII(""));
+  EXPECT_TRUE(IsStringASCII("i love dog"));
+  EXPECT_TRUE(IsStringASCII(std::string(100, '\x7f')));
+  EXPECT_FALSE(IsStringASCII("\x80"));
+  EXPECT_FALSE(IsStringASCII("heart: \xe2\x99\xa0"));
+
+  // Put the non-ASCII byte at every position of a string long enough to
+  // cover both the vectorized body and the scalar tail.
+  for (size_t i = 0; i < 40; ++i)
+  {
+    std::string input(40, 'a');
+    input[i] = '\xc3';
+    EXPECT_FALSE(IsStringASCII(input)) << "position:" << i;
+  }
+}
+
 TEST(StringUtilTest, ContainsOnlyChars)
 {
   // Providing an empty list of characters should return false but for the empty
@@ -451,6 +1438,55 @@ TEST(StringUtilTest, ContainsOnlyChars)
   EXPECT_TRUE(ContainsOnlyChars("1", "4321"));
   EXPECT_TRUE(ContainsOnlyChars("123", "4321"));
   EXPECT_FALSE(ContainsOnlyChars("123a", "4321"));
+
+  static constexpr CharSet kDigits("0123456789");
+  EXPECT_TRUE(ContainsOnlyChars("", kDigits));
+  EXPECT_TRUE(ContainsOnlyChars("20140427", kDigits));
+  EXPECT_FALSE(ContainsOnlyChars("2014-04-27", kDigits));
+  EXPECT_FALSE(ContainsOnlyChars("2014", CharSet()));
+}
+
+TEST(StringUtilTest, TrimStringCharSet)
+{
+  static const struct
+  {
+    const char* input;
+    const char* trim_chars;
+    const char* output;
+    bool trimmed;
+  } cases[] = {
+    {"", "ab", "", false},
+    {"abba", "ab", "", true},
+    {"abcba", "ab", "c", true},
+    {"cab", "ab", "c", true},
+    {"c", "ab", "c", false},
+    {"\xff\xfex\xff", "\xfe\xff", "x", true},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    std::string output;
+    EXPECT_EQ(cases[i].trimmed,
+              TrimString(cases[i].input, CharSet(cases[i].trim_chars),
+                         &output)) << "cases:" << i + 1;
+    EXPECT_EQ(cases[i].output, output) << "cases:" << i + 1;
+
+    output = cases[i].input;
+    EXPECT_EQ(cases[i].trimmed,
+              TrimString(output, cases[i].trim_chars, &output))
+        << "cases:" << i + 1;
+    EXPECT_EQ(cases[i].output, output) << "cases:" << i + 1;
+
+    EXPECT_EQ(cases[i].output,
+              TrimString(StringPiece(cases[i].input),
+                         CharSet(cases[i].trim_chars)))
+        << "cases:" << i + 1;
+  }
+
+  const CharSet ab("ab");
+  EXPECT_EQ("cab", TrimString(StringPiece("abcab"), ab, TRIM_LEADING));
+  EXPECT_EQ("abc", TrimString(StringPiece("abcab"), ab, TRIM_TRAILING));
+  EXPECT_EQ("abcab", TrimString(StringPiece("abcab"), ab, TRIM_NONE));
 }
 
 TEST(StringUtilTest, LowerCaseEqualsASCII)
@@ -470,6 +1506,30 @@ TEST(StringUtilTest, LowerCaseEqualsASCII)
     EXPECT_TRUE(LowerCaseEqualsASCII(lowercase_cases[i].src_a,
                                      lowercase_cases[i].dst));
   }
+
+  EXPECT_TRUE(LowerCaseEqualsASCII("", ""));
+  EXPECT_FALSE(LowerCaseEqualsASCII("FoO", "fo"));
+  EXPECT_FALSE(LowerCaseEqualsASCII("Fo", "foo"));
+  EXPECT_FALSE(LowerCaseEqualsASCII("FOO", "FOO"));
+
+  const std::string header = "Accept-Encoding: GZIP";
+  EXPECT_TRUE(LowerCaseEqualsASCII(header.begin(), header.begin() + 15,
+                                   "accept-encoding"));
+  EXPECT_TRUE(LowerCaseEqualsASCII(header.begin(), header.begin(), ""));
+  EXPECT_TRUE(LowerCaseEqualsASCII(header.data() + 17,
+                                   header.data() + header.size(), "gzip"));
+}
+
+TEST(StringUtilTest, EqualsCaseInsensitiveASCII)
+{
+  EXPECT_TRUE(EqualsCaseInsensitiveASCII("", ""));
+  EXPECT_TRUE(EqualsCaseInsensitiveASCII("Content-Type", "content-type"));
+  EXPECT_TRUE(EqualsCaseInsensitiveASCII("CONTENT-TYPE", "content-type"));
+  EXPECT_FALSE(EqualsCaseInsensitiveASCII("Content-Type", "Content-Typ"));
+  EXPECT_FALSE(EqualsCaseInsensitiveASCII("Content-Type", "Content_Type"));
+  // Only ASCII letters are folded.
+  EXPECT_FALSE(EqualsCaseInsensitiveASCII("@", "`"));
+  EXPECT_FALSE(EqualsCaseInsensitiveASCII("\xc3\x89", "\xc3\xa9"));
 }
 
 TEST(StringUtilTest, StartsWith)
@@ -507,6 +1567,152 @@ TEST(StringUtilTest, EndsWith)
   EXPECT_TRUE(EndsWith("", "", true));
 }
 
+// The read-only functions take StringPieces, which need not end with a NUL:
+// every call below sees a slice of |buffer| and must not look past it.
+TEST(StringUtilTest, StringPieceSlices)
+{
+  const char buffer[] = "Foo.Plugin*x?y  \xff";
+  const StringPiece name(buffer, 10);      // "Foo.Plugin"
+  const StringPiece pattern(buffer + 10, 5);  // "*x?y "
+
+  EXPECT_TRUE(StartsWithASCII(name, "foo", false));
+  EXPECT_FALSE(StartsWithASCII(name, StringPiece(buffer, 11), true));
+  EXPECT_TRUE(EndsWith(name, ".plugin", false));
+  EXPECT_FALSE(EndsWith(name, "Plugin*", true));
+  EXPECT_TRUE(LowerCaseEqualsASCII(name, "foo.plugin"));
+  EXPECT_TRUE(IsStringASCII(name));
+  EXPECT_TRUE(ContainsOnlyChars(StringPiece(buffer + 1, 2), "o"));
+  EXPECT_TRUE(ContainsOnlyWhitespaceASCII(StringPiece(buffer + 14, 2)));
+  EXPECT_TRUE(MatchPattern("abxzy", StringPiece(pattern.data(), 4)));
+  EXPECT_FALSE(MatchPattern("abxzy", pattern));
+
+  std::vector<std::string> tokens;
+  EXPECT_EQ(2U, Tokenize(name, StringPiece(buffer + 3, 1), &tokens));
+  EXPECT_EQ("Foo", tokens[0]);
+  EXPECT_EQ("Plugin", tokens[1]);
+}
+
+TEST(StringUtilTest, Find)
+{
+  const std::string text = "GET /index.html HTTP/1.1\r\nHost: example.com\r\n";
+  EXPECT_EQ(0U, Find(text, "GET", 0, true));
+  EXPECT_EQ(4U, Find(text, "/index", 0, true));
+  EXPECT_EQ(24U, Find(text, "\r\n", 0, true));
+  EXPECT_EQ(43U, Find(text, "\r\n", 25, true));
+  EXPECT_EQ(StringPiece::npos, Find(text, "host", 0, true));
+  EXPECT_EQ(26U, Find(text, "host", 0, false));
+  EXPECT_EQ(32U, Find(text, "EXAMPLE.COM", 0, false));
+  EXPECT_EQ(StringPiece::npos, Find(text, "EXAMPLE.COM", 33, false));
+
+  EXPECT_EQ(0U, Find("", "", 0, true));
+  EXPECT_EQ(3U, Find("abc", "", 3, true));
+  EXPECT_EQ(StringPiece::npos, Find("abc", "", 4, true));
+  EXPECT_EQ(StringPiece::npos, Find("ab", "abc", 0, true));
+  EXPECT_EQ(StringPiece::npos, Find("abc", "c", 5, false));
+
+  // Only ASCII letters are folded.
+  EXPECT_EQ(StringPiece::npos, Find("a@b", "a`b", 0, false));
+  EXPECT_EQ(StringPiece::npos, Find("[x", "{x", 0, false));
+
+  EXPECT_TRUE(Contains(text, "HTTP/1.1", true));
+  EXPECT_TRUE(Contains(text, "http/1.1", false));
+  EXPECT_FALSE(Contains(text, "http/1.1", true));
+
+  std::vector<size_t> positions;
+  EXPECT_EQ(2U, FindAll(text, "\r\n", true, &positions));
+  ASSERT_EQ(2U, positions.size());
+  EXPECT_EQ(24U, positions[0]);
+  EXPECT_EQ(43U, positions[1]);
+
+  // Occurrences do not overlap.
+  EXPECT_EQ(2U, FindAll("aaaaa", "aa", true, &positions));
+  EXPECT_EQ(0U, FindAll("aaaaa", "", true, &positions));
+  EXPECT_EQ(3U, FindAll("aAa", "A", false, &positions));
+}
+
+TEST(StringUtilTest, StringSearcher)
+{
+  const std::string long_search =
+      "0123456789abcdefghijklmnopqrstuvwxyz0123456789";
+  const std::string text = "prefix " + long_search + " middle " +
+      StringToUpperASCII(long_search) + " suffix";
+
+  StringSearcher exact(long_search, true);
+  EXPECT_EQ(7U, exact.Find(text, 0));
+  EXPECT_EQ(StringPiece::npos, exact.Find(text, 8));
+  EXPECT_TRUE(exact.Contains(text));
+  EXPECT_EQ(long_search, exact.search());
+
+  StringSearcher folded(StringToUpperASCII(long_search), false);
+  EXPECT_EQ(long_search, folded.search());
+  std::vector<size_t> positions;
+  EXPECT_EQ(2U, folded.FindAll(text, &positions));
+  ASSERT_EQ(2U, positions.size());
+  EXPECT_EQ(7U, positions[0]);
+  EXPECT_EQ(7U + long_search.length() + 8, positions[1]);
+  size_t offsets[1];
+  EXPECT_EQ(1U, folded.FindAll(text, 8, offsets, 1));
+  EXPECT_EQ(positions[1], offsets[0]);
+  EXPECT_EQ(0U, folded.FindAll(text, positions[1] + 1, offsets, 1));
+
+  StringSearcher short_search("Middle", false);
+  EXPECT_EQ(text.find("middle"), short_search.Find(text, 0));
+  EXPECT_FALSE(StringSearcher("Middle", true).Contains(text));
+}
+
+TEST(StringUtilTest, FindMatchesStdFind)
+{
+  srand(31);
+  ForEachCPUFeatureMask([&](int mask) {
+    for (int round = 0; round < 300; ++round)
+    {
+      // A tiny alphabet so that candidates and partial matches are frequent.
+      const std::string text =
+          RandomString(StringPiece("abAB", (round % 2) ? 4 : 2), 199);
+      const std::string search =
+          "ab"[round % 2] + RandomString("ab", (round % 3) ? 3 : 39);
+
+      const std::string lower_text = StringToLowerASCII(text);
+      const StringSearcher exact(search, true);
+      const StringSearcher folded(StringToUpperASCII(search), false);
+      for (size_t pos = 0; pos < text.length(); pos += 1 + rand() % 20)
+      {
+        EXPECT_EQ(text.find(search, pos), Find(text, search, pos, true))
+            << "mask:" << mask;
+        EXPECT_EQ(text.find(search, pos), exact.Find(text, pos))
+            << "mask:" << mask;
+        EXPECT_EQ(lower_text.find(search, pos),
+                  Find(text, StringToUpperASCII(search), pos, false))
+            << "mask:" << mask;
+        EXPECT_EQ(lower_text.find(search, pos), folded.Find(text, pos))
+            << "mask:" << mask;
+      }
+
+      // Every non-overlapping match, at once and in batches of three.
+      std::vector<size_t> expect;
+      for (size_t pos = lower_text.find(search); pos != std::string::npos;
+           pos = lower_text.find(search, pos + search.length()))
+        expect.push_back(pos);
+      std::vector<size_t> positions;
+      folded.FindAll(text, &positions);
+      EXPECT_EQ(expect, positions) << "mask:" << mask;
+      FindAll(text, search, false, &positions);
+      EXPECT_EQ(expect, positions) << "mask:" << mask;
+      positions.clear();
+      size_t offsets[3];
+      size_t count;
+      do
+      {
+        const size_t pos =
+            positions.empty() ? 0 : positions.back() + search.length();
+        count = folded.FindAll(text, pos, offsets, 3);
+        positions.insert(positions.end(), offsets, offsets + count);
+      } while (count == 3);
+      EXPECT_EQ(expect, positions) << "mask:" << mask;
+    }
+  });
+}
+
 // Test for Tokenize
 template <typename STR>
 void TokenizeTest()
@@ -602,11 +1808,165 @@ void TokenizeTest()
   r.clear();
 }
 
+// Textbook dynamic programming Levenshtein distance.
+static size_t ReferenceEditDistance(const std::string& a, const std::string& b)
+{
+  std::vector<size_t> row(b.length() + 1);
+  for (size_t j = 0; j <= b.length(); ++j)
+    row[j] = j;
+  for (size_t i = 1; i <= a.length(); ++i)
+  {
+    size_t diagonal = row[0];
+    row[0] = i;
+    for (size_t j = 1; j <= b.length(); ++j)
+    {
+      const size_t substitute = diagonal + (a[i - 1] != b[j - 1]);
+      diagonal = row[j];
+      row[j] = std::min(substitute, std::min(row[j], row[j - 1]) + 1);
+    }
+  }
+  return row[b.length()];
+}
+
+TEST(StringUtilTest, EditDistance)
+{
+  static const struct
+  {
+    const char* a;
+    const char* b;
+    size_t distance;
+  } cases[] = {
+    {"", "", 0},
+    {"", "abc", 3},
+    {"abc", "", 3},
+    {"abc", "abc", 0},
+    {"kitten", "sitting", 3},
+    {"flaw", "lawn", 2},
+    {"connection refused", "connection reset", 3},
+    {"\xff\x80", "\x80\xff", 2},
+  };
+
+  for (size_t i = 0; i < ARRAYSIZE_UNSAFE(cases); ++i)
+  {
+    EXPECT_EQ(cases[i].distance, EditDistance(cases[i].a, cases[i].b))
+        << "cases:" << i + 1;
+    EXPECT_EQ(cases[i].distance, EditDistance(cases[i].b, cases[i].a))
+        << "cases:" << i + 1;
+  }
+
+  EXPECT_EQ(3U, BoundedEditDistance("kitten", "sitting", 3));
+  EXPECT_EQ(3U, BoundedEditDistance("kitten", "sitting", 2));
+  EXPECT_EQ(1U, BoundedEditDistance("kitten", "sitting", 0));
+  EXPECT_EQ(1U, BoundedEditDistance("a", "abcdef", 0));
+  EXPECT_EQ(6U, BoundedEditDistance("", "abcdefgh", 5));
+}
+
+TEST(StringUtilTest, EditDistanceMatchesReference)
+{
+  srand(2014);
+  for (int round = 0; round < 300; ++round)
+  {
+    // Lengths across several 64-row blocks, small alphabets so that the
+    // strings are close.
+    const int alphabet = 2 + rand() % 4;
+    const std::string a = RandomString(StringPiece("abcde", alphabet), 199);
+    std::string b = a;
+    const int edits = rand() % 20;
+    for (int e = 0; e < edits; ++e)
+    {
+      const size_t pos = b.empty() ? 0 : rand() % b.length();
+      switch (rand() % 3)
+      {
+        case 0:
+          b.insert(pos, 1, static_cast<char>('a' + rand() % alphabet));
+          break;
+        case 1:
+          if (!b.empty())
+            b.erase(pos, 1);
+          break;
+        default:
+          if (!b.empty())
+            b[pos] = static_cast<char>('a' + rand() % alphabet);
+          break;
+      }
+    }
+
+    const size_t expect = ReferenceEditDistance(a, b);
+    EXPECT_EQ(expect, EditDistance(a, b)) << a << " " << b;
+    EXPECT_EQ(expect, EditDistance(b, a)) << a << " " << b;
+    const size_t bound = rand() % 20;
+    EXPECT_EQ(std::min(expect, bound + 1), BoundedEditDistance(a, b, bound))
+        << a << " " << b << " " << bound;
+  }
+}
+
+TEST(StringUtilTest, FindWithinEditDistance)
+{
+  std::vector<std::string> candidates;
+  candidates.push_back("connection reset by peer");
+  candidates.push_back("connection refused");
+  candidates.push_back("timeout");
+  candidates.push_back("connection reset by peer.");
+  std::vector<size_t> matches;
+  EXPECT_EQ(2U, FindWithinEditDistance("connection reset by peer!",
+                                       candidates, 1, &matches));
+  ASSERT_EQ(2U, matches.size());
+  EXPECT_EQ(0U, matches[0]);
+  EXPECT_EQ(3U, matches[1]);
+
+  // Enough candidates to be split across threads; the result must not
+  // depend on how many.
+  srand(2014);
+  candidates.clear();
+  for (int i = 0; i < 20000; ++i)
+  {
+    std::string candidate = "error 1234 in module";
+    candidate[rand() % candidate.length()] = static_cast<char>('0' + rand() % 10);
+    candidate[rand() % candidate.length()] = static_cast<char>('0' + rand() % 10);
+    candidates.push_back(candidate);
+  }
+  std::vector<size_t> expect;
+  for (size_t i = 0; i < candidates.size(); ++i)
+  {
+    if (ReferenceEditDistance("error 1234 in module", candidates[i]) <= 1)
+      expect.push_back(i);
+  }
+  ASSERT_FALSE(expect.empty());
+  static const size_t kThreads[] = { 1, 3, 0 };
+  for (size_t t = 0; t < ARRAYSIZE_UNSAFE(kThreads); ++t)
+  {
+    EXPECT_EQ(expect.size(),
+              FindWithinEditDistance("error 1234 in module", candidates, 1,
+                                     &matches, kThreads[t]));
+    EXPECT_EQ(expect, matches) << "threads:" << kThreads[t];
+  }
+}
+
 TEST(StringUtilTest, TokenizeStdString)
 {
   TokenizeTest<std::string>();
 }
 
+TEST(StringUtilTest, TokenizeStringPiece)
+{
+  TokenizeTest<StringPiece>();
+}
+
+TEST(StringUtilTest, TokenizeCharSet)
+{
+  static constexpr CharSet kDelimiters(",; ");
+  std::vector<std::string> r;
+  EXPECT_EQ(3U, Tokenize(" a,,b ;c;", kDelimiters, &r));
+  ASSERT_EQ(3U, r.size());
+  EXPECT_EQ("a", r[0]);
+  EXPECT_EQ("b", r[1]);
+  EXPECT_EQ("c", r[2]);
+
+  EXPECT_EQ(0U, Tokenize(";; ,", kDelimiters, &r));
+  EXPECT_EQ(1U, Tokenize("abc", CharSet(), &r));
+  EXPECT_EQ("abc", r[0]);
+}
+
 // Test for JoinString
 TEST(StringUtilTest, JoinString)
 {
@@ -624,6 +1984,18 @@ TEST(StringUtilTest, JoinString)
   EXPECT_EQ("a,b,c,", JoinString(in, ','));
   in.push_back(" ");
   EXPECT_EQ("a|b|c|| ", JoinString(in, '|'));
+
+  EXPECT_EQ("a, b, c, ,  ", JoinString(in, ", "));
+  EXPECT_EQ("abc ", JoinString(in, StringPiece()));
+  EXPECT_EQ("", JoinString(std::vector<std::string>(), ", "));
+
+  std::vector<StringPiece> pieces(in.begin(), in.begin() + 3);
+  EXPECT_EQ("a::b::c", JoinString(pieces, "::"));
+
+  static const char* const kWords[] = { "x", "", "yz" };
+  EXPECT_EQ("x--yz", JoinString(kWords, kWords + arraysize(kWords), "-"));
+  EXPECT_EQ("x", JoinString(kWords, kWords + 1, "-"));
+  EXPECT_EQ("", JoinString(kWords, kWords, "-"));
 }
 
 TEST(StringUtilTest, MatchPatternTest)
@@ -666,6 +2038,19 @@ TEST(StringUtilTest, MatchPatternTest)
   EXPECT_TRUE(MatchPattern("('aa bb', 'cc dd')", "(*,*)"));
   EXPECT_TRUE(MatchPattern("('aa bb', 'cc dd')", "(*,*)"));
   EXPECT_TRUE(MatchPattern("('aa bb')", "('*')"));
+
+  // ASCII pattern against a UTF-8 string and the other way around: ? must
+  // still consume a whole multi-byte character.
+  EXPECT_TRUE(MatchPattern("caf\xc3\xa9", "caf?"));
+  EXPECT_FALSE(MatchPattern("caf\xc3\xa9", "caf??x"));
+  EXPECT_TRUE(MatchPattern("\xf0\x9f\x98\x80 smile", "? smile"));
+  EXPECT_TRUE(MatchPattern("\xe4\xb8\xad\xe6\x96\x87", "\xe4\xb8\xad?"));
+  EXPECT_FALSE(MatchPattern("cafe", "caf\xc3\xa9"));
+
+  // Truncated and overlong sequences are invalid characters.
+  EXPECT_TRUE(MatchPattern("abc\xe2\x99", "abc?"));
+  EXPECT_FALSE(MatchPattern("\xc0\xaf", "\xc0\xaf"));
+  EXPECT_FALSE(MatchPattern("\xed\xa0\x80", "\xed\xa0\x80"));
 }
 
 
@@ -0,0 +1,124 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/sys_byteorder.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "util/cpu.h"
+
+#if defined(HAVE_TARGET_ATTRIBUTE)
+#include <immintrin.h>
+#endif
+
+namespace util
+{
+
+template <typename T>
+static void ByteSwapElements(char* p, char* end)
+{
+  for (; end - p >= static_cast<ptrdiff_t>(sizeof(T)); p += sizeof(T))
+  {
+    T value;
+    memcpy(&value, p, sizeof(T));
+    value = ByteSwap(value);
+    memcpy(p, &value, sizeof(T));
+  }
+}
+
+#if defined(HAVE_TARGET_ATTRIBUTE)
+// PSHUFB masks reversing the bytes of each 2, 4 or 8-byte element of a 16
+// byte block.
+static const uint8 kByteSwapMasks[3][16] = {
+  { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 },
+  { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+  { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 },
+};
+
+// The block kernels swap the whole 16 (32) byte blocks at the front of
+// [p, end) and return where the caller has to carry on.
+TARGET_SSE42
+static char* ByteSwapSSE42(char* p, char* end, const uint8* mask_bytes)
+{
+  const __m128i mask =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask_bytes));
+  for (; end - p >= 16; p += 16)
+  {
+    __m128i* block = reinterpret_cast<__m128i*>(p);
+    _mm_storeu_si128(block,
+                     _mm_shuffle_epi8(_mm_loadu_si128(block), mask));
+  }
+  return p;
+}
+
+TARGET_AVX2
+static char* ByteSwapAVX2(char* p, char* end, const uint8* mask_bytes)
+{
+  const __m256i mask = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask_bytes)));
+  for (; end - p >= 32; p += 32)
+  {
+    __m256i* block = reinterpret_cast<__m256i*>(p);
+    _mm256_storeu_si256(block,
+                        _mm256_shuffle_epi8(_mm256_loadu_si256(block), mask));
+  }
+  return p;
+}
+#endif
+
+void
+ByteSwapBuffer(void* data, size_t size, size_t element_size)
+{
+  char* p = static_cast<char*>(data);
+  char* const end = p + size - size % std::max<size_t>(element_size, 1);
+
+#if defined(HAVE_TARGET_ATTRIBUTE)
+  // 16 is a multiple of the element size, so the blocks hold whole elements.
+  const int mask = element_size == 2 ? 0 : element_size == 4 ? 1 :
+      element_size == 8 ? 2 : -1;
+  if (mask >= 0)
+  {
+    if (CPUHasAVX2())
+      p = ByteSwapAVX2(p, end, kByteSwapMasks[mask]);
+    if (CPUHasSSE42())
+      p = ByteSwapSSE42(p, end, kByteSwapMasks[mask]);
+  }
+#endif
+
+  switch (element_size)
+  {
+    case 0:
+    case 1:
+      break;
+    case 2:
+      ByteSwapElements<uint16>(p, end);
+      break;
+    case 4:
+      ByteSwapElements<uint32>(p, end);
+      break;
+    case 8:
+      ByteSwapElements<uint64>(p, end);
+      break;
+    default:
+      for (; p != end; p += element_size)
+        std::reverse(p, p + element_size);
+      break;
+  }
+}
+
+}; // namespace util
@@ -0,0 +1,75 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+#include "util/sys_byteorder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "util/cpu.h"
+#include "third_party/gtest/include/gtest/gtest.h"
+
+namespace util
+{
+
+TEST(SysByteorderTest, ByteSwap)
+{
+  EXPECT_EQ(0x2211u, ByteSwap(static_cast<uint16>(0x1122)));
+  EXPECT_EQ(0x44332211u, ByteSwap(static_cast<uint32>(0x11223344)));
+  EXPECT_EQ(GG_UINT64_C(0x8877665544332211),
+            ByteSwap(GG_UINT64_C(0x1122334455667788)));
+
+  const uint8 bytes[] = { 0x11, 0x22, 0x33, 0x44 };
+  uint32 net;
+  memcpy(&net, bytes, sizeof(net));
+  EXPECT_EQ(0x11223344u, NetToHost32(net));
+  EXPECT_EQ(net, HostToNet32(0x11223344));
+  EXPECT_EQ(0x1122u, NetToHost16(HostToNet16(0x1122)));
+  EXPECT_EQ(GG_UINT64_C(0x1122334455667788),
+            NetToHost64(HostToNet64(GG_UINT64_C(0x1122334455667788))));
+}
+
+TEST(SysByteorderTest, ByteSwapBuffer)
+{
+  srand(40);
+  ForEachCPUFeatureMask([&](int mask) {
+    for (size_t element_size = 0; element_size <= 9; ++element_size)
+    {
+      for (size_t size = 0; size < 150; size += 1 + rand() % 7)
+      {
+        // One byte of offset, so that the buffer is misaligned.
+        std::vector<uint8> buffer(size + 1);
+        for (size_t i = 0; i < buffer.size(); ++i)
+          buffer[i] = static_cast<uint8>(rand());
+
+        std::vector<uint8> expect(buffer);
+        for (size_t i = 1; element_size > 1 && i + element_size <= size + 1;
+             i += element_size)
+          std::reverse(expect.begin() + i, expect.begin() + i + element_size);
+
+        ByteSwapBuffer(&buffer[1], size, element_size);
+        EXPECT_TRUE(expect == buffer)
+            << "mask:" << mask << " element_size:" << element_size
+            << " size:" << size;
+      }
+    }
+  });
+}
+
+}; // namespace util
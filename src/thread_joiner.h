@@ -0,0 +1,55 @@
+/******************************************************************************
+ 
+  libutil
+  
+  Author: zhaokai
+  
+  Email: loverszhao@gmail.com
+
+  Reference: chromium
+
+  Description:
+
+  Version: 1.0
+
+******************************************************************************/
+
+// Internal to libutil: shared by the sources that start threads.
+
+#ifndef UTIL_THREAD_JOINER_H_
+#define UTIL_THREAD_JOINER_H_
+
+#include <stddef.h>
+
+#include <thread>
+#include <vector>
+
+#include "util/basictypes.h"
+
+namespace util
+{
+  // Joins the threads of |threads| when it goes out of scope, so that none
+  // is left joinable when starting a later one throws std::system_error.
+  class ThreadJoiner
+  {
+ public:
+    explicit ThreadJoiner(std::vector<std::thread>* threads)
+        : threads_(threads)
+    {
+    }
+
+    ~ThreadJoiner()
+    {
+      for (size_t t = 0; t < threads_->size(); ++t)
+        (*threads_)[t].join();
+    }
+
+ private:
+    std::vector<std::thread>* threads_;
+
+    DISALLOW_COPY_AND_ASSIGN(ThreadJoiner);
+  };
+
+}; // namespace util
+
+#endif // UTIL_THREAD_JOINER_H_